@@ -0,0 +1,282 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+
+#include "Assert.h"
+#include "Types.h"
+#include "FileStream.h"
+#include "EntityIO.h"
+
+using namespace std;
+
+namespace Tools {
+
+// This collects how often each vertex is visited (and how many arcs are scanned at it) in each
+// phase of an algorithm. Threads count into their own arrays, which are merged when the profile is
+// evaluated. The profile can be written to a compact file, which reordering or caching decisions
+// can read back, and summarized by concentration, hottest vertices, and cache line reuse.
+class AccessProfile {
+
+public:
+
+	// Magic number of profile files.
+	static const uint32_t FileMagic = 0x46525041;
+
+	// Construct an empty profile (to be read from a file).
+	AccessProfile() : numVertices(0), numThreads(1) {}
+
+	// Construct a profile for the vertices of a graph, with counters for numt threads.
+	template<typename graphType>
+	AccessProfile(const graphType &graph, const int32_t numt = 1) :
+		numVertices(graph.NumVertices()),
+		numThreads(max<int32_t>(numt, 1)),
+		firstArcId(graph.NumVertices() + 1, 0)
+	{
+		for (int d = 0; d < 2; ++d)
+			degree[d].resize(numVertices, 0);
+		for (uint32_t u = 0; u < numVertices; ++u) {
+			firstArcId[u] = graph.Vertices()[u].FirstArcId();
+			for (auto a = graph.Vertices()[u].FirstArcId(); a < graph.Vertices()[u + 1].FirstArcId(); ++a) {
+				if (graph.Arcs()[a].Forward()) ++degree[Types::FORWARD_DIRECTION][u];
+				if (graph.Arcs()[a].Backward()) ++degree[Types::BACKWARD_DIRECTION][u];
+			}
+		}
+		firstArcId[numVertices] = graph.Vertices()[numVertices].FirstArcId();
+	}
+
+	// Returns the phase with this name, registering it if necessary. Visits in the phase scan the
+	// arcs of the given direction.
+	inline uint16_t Phase(const string name, const Types::Direction direction) {
+		for (uint16_t p = 0; p < phaseNames.size(); ++p)
+			if (phaseNames[p] == name) return p;
+		phaseNames.push_back(name);
+		phaseDirections.push_back(direction);
+		threadVisits.push_back(vector<vector<uint32_t>>(numThreads));
+		visits.push_back(vector<uint64_t>());
+		scans.push_back(vector<uint64_t>());
+		return static_cast<uint16_t>(phaseNames.size() - 1);
+	}
+
+	// Records a visit of vertex u by thread t in a phase.
+	inline void Visit(const int32_t t, const uint16_t phase, const uint32_t u) {
+		Assert(phase < threadVisits.size());
+		Assert(t < numThreads);
+		vector<uint32_t> &counts = threadVisits[phase][t];
+		if (counts.empty()) counts.resize(numVertices, 0);
+		++counts[u];
+	}
+
+	// Sums up the counters of all threads (a profile read from a file is merged already).
+	inline void Merge() {
+		if (degree[0].empty()) return;
+		for (uint16_t p = 0; p < phaseNames.size(); ++p) {
+			visits[p].assign(numVertices, 0);
+			scans[p].assign(numVertices, 0);
+			for (const vector<uint32_t> &counts : threadVisits[p])
+				for (uint32_t u = 0; u < counts.size(); ++u)
+					visits[p][u] += counts[u];
+			for (uint32_t u = 0; u < numVertices; ++u)
+				scans[p][u] = visits[p][u] * degree[phaseDirections[p]][u];
+		}
+	}
+
+	// Access the merged profile.
+	inline Types::SizeType NumVertices() const { return numVertices; }
+	inline uint16_t NumPhases() const { return static_cast<uint16_t>(phaseNames.size()); }
+	inline const string &PhaseName(const uint16_t phase) const { return phaseNames[phase]; }
+	inline const vector<uint64_t> &Visits(const uint16_t phase) const { return visits[phase]; }
+	inline const vector<uint64_t> &ArcScans(const uint16_t phase) const { return scans[phase]; }
+
+	// Returns the vertices ordered by decreasing number of arc scans in a phase (ties by id), which
+	// is the order a layout would place them in to keep the hot ones together.
+	inline vector<uint32_t> HotnessOrder(const uint16_t phase) const {
+		vector<uint32_t> order(numVertices);
+		for (uint32_t u = 0; u < numVertices; ++u) order[u] = u;
+		const vector<uint64_t> &s = scans[phase];
+		stable_sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) { return s[a] > s[b]; });
+		return order;
+	}
+
+	// Writes the visited vertices of each phase with their visits and arc scans.
+	bool Write(const string filename) {
+		Merge();
+		IO::FileStream file;
+		file.OpenNewForWriting(filename);
+		if (!file.IsOpen()) {
+			cerr << "ERROR: Could not open profile file '" << filename << "' for writing." << endl;
+			return false;
+		}
+		IO::WriteEntity<uint32_t>(file, FileMagic);
+		IO::WriteEntity<uint64_t>(file, numVertices);
+		IO::WriteEntity<uint16_t>(file, NumPhases());
+		for (uint16_t p = 0; p < NumPhases(); ++p) {
+			IO::WriteEntity<uint32_t>(file, static_cast<uint32_t>(phaseNames[p].size()));
+			file.WriteString(phaseNames[p]);
+			IO::WriteEntity<uint8_t>(file, static_cast<uint8_t>(phaseDirections[p]));
+			uint64_t numEntries(0);
+			for (uint32_t u = 0; u < numVertices; ++u)
+				if (visits[p][u] > 0) ++numEntries;
+			IO::WriteEntity<uint64_t>(file, numEntries);
+			for (uint32_t u = 0; u < numVertices; ++u) {
+				if (visits[p][u] == 0) continue;
+				IO::WriteEntity<uint32_t>(file, u);
+				IO::WriteEntity<uint32_t>(file, static_cast<uint32_t>(min<uint64_t>(visits[p][u], UINT32_MAX)));
+				IO::WriteEntity<uint64_t>(file, scans[p][u]);
+			}
+		}
+		file.Close();
+		return true;
+	}
+
+	// Reads a profile written by Write. The arc layout is unknown afterwards, so the summary
+	// omits the cache line estimate of the arcs. Returns false (after an error message) if the
+	// file cannot be opened, is truncated, or has vertices out of range.
+	bool Read(const string filename) {
+		IO::FileStream file;
+		file.OpenForReading(filename);
+		if (!file.IsOpen()) {
+			cerr << "ERROR: Could not open profile file '" << filename << "'." << endl;
+			return false;
+		}
+		if (IO::ReadEntity<uint32_t>(file) != FileMagic) {
+			cerr << "ERROR: '" << filename << "' is not a profile file." << endl;
+			return false;
+		}
+		numVertices = IO::ReadEntity<uint64_t>(file);
+		const uint16_t numPhases = IO::ReadEntity<uint16_t>(file);
+		phaseNames.assign(numPhases, string());
+		phaseDirections.assign(numPhases, Types::FORWARD_DIRECTION);
+		threadVisits.assign(numPhases, vector<vector<uint32_t>>(numThreads));
+		visits.assign(numPhases, vector<uint64_t>(numVertices, 0));
+		scans.assign(numPhases, vector<uint64_t>(numVertices, 0));
+		firstArcId.clear();
+		degree[Types::FORWARD_DIRECTION].clear();
+		degree[Types::BACKWARD_DIRECTION].clear();
+		for (uint16_t p = 0; p < numPhases; ++p) {
+			phaseNames[p].resize(IO::ReadEntity<uint32_t>(file));
+			file.Read(&phaseNames[p][0], phaseNames[p].size());
+			phaseDirections[p] = static_cast<Types::Direction>(IO::ReadEntity<uint8_t>(file));
+			const uint64_t numEntries = IO::ReadEntity<uint64_t>(file);
+			for (uint64_t e = 0; e < numEntries; ++e) {
+				if (file.Finished()) {
+					cerr << "ERROR: The profile file '" << filename << "' is truncated." << endl;
+					return false;
+				}
+				const uint32_t u = IO::ReadEntity<uint32_t>(file);
+				if (u >= numVertices) {
+					cerr << "ERROR: Vertex " << u << " in the profile file '" << filename << "' is out of range (" << numVertices << " vertices)." << endl;
+					return false;
+				}
+				visits[p][u] = IO::ReadEntity<uint32_t>(file);
+				scans[p][u] = IO::ReadEntity<uint64_t>(file);
+			}
+		}
+		file.Close();
+		return true;
+	}
+
+	// Prints per phase: the totals, how much of the work the hottest vertices take (concentration
+	// curve), the hottest vertices, and estimates of how often a cache line is reused. A line holds
+	// 16 vertices of 4-byte vertex data, or a part of the arc array in the current layout.
+	void DumpSummary(ostream &os, const size_t numTop = 10) {
+		Merge();
+		const ios::fmtflags flags = os.flags();
+		const streamsize precision = os.precision();
+		os << fixed << setprecision(1);
+		for (uint16_t p = 0; p < NumPhases(); ++p) {
+			const vector<uint64_t> &v = visits[p], &s = scans[p];
+			uint64_t totalVisits(0), totalScans(0), numVisited(0);
+			for (uint32_t u = 0; u < numVertices; ++u) {
+				totalVisits += v[u];
+				totalScans += s[u];
+				if (v[u] > 0) ++numVisited;
+			}
+			os << "Phase '" << phaseNames[p] << "': " << totalVisits << " visits of " << numVisited << " vertices, " << totalScans << " arc scans." << endl;
+			if (totalVisits == 0) continue;
+
+			// Concentration curve: the share of arc scans at the hottest fraction of the vertices.
+			const vector<uint32_t> order = HotnessOrder(p);
+			os << "  Share of arc scans at the hottest vertices:";
+			const double fractions[] = { 0.0001, 0.001, 0.01, 0.1, 0.5 };
+			const char *fractionNames[] = { "0.01%", "0.1%", "1%", "10%", "50%" };
+			uint64_t cumulative(0);
+			size_t j = 0;
+			for (size_t f = 0; f < 5; ++f) {
+				const size_t num = max<size_t>(1, static_cast<size_t>(fractions[f] * numVertices));
+				for (; j < num && j < order.size(); ++j) cumulative += s[order[j]];
+				os << " " << fractionNames[f] << ": " << (totalScans > 0 ? 100.0 * cumulative / totalScans : 0.0) << "%";
+			}
+			os << "." << endl;
+
+			// The hottest vertices.
+			os << "  Hottest vertices (id: visits, arc scans, degree):";
+			for (size_t i = 0; i < min(numTop, order.size()) && s[order[i]] > 0; ++i)
+				os << " " << order[i] << ": " << v[order[i]] << ", " << s[order[i]] << ", " << (visits[p][order[i]] > 0 ? s[order[i]] / v[order[i]] : 0) << ";";
+			os << endl;
+
+			// Cache line reuse of vertex data, in the current and in the hotness order.
+			uint64_t numLines(0);
+			for (uint32_t line = 0; line * 16 < numVertices; ++line) {
+				bool touched = false;
+				for (uint32_t u = line * 16; u < min<uint64_t>(numVertices, line * 16 + 16) && !touched; ++u)
+					touched = v[u] > 0;
+				if (touched) ++numLines;
+			}
+			os << "  Vertex data: " << numLines << " lines touched, " << (double(totalVisits) / numLines) << " accesses per line (" << (double(totalVisits) / ((numVisited + 15) / 16)) << " in hotness order)." << endl;
+
+			// Cache line reuse of the arcs, if the layout is known.
+			if (firstArcId.empty()) continue;
+			uint64_t lineLoads(0), distinctLines(0), lastLine(UINT64_MAX);
+			for (uint32_t u = 0; u < numVertices; ++u) {
+				if (v[u] == 0 || firstArcId[u] == firstArcId[u + 1]) continue;
+				const uint64_t firstLine = firstArcId[u] * 4 / 64, endLine = (firstArcId[u + 1] * 4 - 1) / 64 + 1;
+				lineLoads += v[u] * (endLine - firstLine);
+				distinctLines += endLine - max(firstLine, lastLine == UINT64_MAX ? firstLine : lastLine + 1);
+				lastLine = endLine - 1;
+			}
+			os << "  Arcs: " << distinctLines << " lines touched, " << (distinctLines > 0 ? double(lineLoads) / distinctLines : 0.0) << " loads per line." << endl;
+		}
+		os.flags(flags);
+		os.precision(precision);
+	}
+
+private:
+
+	// The number of vertices and of threads that count.
+	Types::SizeType numVertices;
+	int32_t numThreads;
+
+	// The degrees of the vertices per direction, and the first arc of each vertex (the arc layout).
+	vector<uint32_t> degree[2];
+	vector<uint64_t> firstArcId;
+
+	// The phases, their scan direction, and the visits per thread.
+	vector<string> phaseNames;
+	vector<Types::Direction> phaseDirections;
+	vector<vector<vector<uint32_t>>> threadVisits;
+
+	// The merged visits and arc scans per phase.
+	vector<vector<uint64_t>> visits, scans;
+};
+
+}
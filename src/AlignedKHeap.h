@@ -0,0 +1,377 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+// K-ary heap with the interface of KHeap, laid out for fast sift-downs: keys and elements are held in
+// separate arrays, the K children of a node are adjacent and start at a cache line boundary (when K
+// keys fill at least one line), and unused slots hold a sentinel key. The minimum child is then found
+// with a branch-free scan over one full group, which uses AVX2 for arity 8 and 16 (float, double and
+// uint32_t keys). Ties are broken as in KHeap, so the same operations yield the same order.
+// In addition, the heap can be built from an array in linear time, and batches of updates are
+// applied by rebuilding the heap when that is cheaper than sifting each of them.
+
+#include <limits>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+#include "BitOperations.h"
+
+namespace DataStructures {
+namespace Container {
+
+namespace AlignedKHeapDetail {
+
+// Returns the index of the first minimum of the arity keys of a group.
+template<typename keyType, int arity>
+struct MinChild {
+	static inline uint32_t Find(const keyType *keys) {
+		uint32_t best = 0;
+		for (uint32_t i = 1; i < arity; ++i)
+			if (keys[i] < keys[best]) best = i;
+		return best;
+	}
+};
+
+#if defined(__AVX2__)
+// The vectorized versions broadcast the minimum to all lanes and take the first lane equal to it.
+template<int arity>
+inline uint32_t FindMinDouble(const double *keys) {
+	__m256d m = _mm256_load_pd(keys);
+	for (int i = 4; i < arity; i += 4)
+		m = _mm256_min_pd(m, _mm256_load_pd(keys + i));
+	m = _mm256_min_pd(m, _mm256_permute2f128_pd(m, m, 1));
+	m = _mm256_min_pd(m, _mm256_permute_pd(m, 5));
+	uint32_t mask = 0;
+	for (int i = 0; i < arity; i += 4)
+		mask |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_load_pd(keys + i), m, _CMP_EQ_OQ))) << i;
+	return Tools::LowestSetBit(mask);
+}
+
+template<int arity>
+inline uint32_t FindMinFloat(const float *keys) {
+	__m256 m = _mm256_load_ps(keys);
+	for (int i = 8; i < arity; i += 8)
+		m = _mm256_min_ps(m, _mm256_load_ps(keys + i));
+	m = _mm256_min_ps(m, _mm256_permute2f128_ps(m, m, 1));
+	m = _mm256_min_ps(m, _mm256_permute_ps(m, 0x4E));
+	m = _mm256_min_ps(m, _mm256_permute_ps(m, 0xB1));
+	uint32_t mask = 0;
+	for (int i = 0; i < arity; i += 8)
+		mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_load_ps(keys + i), m, _CMP_EQ_OQ))) << i;
+	return Tools::LowestSetBit(mask);
+}
+
+template<int arity>
+inline uint32_t FindMinUnsigned(const uint32_t *keys) {
+	__m256i m = _mm256_load_si256(reinterpret_cast<const __m256i*>(keys));
+	for (int i = 8; i < arity; i += 8)
+		m = _mm256_min_epu32(m, _mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i)));
+	m = _mm256_min_epu32(m, _mm256_permute2x128_si256(m, m, 1));
+	m = _mm256_min_epu32(m, _mm256_shuffle_epi32(m, 0x4E));
+	m = _mm256_min_epu32(m, _mm256_shuffle_epi32(m, 0xB1));
+	uint32_t mask = 0;
+	for (int i = 0; i < arity; i += 8) {
+		const __m256i equal = _mm256_cmpeq_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i)), m);
+		mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(equal))) << i;
+	}
+	return Tools::LowestSetBit(mask);
+}
+
+template<> struct MinChild<double, 8> { static inline uint32_t Find(const double *keys) { return FindMinDouble<8>(keys); } };
+template<> struct MinChild<double, 16> { static inline uint32_t Find(const double *keys) { return FindMinDouble<16>(keys); } };
+template<> struct MinChild<float, 8> { static inline uint32_t Find(const float *keys) { return FindMinFloat<8>(keys); } };
+template<> struct MinChild<float, 16> { static inline uint32_t Find(const float *keys) { return FindMinFloat<16>(keys); } };
+template<> struct MinChild<uint32_t, 8> { static inline uint32_t Find(const uint32_t *keys) { return FindMinUnsigned<8>(keys); } };
+template<> struct MinChild<uint32_t, 16> { static inline uint32_t Find(const uint32_t *keys) { return FindMinUnsigned<16>(keys); } };
+#endif
+
+}
+
+
+template<typename keyType, typename elementType, int logK> class AlignedKHeap {
+public:
+
+	// Expose typedefs.
+	typedef keyType KeyType;
+	typedef elementType ElementType;
+	typedef elementType PositionType;
+
+	// Define empty position
+	static const PositionType EmptyPosition;
+
+	// Standard constructor for the heap.
+	AlignedKHeap() : keys(nullptr), numEntries(0) {}
+
+	// The heap contains ids from 0 to n-1.
+	AlignedKHeap(const Types::SizeType numberOfValues) : keys(nullptr), numEntries(0) {
+		Resize(numberOfValues);
+	}
+
+	// The keys point into keyStorage.
+	AlignedKHeap(const AlignedKHeap&) = delete;
+	AlignedKHeap &operator=(const AlignedKHeap&) = delete;
+
+
+	// Resize the heap (which must be empty).
+	// Returns true if it actually did a resize, false otherwise.
+	inline bool Resize(const Types::SizeType newSize) {
+		Assert(Empty());
+		// Room for the slots in front of the root, a partial last group of children, and the alignment.
+		keyStorage.assign(newSize + 2 * arity + lineKeys, Sentinel());
+		const uintptr_t misalignment = reinterpret_cast<uintptr_t>(keyStorage.data()) % lineBytes;
+		keys = keyStorage.data() + (misalignment == 0 ? 0 : (lineBytes - misalignment) / sizeof(keyType));
+		elements.resize(newSize + arity);
+		positions.assign(newSize, EmptyPosition);
+		return true;
+	}
+
+	// Clears the heap.
+	inline void Clear() {
+		for (Types::IndexType i = 0; i < Size(); i++) {
+			positions[elements[Slot(i)]] = EmptyPosition;
+			keys[Slot(i)] = Sentinel();
+		}
+		numEntries = 0;
+	}
+
+
+	// Get the memory footprint of the data structure.
+	inline int64_t GetMemoryFootprint() const {
+		return keyStorage.size() * sizeof(keyType) + elements.size() * sizeof(elementType) + positions.size() * sizeof(PositionType);
+	}
+
+
+	// Return the capacity of the heap.
+	inline Types::SizeType Capacity() const { return positions.size(); }
+
+	// Returns the size (number of elements) in the heap.
+	inline Types::SizeType Size() const { return numEntries; }
+
+	// Checks if the heap is empty.
+	inline bool Empty() const { return Size() == 0; }
+
+
+	// Returns the element with minimum id.
+	inline elementType DeleteMin() {
+		Assert(!Empty());
+		const elementType element = elements[Slot(0)];
+		positions[element] = EmptyPosition;
+		RemoveLast(0);
+		return element;
+	}
+
+	// Delete minimum element, but also return its key.
+	inline elementType DeleteMin(keyType &key) {
+		Assert(!Empty());
+		key = keys[Slot(0)];
+		return DeleteMin();
+	}
+
+
+	// Delete an arbitrary element from the heap.
+	inline void Delete(const elementType element) {
+		Assert(Contains(element));
+		const PositionType position = positions[element];
+		positions[element] = EmptyPosition;
+		RemoveLast(position);
+	}
+
+
+	// Determine the minimum key in the heap.
+	inline keyType MinKey() const {
+		Assert(!Empty());
+		return keys[Slot(0)];
+	}
+
+	// Get the min element.
+	inline elementType MinElement() const {
+		Assert(!Empty());
+		return elements[Slot(0)];
+	}
+
+
+	// Test if some element is in the heap.
+	inline bool Contains(const elementType element) const {
+		Assert(element < positions.size());
+		return (positions[element] != EmptyPosition);
+	}
+
+	// Retrieve the key of an element.
+	inline keyType GetKey(const elementType element) const {
+		Assert(Contains(element));
+		return keys[Slot(positions[element])];
+	}
+
+
+	// Updates an element in the heap. If it is already contained,
+	// just update its key, otherwise insert it.
+	inline void Update(const elementType element, const keyType key) {
+		Assert(element < positions.size());
+		if (positions[element] == EmptyPosition) {
+			const PositionType position = static_cast<PositionType>(numEntries++);
+			elements[Slot(position)] = element;
+			positions[element] = position;
+			SiftUp(position, key);
+		} else {
+			const PositionType position = positions[element];
+			if (keys[Slot(position)] >= key) SiftUp(position, key);
+			else SiftDown(position, key);
+		}
+	}
+
+	// Updates (or inserts) all (element, key) pairs, in order. If the batch is large compared to the
+	// heap, the keys are written first and the heap is rebuilt.
+	inline void UpdateBatch(const vector<pair<elementType, keyType>> &updates) {
+		if (updates.size() * Depth() < Size()) {
+			for (const pair<elementType, keyType> &update : updates)
+				Update(update.first, update.second);
+			return;
+		}
+		for (const pair<elementType, keyType> &update : updates) {
+			Assert(update.first < positions.size());
+			if (positions[update.first] == EmptyPosition) {
+				positions[update.first] = static_cast<PositionType>(numEntries);
+				elements[Slot(numEntries++)] = update.first;
+			}
+			keys[Slot(positions[update.first])] = update.second;
+		}
+		Heapify();
+	}
+
+	// Clears the heap and fills it with the num distinct elements and their keys, in linear time.
+	inline void Build(const elementType *newElements, const keyType *newKeys, const Types::SizeType num) {
+		Clear();
+		for (Types::IndexType i = 0; i < num; ++i) {
+			Assert(newElements[i] < positions.size());
+			Assert(positions[newElements[i]] == EmptyPosition);
+			elements[Slot(i)] = newElements[i];
+			keys[Slot(i)] = newKeys[i];
+			positions[newElements[i]] = static_cast<PositionType>(i);
+		}
+		numEntries = num;
+		Heapify();
+	}
+
+private:
+
+	// The arity, and the number of keys in a cache line.
+	static const int arity = 1 << logK;
+	static const size_t lineBytes = 64;
+	static const size_t lineKeys = lineBytes / sizeof(keyType);
+	static_assert(lineBytes % sizeof(keyType) == 0, "keys must pack into cache lines");
+
+	// The key of unused slots, which no key is smaller than.
+	static inline keyType Sentinel() {
+		return numeric_limits<keyType>::has_infinity ? numeric_limits<keyType>::infinity() : numeric_limits<keyType>::max();
+	}
+
+	// The slot of a position: the root is in slot arity-1, such that the children of position p are in
+	// the slots arity*(p+1) to arity*(p+1)+arity-1.
+	static inline Types::IndexType Slot(const Types::IndexType position) { return position + arity - 1; }
+
+	// The number of levels of the heap (at least one).
+	inline Types::SizeType Depth() const {
+		return numEntries == 0 ? 1 : Tools::HighestSetBit(numEntries) / logK + 1;
+	}
+
+	// Moves the last entry to position (whose entry has been removed) and restores the heap order.
+	inline void RemoveLast(const PositionType position) {
+		const PositionType last = static_cast<PositionType>(--numEntries);
+		const elementType element = elements[Slot(last)];
+		const keyType key = keys[Slot(last)];
+		keys[Slot(last)] = Sentinel();
+		if (position == last) return;
+		elements[Slot(position)] = element;
+		if (position > 0 && key < keys[Slot((position - 1) >> logK)]) SiftUp(position, key);
+		else SiftDown(position, key);
+	}
+
+	// Moves the element at position upwards, such that it ends up with the given key.
+	inline void SiftUp(PositionType position, const keyType key) {
+		const elementType element = elements[Slot(position)];
+		while (position) {
+			const PositionType parentPosition = (position - 1) >> logK;
+			if (!(key < keys[Slot(parentPosition)])) break;
+			Move(parentPosition, position);
+			position = parentPosition;
+		}
+		Place(position, element, key);
+	}
+
+	// Moves the element at position downwards, such that it ends up with the given key.
+	inline void SiftDown(PositionType position, const keyType key) {
+		const elementType element = elements[Slot(position)];
+		while (true) {
+			const Types::IndexType firstChild = (Types::IndexType(position) << logK) + 1;
+			if (firstChild >= numEntries) break;
+			const PositionType bestPosition = static_cast<PositionType>(firstChild + AlignedKHeapDetail::MinChild<keyType, arity>::Find(keys + Slot(firstChild)));
+			Assert(bestPosition < numEntries);
+			if (!(keys[Slot(bestPosition)] < key)) break;
+			Move(bestPosition, position);
+			position = bestPosition;
+		}
+		Place(position, element, key);
+	}
+
+	// Sifts down all inner positions, bottom up.
+	inline void Heapify() {
+		if (numEntries < 2) return;
+		for (Types::IndexType position = ((numEntries - 2) >> logK) + 1; position-- > 0;)
+			SiftDown(static_cast<PositionType>(position), keys[Slot(position)]);
+	}
+
+	// Moves the entry at position from to position to.
+	inline void Move(const PositionType from, const PositionType to) {
+		elements[Slot(to)] = elements[Slot(from)];
+		keys[Slot(to)] = keys[Slot(from)];
+		positions[elements[Slot(to)]] = to;
+	}
+
+	// Puts the entry at position.
+	inline void Place(const PositionType position, const elementType element, const keyType key) {
+		elements[Slot(position)] = element;
+		keys[Slot(position)] = key;
+		positions[element] = position;
+	}
+
+private:
+
+	// The keys of the slots, starting at a cache line in the storage.
+	keyType *keys;
+	vector<keyType> keyStorage;
+
+	// The elements of the slots.
+	vector<elementType> elements;
+
+	// The number of entries in the heap.
+	Types::SizeType numEntries;
+
+	// For each element its position in the heap.
+	vector<PositionType> positions;
+
+};
+
+template<typename keyType, typename elementType, int logK>
+const elementType AlignedKHeap<keyType, elementType, logK>::EmptyPosition = numeric_limits<elementType>::max();
+
+}
+}
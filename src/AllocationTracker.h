@@ -0,0 +1,219 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <omp.h>
+
+using namespace std;
+
+namespace Tools {
+
+// Counts the heap allocations of the process per phase and per thread (with the bytes requested),
+// to find the loops that allocate in their steady state. The counting is opt-in: it only happens
+// if the global operator new and delete below are compiled in (make ALLOCS=1, which defines
+// TRACK_ALLOCATIONS); otherwise the phases are registered, but nothing is counted. The current phase
+// is global, so an algorithm switches it where all its threads enter the next phase; the threads
+// are told apart by their OpenMP thread number.
+class AllocationTracker {
+public:
+
+	// The limits of the counters. Phase 0 collects everything outside of registered phases.
+	static const uint16_t MaxPhases = 16;
+	static const int32_t MaxThreads = 64;
+
+	// Whether allocations are counted in this build.
+	static inline bool Enabled() {
+#ifdef TRACK_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Returns the phase with this name, registering it if necessary (phase 0 when all are taken).
+	static uint16_t Phase(const string name) {
+		State &state = GetState();
+		for (uint16_t p = 1; p < state.NumPhases; ++p)
+			if (name.compare(state.Names[p]) == 0) return p;
+		if (state.NumPhases == MaxPhases) return 0;
+		strncpy(state.Names[state.NumPhases], name.c_str(), sizeof(state.Names[0]) - 1);
+		return state.NumPhases++;
+	}
+
+	// Returns the name of the current phase.
+	static inline const char *CurrentPhaseName() {
+		State &state = GetState();
+		return state.Names[state.CurrentPhase.load(memory_order_relaxed)];
+	}
+
+	// Sets the current phase, and returns the previous one.
+	static inline uint16_t SetPhase(const uint16_t phase) {
+		return GetState().CurrentPhase.exchange(phase, memory_order_relaxed);
+	}
+
+	// Sets a phase for the lifetime of the scope.
+	class Scope {
+	public:
+		Scope(const uint16_t phase) : previous(SetPhase(phase)) {}
+		~Scope() { SetPhase(previous); }
+	private:
+		uint16_t previous;
+	};
+
+	// Counts an allocation of n bytes and a free in the current phase.
+	static inline void CountAllocation(const size_t n) {
+		Counters &c = GetCounters();
+		c.NumAllocations.fetch_add(1, memory_order_relaxed);
+		c.NumBytes.fetch_add(n, memory_order_relaxed);
+	}
+	static inline void CountFree() {
+		GetCounters().NumFrees.fetch_add(1, memory_order_relaxed);
+	}
+
+	// Access the counters summed over all threads.
+	static uint64_t NumAllocations(const uint16_t phase) { return Sum(phase, &Counters::NumAllocations); }
+	static uint64_t NumFrees(const uint16_t phase) { return Sum(phase, &Counters::NumFrees); }
+	static uint64_t NumBytes(const uint16_t phase) { return Sum(phase, &Counters::NumBytes); }
+
+	// Sets all counters to zero.
+	static void Reset() {
+		State &state = GetState();
+		for (uint16_t p = 0; p < MaxPhases; ++p) {
+			for (int32_t t = 0; t < MaxThreads; ++t) {
+				state.Counts[p][t].NumAllocations = 0;
+				state.Counts[p][t].NumFrees = 0;
+				state.Counts[p][t].NumBytes = 0;
+			}
+		}
+	}
+
+	// Prints the counters of each phase with allocations, and of its busiest threads.
+	static void DumpStatistics(ostream &os) {
+		if (!Enabled()) return;
+		State &state = GetState();
+		for (uint16_t p = 0; p < state.NumPhases; ++p) {
+			if (NumAllocations(p) == 0 && NumFrees(p) == 0) continue;
+			os << "Allocations in '" << state.Names[p] << "': " << NumAllocations(p) << " (" << NumBytes(p) / 1024.0 / 1024.0 << " MiB), " << NumFrees(p) << " frees";
+			for (int32_t t = 0; t < MaxThreads; ++t) {
+				const uint64_t num = state.Counts[p][t].NumAllocations.load(memory_order_relaxed);
+				if (num > 0) os << "; thread " << t << ": " << num;
+			}
+			os << "." << endl;
+		}
+	}
+
+	// Writes the counters of each phase as statistics (key = value lines).
+	static void WriteStatistics(ostream &os) {
+		if (!Enabled()) return;
+		State &state = GetState();
+		for (uint16_t p = 0; p < state.NumPhases; ++p) {
+			string key(state.Names[p]);
+			for (char &c : key) if (c == ' ') c = '_';
+			os << "Allocations_" << key << " = " << NumAllocations(p) << endl
+				<< "AllocatedBytes_" << key << " = " << NumBytes(p) << endl
+				<< "Frees_" << key << " = " << NumFrees(p) << endl;
+		}
+	}
+
+private:
+
+	// The counters of a phase and thread.
+	struct Counters {
+		atomic<uint64_t> NumAllocations, NumFrees, NumBytes;
+	};
+
+	// The phases and their counters (zero-initialized, as it is static).
+	struct State {
+		atomic<uint16_t> CurrentPhase;
+		uint16_t NumPhases;
+		char Names[MaxPhases][32];
+		Counters Counts[MaxPhases][MaxThreads];
+	};
+
+	// The state is created on first use, which may be an allocation before main.
+	static inline State &GetState() {
+		static State state;
+		if (state.NumPhases == 0) {
+			strcpy(state.Names[0], "other");
+			state.NumPhases = 1;
+		}
+		return state;
+	}
+
+	// The counters of the current phase and thread.
+	static inline Counters &GetCounters() {
+		State &state = GetState();
+		const int32_t t = omp_get_thread_num();
+		return state.Counts[state.CurrentPhase.load(memory_order_relaxed)][t < MaxThreads ? t : MaxThreads - 1];
+	}
+
+	// Sums a counter of a phase over all threads.
+	static uint64_t Sum(const uint16_t phase, atomic<uint64_t> Counters::*counter) {
+		uint64_t sum(0);
+		for (int32_t t = 0; t < MaxThreads; ++t)
+			sum += (GetState().Counts[phase][t].*counter).load(memory_order_relaxed);
+		return sum;
+	}
+};
+
+}
+
+#ifdef TRACK_ALLOCATIONS
+// The counting replacements of the global operators. As they are defined here, this header may be
+// included by one translation unit per executable only (which is how the executables are built).
+// All forms allocate by TrackedAllocate and free by TrackedFree (malloc and free underneath). These
+// are not inlined, so the compiler never sees free on a pointer from operator new (which it flags).
+#if defined(_MSC_VER)
+#define TRACKED_NOINLINE __declspec(noinline)
+#else
+#define TRACKED_NOINLINE __attribute__((noinline))
+#endif
+static TRACKED_NOINLINE void *TrackedAllocate(const size_t n) noexcept {
+	Tools::AllocationTracker::CountAllocation(n);
+	return malloc(n > 0 ? n : 1);
+}
+static TRACKED_NOINLINE void TrackedFree(void *p) noexcept {
+	if (p == nullptr) return;
+	Tools::AllocationTracker::CountFree();
+	free(p);
+}
+void *operator new(size_t n) {
+	void *p = TrackedAllocate(n);
+	if (p == nullptr) throw bad_alloc();
+	return p;
+}
+void *operator new[](size_t n) {
+	void *p = TrackedAllocate(n);
+	if (p == nullptr) throw bad_alloc();
+	return p;
+}
+void *operator new(size_t n, const nothrow_t&) noexcept { return TrackedAllocate(n); }
+void *operator new[](size_t n, const nothrow_t&) noexcept { return TrackedAllocate(n); }
+void operator delete(void *p) noexcept { TrackedFree(p); }
+void operator delete[](void *p) noexcept { TrackedFree(p); }
+void operator delete(void *p, const nothrow_t&) noexcept { TrackedFree(p); }
+void operator delete[](void *p, const nothrow_t&) noexcept { TrackedFree(p); }
+void operator delete(void *p, size_t) noexcept { TrackedFree(p); }
+void operator delete[](void *p, size_t) noexcept { TrackedFree(p); }
+#endif
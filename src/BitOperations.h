@@ -0,0 +1,59 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace Tools {
+
+// Returns the number of bits set in a 64-bit word.
+inline uint32_t PopCount(const uint64_t x) {
+#if defined(_MSC_VER)
+	return static_cast<uint32_t>(__popcnt64(x));
+#else
+	return static_cast<uint32_t>(__builtin_popcountll(x));
+#endif
+}
+
+// Returns the index of the lowest set bit of a 64-bit word. The word must not be zero.
+inline uint32_t LowestSetBit(const uint64_t x) {
+#if defined(_MSC_VER)
+	unsigned long index(0);
+	_BitScanForward64(&index, x);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(x));
+#endif
+}
+
+// Returns the index of the highest set bit of a 64-bit word. The word must not be zero.
+inline uint32_t HighestSetBit(const uint64_t x) {
+#if defined(_MSC_VER)
+	unsigned long index(0);
+	_BitScanReverse64(&index, x);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(63 - __builtin_clzll(x));
+#endif
+}
+
+}
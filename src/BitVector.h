@@ -0,0 +1,139 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+
+namespace DataStructures {
+namespace Container {
+
+// A vector of bits, like vector<bool>, which also gives access to its 64-bit words, such that
+// sets of bits can be tested (e.g., against a bitmap) with word-wise operations. The words may
+// also live in external memory (e.g., a memory mapped file), see Attach.
+class BitVector {
+public:
+
+	// Construct an empty vector.
+	BitVector() : data(nullptr), numWords(0), numBits(0), attached(false) {}
+
+	// Construct a vector of numElements bits, all unset.
+	BitVector(const Types::SizeType numElements) : words((numElements + 63) / 64, 0), data(words.data()), numWords(words.size()), numBits(numElements), attached(false) {}
+
+	// A copy always owns its words.
+	BitVector(const BitVector &other) : words(other.data, other.data + other.numWords), data(words.data()), numWords(other.numWords), numBits(other.numBits), attached(false) {}
+	BitVector(BitVector &&other) : words(move(other.words)), data(other.attached ? other.data : words.data()), numWords(other.numWords), numBits(other.numBits), attached(other.attached) {
+		other.data = nullptr;
+		other.numWords = other.numBits = 0;
+		other.attached = false;
+	}
+	BitVector &operator=(BitVector other) {
+		words.swap(other.words);
+		swap(data, other.data);
+		swap(numWords, other.numWords);
+		swap(numBits, other.numBits);
+		swap(attached, other.attached);
+		return *this;
+	}
+
+	// Use the (numElements + 63) / 64 words at externalWords, which must outlive the vector,
+	// instead of own memory. The bits are not changed.
+	inline void Attach(uint64_t *externalWords, const Types::SizeType numElements) {
+		vector<uint64_t>().swap(words);
+		data = externalWords;
+		numWords = (numElements + 63) / 64;
+		numBits = numElements;
+		attached = true;
+	}
+
+	// Test whether the words live in external memory.
+	inline bool IsAttached() const { return attached; }
+
+	// Resize the vector. New bits are unset.
+	inline void Resize(const Types::SizeType numElements) {
+		Assert(!attached);
+		if (numElements < numBits) {
+			words.resize((numElements + 63) / 64);
+			if (numElements % 64 != 0) words.back() &= (uint64_t(1) << (numElements % 64)) - 1;
+		}
+		else {
+			words.resize((numElements + 63) / 64, 0);
+		}
+		data = words.data();
+		numWords = words.size();
+		numBits = numElements;
+	}
+
+	// Get the number of bits.
+	inline Types::SizeType Size() const { return numBits; }
+
+	// Get the number of words.
+	inline Types::SizeType NumWords() const { return numWords; }
+
+	// Get the size of the owned words in bytes (attached words are not counted).
+	inline Types::SizeType MemoryBytes() const { return words.capacity() * sizeof(uint64_t); }
+
+	// Test a bit.
+	inline bool operator[](const Types::IndexType index) const {
+		Assert(index < numBits);
+		return (data[index >> 6] >> (index & 63)) & 1;
+	}
+
+	// Set a bit.
+	inline void Set(const Types::IndexType index) {
+		Assert(index < numBits);
+		data[index >> 6] |= uint64_t(1) << (index & 63);
+	}
+
+	// Unset a bit.
+	inline void Reset(const Types::IndexType index) {
+		Assert(index < numBits);
+		data[index >> 6] &= ~(uint64_t(1) << (index & 63));
+	}
+
+	// Access the word holding bits 64*wordIndex to 64*wordIndex+63.
+	inline uint64_t Word(const Types::IndexType wordIndex) const {
+		Assert(wordIndex < numWords);
+		return data[wordIndex];
+	}
+
+	// Unset all bits.
+	inline void Clear() {
+		fill(data, data + numWords, 0);
+	}
+
+private:
+
+	// The words holding the bits (unless they are attached).
+	vector<uint64_t> words;
+
+	// The words in use: those of words or the attached ones.
+	uint64_t *data;
+	Types::SizeType numWords;
+
+	// The number of bits.
+	Types::SizeType numBits;
+
+	// Are the words external?
+	bool attached;
+};
+
+}
+}
@@ -0,0 +1,100 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+#include "Assert.h"
+
+namespace DataStructures {
+namespace Container {
+
+// A queue of bounded capacity that hands items from a producer thread to a consumer thread.
+template<typename valueType>
+class BoundedQueue {
+
+public:
+
+	// Construct the queue with room for the given number of items.
+	BoundedQueue(const size_t c = 16) : capacity(c), closed(false) {
+		Assert(capacity > 0);
+	}
+
+	// Waits for room and appends an item. Returns false if the queue has been closed.
+	inline bool Push(valueType &&item) {
+		unique_lock<mutex> lock(guard);
+		notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+		if (closed) return false;
+		items.push_back(move(item));
+		notEmpty.notify_one();
+		return true;
+	}
+
+	// Waits for an item and removes it. Returns false once the queue is closed and drained.
+	inline bool Pop(valueType &item) {
+		unique_lock<mutex> lock(guard);
+		notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+		if (items.empty()) return false;
+		item = move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+
+	// Signals that no more items will be pushed; the remaining ones can still be popped.
+	inline void Close() {
+		lock_guard<mutex> lock(guard);
+		closed = true;
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+
+	// Closes the queue and discards the remaining items, which also stops a waiting producer.
+	inline void Cancel() {
+		lock_guard<mutex> lock(guard);
+		closed = true;
+		items.clear();
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+
+	// Makes the queue usable again after it has been closed.
+	inline void Reopen() {
+		lock_guard<mutex> lock(guard);
+		closed = false;
+		items.clear();
+	}
+
+private:
+
+	// The maximum number of items in the queue.
+	const size_t capacity;
+
+	// The items, and whether the producer is done.
+	deque<valueType> items;
+	bool closed;
+
+	// Synchronization between producer and consumer.
+	mutex guard;
+	condition_variable notEmpty, notFull;
+};
+
+}
+}
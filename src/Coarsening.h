@@ -0,0 +1,143 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <omp.h>
+
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+#include "Macros.h"
+#include "FastStaticGraphs.h"
+
+namespace DataStructures {
+namespace Graphs {
+
+// Clusters the vertices of the graph by size-constrained label propagation: starting from singleton
+// clusters, every vertex moves to the most frequent cluster among its neighbors (in both directions;
+// ties keep its own cluster, or take the smallest id), unless that cluster has maxClusterSize
+// vertices already. The moves are proposed in parallel with numt threads, and applied in the order
+// of the vertex ids; to avoid oscillation, only every other vertex moves in a round. Stops after
+// numRounds rounds or when no vertex moves. The result does not depend on numt.
+// Returns the number of clusters, whose ids (0, 1, ...) are in clusters.
+template<typename graphType>
+uint32_t LabelPropagation(graphType &graph, const uint32_t numRounds, const uint32_t maxClusterSize, const int32_t numt, vector<uint32_t> &clusters, const bool verbose) {
+	const int64_t n = static_cast<int64_t>(graph.NumVertices());
+	vector<uint32_t> labels(n), proposals(n), sizes(n, 1);
+	for (int64_t u = 0; u < n; ++u) labels[u] = static_cast<uint32_t>(u);
+	vector<vector<uint32_t>> neighborLabels(numt);
+	if (verbose) cout << "Propagating labels (at most " << maxClusterSize << " vertices per cluster):" << flush;
+	for (uint32_t round = 0; round < numRounds; ++round) {
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+		for (int64_t u = round % 2; u < n; u += 2) {
+			vector<uint32_t> &L = neighborLabels[omp_get_thread_num()];
+			L.clear();
+			FORALL_INCIDENT_ARCS(graph, static_cast<uint32_t>(u), a)
+				L.push_back(labels[a->OtherVertexId()]);
+			sort(L.begin(), L.end());
+			uint32_t best = labels[u], bestCount = 0, ownCount = 0;
+			for (size_t i = 0, j = 0; i < L.size(); i = j) {
+				while (j < L.size() && L[j] == L[i]) ++j;
+				const uint32_t count = static_cast<uint32_t>(j - i);
+				if (L[i] == labels[u]) ownCount = count;
+				if (count > bestCount) {
+					best = L[i];
+					bestCount = count;
+				}
+			}
+			proposals[u] = bestCount > ownCount ? best : labels[u];
+		}
+		uint64_t numMoves = 0;
+		for (int64_t u = round % 2; u < n; u += 2) {
+			const uint32_t c = proposals[u];
+			if (c == labels[u] || sizes[c] >= maxClusterSize) continue;
+			--sizes[labels[u]];
+			++sizes[c];
+			labels[u] = c;
+			++numMoves;
+		}
+		if (verbose) cout << " " << numMoves << flush;
+		if (numMoves == 0 && round > 0) break;
+	}
+
+	// Number the clusters in the order of their first vertices.
+	const uint32_t NoCluster = UINT32_MAX;
+	vector<uint32_t> ids(n, NoCluster);
+	uint32_t numClusters = 0;
+	clusters.resize(n);
+	for (int64_t u = 0; u < n; ++u) {
+		if (ids[labels[u]] == NoCluster) ids[labels[u]] = numClusters++;
+		clusters[u] = ids[labels[u]];
+	}
+	if (verbose) cout << " done (" << numClusters << " clusters)." << endl;
+	return numClusters;
+}
+
+// Contracts the clusters of the graph (ids 0..numClusters-1) into the vertices of a coarse graph, with
+// an arc between two clusters if the graph has an arc between their vertices (parallel arcs and loops
+// are dropped). The weight of a coarse vertex is the size of its cluster. Uses numt threads.
+template<typename graphType>
+void Contract(graphType &graph, const vector<uint32_t> &clusters, const uint32_t numClusters, graphType &coarse, vector<uint32_t> &weights, const int32_t numt, const bool verbose) {
+	if (verbose) cout << "Contracting " << graph.NumVertices() << " vertices into " << numClusters << " clusters... " << flush;
+	const int64_t n = static_cast<int64_t>(graph.NumVertices());
+	weights.assign(numClusters, 0);
+	for (int64_t u = 0; u < n; ++u) ++weights[clusters[u]];
+
+	// Collect the arcs between clusters per thread, sorted and without duplicates.
+	typedef pair<uint32_t, uint32_t> arcType;
+	vector<vector<arcType>> threadArcs(numt);
+#pragma omp parallel num_threads(numt)
+	{
+		vector<arcType> &arcs = threadArcs[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 1024)
+		for (int64_t u = 0; u < n; ++u) {
+			FORALL_INCIDENT_ARCS(graph, static_cast<uint32_t>(u), a) {
+				if (!a->Forward()) continue;
+				const uint32_t cu = clusters[u], cv = clusters[a->OtherVertexId()];
+				if (cu != cv) arcs.push_back(arcType(cu, cv));
+			}
+		}
+		sort(arcs.begin(), arcs.end());
+		arcs.erase(unique(arcs.begin(), arcs.end()), arcs.end());
+	}
+	vector<arcType> arcs;
+	for (vector<arcType> &a : threadArcs) {
+		arcs.insert(arcs.end(), a.begin(), a.end());
+		vector<arcType>().swap(a);
+	}
+	sort(arcs.begin(), arcs.end());
+	arcs.erase(unique(arcs.begin(), arcs.end()), arcs.end());
+	if (verbose) cout << "done (" << arcs.size() << " arcs)." << endl;
+
+	// The identifier depends on the clustering: an FNV-1a style hash over the cluster ids of the vertices,
+	// since different clusterings may well have the same number of clusters and arcs.
+	uint64_t hash = 14695981039346656037ULL;
+	for (int64_t u = 0; u < n; ++u) {
+		hash ^= clusters[u];
+		hash *= 1099511628211ULL;
+	}
+	string identifier = graph.GetIdentifier();
+	if (identifier.compare(0, 7, "fgraph/") == 0) identifier = identifier.substr(7);
+	coarse.BuildFromArcList(identifier + "/contracted/" + to_string(numClusters) + "/" + to_string(arcs.size()) + "/" + to_string(hash), numClusters, arcs, true, true, true, verbose);
+}
+
+}
+}
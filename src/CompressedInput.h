@@ -0,0 +1,344 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <omp.h>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "Assert.h"
+#include "BoundedQueue.h"
+
+using namespace std;
+
+namespace IO {
+
+enum CompressionType { NO_COMPRESSION, GZIP_COMPRESSION, ZSTD_COMPRESSION };
+
+// Determines the compression of a file from its magic bytes, or from its extension if it is too short.
+inline CompressionType DetectCompression(const string filename) {
+	ifstream file(filename.c_str(), ios::binary | ios::in);
+	unsigned char magic[4] = { 0, 0, 0, 0 };
+	file.read(reinterpret_cast<char*>(magic), 4);
+	const streamsize numBytes = file.gcount();
+	if (numBytes >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		return GZIP_COMPRESSION;
+	if (numBytes >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+		return ZSTD_COMPRESSION;
+	if (numBytes < 4) {
+		const auto HasExtension = [&](const string extension) {
+			return filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+		};
+		if (HasExtension(".gz")) return GZIP_COMPRESSION;
+		if (HasExtension(".zst")) return ZSTD_COMPRESSION;
+	}
+	return NO_COMPRESSION;
+}
+
+
+// Decompresses a file on a separate thread into blocks of bounded size, which are handed to the
+// reader through a bounded queue. Multi-frame zstd files are decompressed in parallel batches.
+class CompressedInput {
+
+public:
+
+	// A block of decompressed data, and the number of compressed bytes consumed up to its end.
+	struct BlockType {
+		vector<char> Data;
+		streamsize CompressedBytes = 0;
+	};
+
+	// Construct with the number of blocks that can be buffered ahead of the reader.
+	CompressedInput(const size_t queueCapacity = 16) :
+		blocks(queueCapacity),
+		blockSize(0),
+		numThreads(1),
+		failed(false)
+	{}
+
+	// Stop decompressing, if we are destroyed.
+	~CompressedInput() {
+		Close();
+	}
+
+	// Indicates whether decompressing this type is supported by this build.
+	static inline bool Supported(const CompressionType type) {
+		(void)type; // unused without decompressors.
+#ifdef WITH_ZLIB
+		if (type == GZIP_COMPRESSION) return true;
+#endif
+#ifdef WITH_ZSTD
+		if (type == ZSTD_COMPRESSION) return true;
+#endif
+		return false;
+	}
+
+	// Opens the file and starts decompressing it into blocks of at most bs bytes.
+	inline bool Open(const string filename, const CompressionType type, const size_t bs, const int32_t numt = omp_get_max_threads()) {
+		Close();
+		if (!Supported(type)) return false;
+		file.open(filename.c_str(), ios::binary | ios::in);
+		if (!file.is_open()) return false;
+		blockSize = bs;
+		numThreads = max<int32_t>(numt, 1);
+		failed = false;
+		blocks.Reopen();
+		if (type == GZIP_COMPRESSION)
+			decoder = thread(&CompressedInput::DecodeGzip, this);
+		else
+			decoder = thread(&CompressedInput::DecodeZstd, this);
+		return true;
+	}
+
+	// Waits for the next block. Returns false at the end of the data.
+	inline bool NextBlock(BlockType &block) {
+		return blocks.Pop(block);
+	}
+
+	// Stops the decompression thread and closes the file.
+	inline void Close() {
+		blocks.Cancel();
+		if (decoder.joinable()) decoder.join();
+		if (file.is_open()) file.close();
+	}
+
+	// Indicates whether the file turned out to be corrupt or truncated.
+	inline bool Failed() const {
+		return failed;
+	}
+
+private:
+
+	// The size of the chunks read from the compressed file.
+	static const size_t InputChunkSize = 1 << 20;
+
+	// Frames that decompress to at most this many bytes are batched for parallel decompression.
+	static const size_t MaxBatchedFrameSize = 64 << 20;
+
+	// Report an error from the decompression thread.
+	inline void Fail(const string message) {
+		cerr << "ERROR: " << message << endl;
+		failed = true;
+	}
+
+	// Appends decompressed data to the current block, handing full blocks to the reader.
+	// Returns false if the reader has stopped.
+	inline bool Emit(BlockType &block, const char *data, size_t numBytes, const streamsize compressedBytes) {
+		while (numBytes > 0) {
+			const size_t numCopied = min(numBytes, blockSize - block.Data.size());
+			block.Data.insert(block.Data.end(), data, data + numCopied);
+			data += numCopied;
+			numBytes -= numCopied;
+			if (block.Data.size() == blockSize && !Flush(block, compressedBytes))
+				return false;
+		}
+		return true;
+	}
+
+	// Hands the current block to the reader, if it is not empty.
+	inline bool Flush(BlockType &block, const streamsize compressedBytes) {
+		if (block.Data.empty()) return true;
+		block.CompressedBytes = compressedBytes;
+		const bool accepted = blocks.Push(move(block));
+		block = BlockType();
+		block.Data.reserve(blockSize);
+		return accepted;
+	}
+
+	// Decompresses (possibly concatenated) gzip members.
+	inline void DecodeGzip() {
+#ifdef WITH_ZLIB
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+			Fail("Could not initialize zlib.");
+			blocks.Close();
+			return;
+		}
+		vector<char> in(InputChunkSize), out(blockSize);
+		BlockType block;
+		block.Data.reserve(blockSize);
+		streamsize compressedBytes = 0;
+		bool inMember = false, running = true, needInput = true;
+		while (running) {
+			// Only read more once inflate has no pending output left.
+			if (stream.avail_in == 0 && needInput) {
+				file.read(in.data(), in.size());
+				const streamsize numBytes = file.gcount();
+				if (numBytes == 0) break;
+				compressedBytes += numBytes;
+				stream.next_in = reinterpret_cast<Bytef*>(in.data());
+				stream.avail_in = static_cast<uInt>(numBytes);
+			}
+			stream.next_out = reinterpret_cast<Bytef*>(out.data());
+			stream.avail_out = static_cast<uInt>(out.size());
+			const uInt numAvailable = stream.avail_in;
+			const int result = inflate(&stream, Z_NO_FLUSH);
+			if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+				Fail("Input file is corrupt (zlib: " + string(stream.msg != nullptr ? stream.msg : "unknown error") + ").");
+				inMember = false;
+				break;
+			}
+			if (result == Z_STREAM_END) inMember = false;
+			else if (stream.avail_in != numAvailable) inMember = true;
+			needInput = result == Z_STREAM_END || stream.avail_out != 0;
+			running = Emit(block, out.data(), out.size() - stream.avail_out, compressedBytes);
+			// Another member may follow.
+			if (result == Z_STREAM_END)
+				inflateReset(&stream);
+		}
+		if (inMember && running)
+			Fail("Input file is truncated.");
+		if (running)
+			Flush(block, compressedBytes);
+		inflateEnd(&stream);
+#endif
+		blocks.Close();
+	}
+
+	// Decompresses zstd frames. Consecutive small frames are decompressed in parallel batches,
+	// whereas large frames or frames without a content size are streamed.
+	inline void DecodeZstd() {
+#ifdef WITH_ZSTD
+		vector<char> in; // the window of compressed data read ahead.
+		size_t pos = 0; // the first byte of the window that has not been decompressed.
+		streamsize compressedBytes = 0; // the number of bytes read from the file.
+		BlockType block;
+		block.Data.reserve(blockSize);
+
+		// Reads another chunk into the window, dropping the consumed prefix.
+		const auto Refill = [&]() -> bool {
+			in.erase(in.begin(), in.begin() + pos);
+			pos = 0;
+			const size_t oldSize = in.size();
+			in.resize(oldSize + InputChunkSize);
+			file.read(in.data() + oldSize, InputChunkSize);
+			const streamsize numBytes = file.gcount();
+			in.resize(oldSize + static_cast<size_t>(numBytes));
+			compressedBytes += numBytes;
+			return numBytes > 0;
+		};
+
+		vector<pair<size_t, size_t>> frames;
+		vector<vector<char>> outputs;
+		bool running = true;
+		while (running) {
+			if (pos == in.size() && !Refill()) break;
+
+			// Collect complete frames with known and moderate content size.
+			frames.clear();
+			bool streamFrame = false;
+			while (frames.size() < static_cast<size_t>(4 * numThreads) && pos < in.size()) {
+				const size_t frameSize = ZSTD_findFrameCompressedSize(in.data() + pos, in.size() - pos);
+				if (ZSTD_isError(frameSize)) {
+					// Incomplete frame: decompress the batch first, or read more of it.
+					if (!frames.empty()) break;
+					if (in.size() - pos < MaxBatchedFrameSize && Refill()) continue;
+					streamFrame = true;
+					break;
+				}
+				const unsigned long long contentSize = ZSTD_getFrameContentSize(in.data() + pos, frameSize);
+				if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize > MaxBatchedFrameSize) {
+					streamFrame = frames.empty();
+					break;
+				}
+				frames.push_back(make_pair(pos, frameSize));
+				pos += frameSize;
+			}
+
+			// Decompress the batch in parallel, and hand it over in order.
+			if (!frames.empty()) {
+				outputs.resize(frames.size());
+				bool corrupt = false;
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+				for (int32_t f = 0; f < static_cast<int32_t>(frames.size()); ++f) {
+					const char *src = in.data() + frames[f].first;
+					outputs[f].resize(static_cast<size_t>(ZSTD_getFrameContentSize(src, frames[f].second)));
+					const size_t result = ZSTD_decompress(outputs[f].data(), outputs[f].size(), src, frames[f].second);
+					if (ZSTD_isError(result) || result != outputs[f].size()) {
+#pragma omp critical
+						corrupt = true;
+					}
+				}
+				if (corrupt) {
+					Fail("Input file is corrupt (zstd).");
+					break;
+				}
+				for (size_t f = 0; running && f < frames.size(); ++f)
+					running = Emit(block, outputs[f].data(), outputs[f].size(), compressedBytes);
+			}
+
+			// Stream the next frame.
+			if (streamFrame && running) {
+				ZSTD_DCtx *context = ZSTD_createDCtx();
+				vector<char> out(blockSize);
+				size_t result = 1;
+				while (running && result != 0) {
+					if (pos == in.size() && !Refill()) {
+						Fail("Input file is truncated.");
+						running = false;
+						break;
+					}
+					ZSTD_inBuffer input = { in.data() + pos, in.size() - pos, 0 };
+					ZSTD_outBuffer output = { out.data(), out.size(), 0 };
+					result = ZSTD_decompressStream(context, &output, &input);
+					if (ZSTD_isError(result)) {
+						Fail("Input file is corrupt (zstd: " + string(ZSTD_getErrorName(result)) + ").");
+						running = false;
+						break;
+					}
+					pos += input.pos;
+					running = Emit(block, out.data(), output.pos, compressedBytes);
+				}
+				ZSTD_freeDCtx(context);
+			}
+		}
+		if (running && !failed)
+			Flush(block, compressedBytes);
+#endif
+		blocks.Close();
+	}
+
+	// The compressed file, read by the decompression thread only.
+	ifstream file;
+
+	// The decompression thread and the blocks it produced.
+	thread decoder;
+	DataStructures::Container::BoundedQueue<BlockType> blocks;
+
+	// The maximum size of a block.
+	size_t blockSize;
+
+	// The number of threads for decompressing zstd frames.
+	int32_t numThreads;
+
+	// Indicates whether decompression failed.
+	atomic<bool> failed;
+};
+
+}
@@ -31,9 +31,10 @@ using namespace std;
 namespace RawData {
 
 
-// Build a metis graph directly into a fast unweighted graph.
+// Build a dimacs graph directly into a fast unweighted graph.
+// Returns false (after an error message) if the file cannot be read completely.
 template<typename graphType>
-void BuildDimacsGraph(const string inFilename, graphType &outGraph, const bool ignoreSelfLoops, const bool transpose, const bool directed, const bool buildIncomingArcs, const bool removeParallelArcs, const bool verbose) {
+bool BuildDimacsGraph(const string inFilename, graphType &outGraph, const bool ignoreSelfLoops, const bool transpose, const bool directed, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool removeParallelArcs, const bool verbose) {
 	typedef typename graphType::VertexIdType vertexIdType;
 
 	// Get the file size of the input filestream.
@@ -42,6 +43,10 @@ void BuildDimacsGraph(const string inFilename, graphType &outGraph, const bool i
 	// Open the input file as a stream.
 	IO::FileStream inStream;
 	inStream.OpenForReading(inFilename);
+	if (!inStream.IsOpen()) {
+		cerr << "ERROR: Could not open '" << inFilename << "'." << endl;
+		return false;
+	}
 
 	// Create timer and progress bar.
 	if (verbose) cout << "Streaming from " << inFilename << " (" << (fileSize / 1024.0 / 1024.0) << " MiB): " << endl;
@@ -122,6 +127,11 @@ void BuildDimacsGraph(const string inFilename, graphType &outGraph, const bool i
 		}
 	}
 
+	if (inStream.Failed()) {
+		cerr << "ERROR: Could not read all of '" << inFilename << "'." << endl;
+		return false;
+	}
+
 	if (verbose) cout << arcs.size() << " of " << expectedNumArcs << " expected arcs parsed; " << numSelfLoopsIgnored << " selfloops ignored." << endl;
 
 	// Remove parallel arcs?
@@ -143,13 +153,14 @@ void BuildDimacsGraph(const string inFilename, graphType &outGraph, const bool i
 	const string identifier = Platform::SharedMemoryManager::GetIdentifierFromFilename(inFilename);
 
 	// Build the graph.
-	outGraph.BuildFromArcList(identifier, numVertices, arcs, directed, buildIncomingArcs, verbose);
+	outGraph.BuildFromArcList(identifier, numVertices, arcs, directed, buildIncomingArcs, buildOutgoingArcs, verbose);
+	return true;
 }
 
 
-// Stream a graph.
+// Stream a graph. Returns false (after an error message) if the file cannot be read completely.
 template<typename graphType>
-void StreamDimacsGraph(const string inFilename, const string outFilename, const bool ignoreSelfLoops, const bool undirected, const bool transpose, const bool verbose) {
+bool StreamDimacsGraph(const string inFilename, const string outFilename, const bool ignoreSelfLoops, const bool undirected, const bool transpose, const bool verbose) {
 	// Get the file size of the input filestream.
 	Types::SizeType fileSize = IO::FileSize(inFilename);
 
@@ -159,6 +170,10 @@ void StreamDimacsGraph(const string inFilename, const string outFilename, const
 	// Open the input file as a stream.
 	IO::FileStream inStream;
 	inStream.OpenForReading(inFilename);
+	if (!inStream.IsOpen()) {
+		cerr << "ERROR: Could not open '" << inFilename << "'." << endl;
+		return false;
+	}
 
 	// Create a new graph stream.
 	graphStreamType outStream;
@@ -248,6 +263,11 @@ void StreamDimacsGraph(const string inFilename, const string outFilename, const
 		}
 	}
 
+	if (inStream.Failed()) {
+		cerr << "ERROR: Could not read all of '" << inFilename << "'." << endl;
+		return false;
+	}
+
 	if (verbose) cout << numArcs << " of " << expectedNumArcs << " expected arcs parsed; " << numSelfLoopsIgnored << " selfloops ignored." << endl;
 
 	// Close graph stream.
@@ -255,6 +275,7 @@ void StreamDimacsGraph(const string inFilename, const string outFilename, const
 
 	// Dump statistics.
 	if (verbose) outStream.DumpStatistics(cout);
+	return true;
 }
 
 
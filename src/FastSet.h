@@ -22,6 +22,7 @@ using namespace std;
 
 #include "Assert.h"
 #include "Types.h"
+#include "BitVector.h"
 
 namespace DataStructures {
 namespace Container {
@@ -38,12 +39,12 @@ public:
 	FastSet() {}
 
 	// Construct the map with a predefined number of key-elements.
-	FastSet(const Types::SizeType numElements) : isContained(numElements, false) {}
+	FastSet(const Types::SizeType numElements) : isContained(numElements) {}
 
 	// Resize the set. It has to grow.
 	inline void Resize(const Types::SizeType numElements) {
 		Assert(numElements >= Size());
-		isContained.resize(numElements, false);
+		isContained.Resize(numElements);
 	}
 
 	// Get the size of the set, i.e., the number of keys that are contained.
@@ -66,15 +67,20 @@ public:
 	// Test whether a certain key is contained in the set.
 	inline bool IsContained(const keyType &key) const {
 		Assert(key >= 0);
-		Assert(key < isContained.size());
+		Assert(key < isContained.Size());
 		return isContained[key];
 	}
 
+	// Get the membership bits of the keys 64*wordIndex to 64*wordIndex+63.
+	inline uint64_t ContainedWord(const Types::IndexType wordIndex) const {
+		return isContained.Word(wordIndex);
+	}
+
 
 	// Insert an element into the set.
 	inline void Insert(const keyType &key) {
 		Assert(key >= 0);
-		Assert(key < isContained.size());
+		Assert(key < isContained.Size());
 
 		// If the keyType is too big, resize the set.
 		//if (key >= isContained.size())
@@ -86,7 +92,7 @@ public:
 		}
 
 		// Set the value for key.
-		isContained[key] = true;
+		isContained.Set(key);
 	}
 
 	// Insert from another fast set.
@@ -100,7 +106,7 @@ public:
 		Assert(index >= 0);
 		Assert(index < containedKeys.size());
 		Assert(isContained[containedKeys[index]]);
-		isContained[containedKeys[index]] = false;
+		isContained.Reset(containedKeys[index]);
 		keyType key = containedKeys[index];
 		swap(containedKeys.back(), containedKeys[index]);
 		containedKeys.pop_back();
@@ -111,7 +117,7 @@ public:
 	inline keyType DeleteBack() {
 		Assert(containedKeys.size() > 0);
 		keyType key = containedKeys.back();
-		isContained[key] = false;
+		isContained.Reset(key);
 		containedKeys.pop_back();
 		return key;
 	}
@@ -120,7 +126,7 @@ public:
 	// Clear this set.
 	inline void Clear() {
 		for (keyType key : containedKeys) {
-			isContained[key] = false;
+			isContained.Reset(key);
 		}
 		containedKeys.clear();
 	}
@@ -130,10 +136,15 @@ public:
 		return containedKeys;
 	}
 
+	// Get the size of the flags and the keys in bytes.
+	inline Types::SizeType MemoryBytes() const {
+		return isContained.MemoryBytes() + containedKeys.capacity() * sizeof(keyType);
+	}
+
 private:
 
 	// This vector maps keys to a bool value indicating whether the key is in the set.
-	vector<bool> isContained;
+	BitVector isContained;
 
 	// This vector is dynamic, and it is a collection of the
 	// keys that are contained in the set. This is required
@@ -21,6 +21,8 @@ THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <fstream>
 #include <algorithm>
 #include <string>
+#include <atomic>
+#include <omp.h>
 
 #include "Types.h"
 #include "FastVertex.h"
@@ -67,12 +69,12 @@ public:
 	FastStaticGraph() : header(nullptr), vertices(nullptr), arcs(nullptr) {}
 
 	// Construct the graph by immediately reading it.
-	FastStaticGraph(const string filename, const bool buildIncomingArcs, const bool verbose, const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) :
+	FastStaticGraph(const string filename, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool verbose, const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) :
 		header(nullptr),
 		vertices(nullptr),
 		arcs(nullptr)
 	{
-		Read(filename, buildIncomingArcs, verbose, preferredNumaNode);
+		Read(filename, buildIncomingArcs, buildOutgoingArcs, verbose, preferredNumaNode);
 	}
 
 
@@ -123,16 +125,32 @@ public:
 	// Get the identifier of this static graph.
 	inline string GetIdentifier() const { return identifier; }
 
+	// Exchange the graph with another one.
+	inline void Swap(ThisType &other) {
+		swap(identifier, other.identifier);
+		swap(identifierHeader, other.identifierHeader);
+		swap(identifierVertices, other.identifierVertices);
+		swap(identifierArcs, other.identifierArcs);
+		swap(header, other.header);
+		swap(vertices, other.vertices);
+		swap(arcs, other.arcs);
+	}
+
+
+	// The in-memory transforms of a loaded graph.
+	enum TransformType { TRANSPOSE, SYMMETRIZE, DROP_BACKWARD, ADD_BACKWARD };
+
 
 	// Allocates (shared) memory for a graph with n vertices and m arcs.
 	// The identifier is used to share the graph between different processes.
+	// If buildOutgoingArcs is false, only the reverse adjacency is built (requires buildIncomingArcs).
 	template<typename containerType>
-	inline void BuildFromArcList(const string id, const VertexIdType numVertices, const containerType &inArcs, const bool directed, const bool buildIncomingArcs, const bool verbose, const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) {
+	inline void BuildFromArcList(const string id, const VertexIdType numVertices, const containerType &inArcs, const bool directed, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool verbose, const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) {
 		// Unload whatever we have in memory.
 		Detach();
 
 		// Create identifiers.
-		identifier = "fgraph/" + id + "/" + (buildIncomingArcs ? "bi" : "uni");
+		identifier = "fgraph/" + id + "/" + GetArcModeIdentifier(buildIncomingArcs, buildOutgoingArcs);
 		identifierHeader = identifier + "/header";
 		identifierVertices = identifier + "/vertices";
 		identifierArcs = identifier + "/arcs";
@@ -143,7 +161,7 @@ public:
 			Attach(verbose, preferredNumaNode);
 		}
 		else {
-			ReadFromArcList(numVertices, inArcs, directed, buildIncomingArcs, verbose, preferredNumaNode);
+			ReadFromArcList(numVertices, inArcs, directed, buildIncomingArcs, buildOutgoingArcs, verbose, preferredNumaNode);
 		}
 
 		// Perform a consistency check.
@@ -157,13 +175,14 @@ public:
 
 
 	// Read the graph fully into memory from disk.
-	inline void Read(const string filename, const bool buildIncomingArcs, const bool verbose, const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) {
+	// If buildOutgoingArcs is false, only the reverse adjacency is built (requires buildIncomingArcs).
+	inline void Read(const string filename, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool verbose, const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) {
 		// Unload whatever we have in memory.
 		Detach();
 
 		// Create identifiers from filename.
 		const string fullpath = Platform::SharedMemoryManager::GetIdentifierFromFilename(filename);
-		identifier = "fgraph/" + fullpath + "/" + (buildIncomingArcs ? "bi" : "uni");
+		identifier = "fgraph/" + fullpath + "/" + GetArcModeIdentifier(buildIncomingArcs, buildOutgoingArcs);
 		identifierHeader = identifier + "/header";
 		identifierVertices = identifier + "/vertices";
 		identifierArcs = identifier + "/arcs";
@@ -175,8 +194,132 @@ public:
 		}
 		else {
 			if (verbose) cout << "*** The graph '" << identifier << "' is not found in memory, attempting to read from '" << filename << ".gr'." << endl;
-			ReadFromDisk(filename, buildIncomingArcs, verbose, preferredNumaNode);
+			ReadFromDisk(filename, buildIncomingArcs, buildOutgoingArcs, verbose, preferredNumaNode);
+		}
+
+		// Perform a consistency check.
+		int numErrors = GetErrors(verbose);
+		Assert(numErrors == 0);
+
+		// Dump statistics.
+		if (verbose) DumpStatistics(cout);
+		if (verbose) cout << endl;
+	}
+
+
+	// Build the transform of a loaded graph in parallel: its transpose, its undirected version (without parallel
+	// arcs), or its directed version without or with the backward arc copies. The result is what the arc list
+	// builder would produce for the transformed arc list, except that all arcs are sorted by FastArc::operator<.
+	inline void BuildTransform(const ThisType &source, const TransformType transform, const bool verbose, const int32_t numt = omp_get_max_threads(), const Platform::DWORD preferredNumaNode = Platform::DWORD() - 1) {
+		Assert(&source != this);
+		Assert(source.IsDirected() || transform == TRANSPOSE || transform == SYMMETRIZE);
+		Detach();
+		const int32_t numVertices = static_cast<int32_t>(source.NumVertices());
+
+		// Determine which arcs the source stores.
+		int hasForward(0), hasBackward(0);
+#pragma omp parallel for num_threads(numt) reduction(| : hasForward, hasBackward)
+		for (int32_t u = 0; u < numVertices; ++u) {
+			for (ArcIdType a = source.vertices[u].FirstArcId(); a < source.vertices[u + 1].FirstArcId(); ++a) {
+				hasForward |= source.arcs[a].Forward() ? 1 : 0;
+				hasBackward |= source.arcs[a].Backward() ? 1 : 0;
+			}
+		}
+		const bool sourceDirected = source.IsDirected(), sourceForward = hasForward != 0 || hasBackward == 0;
+		const bool isDirected = sourceDirected && transform != SYMMETRIZE;
+		bool buildIncomingArcs = hasBackward != 0, buildOutgoingArcs = sourceForward;
+		if (transform == DROP_BACKWARD) buildIncomingArcs = false, buildOutgoingArcs = true;
+		if (transform == ADD_BACKWARD) buildIncomingArcs = buildOutgoingArcs = true;
+		const bool storeAtTail = buildOutgoingArcs || !isDirected;
+		const bool storeAtHead = buildIncomingArcs || !isDirected;
+
+		// Create identifiers.
+		identifier = source.identifier + "/" + GetTransformIdentifier(transform) + "/" + GetArcModeIdentifier(buildIncomingArcs, buildOutgoingArcs);
+		identifierHeader = identifier + "/header";
+		identifierVertices = identifier + "/vertices";
+		identifierArcs = identifier + "/arcs";
+
+		// If the graph is already loaded in memory, just attach to it.
+		if (Platform::SharedMemoryManager::Exists(identifierHeader)) {
+			if (verbose) cout << "*** The graph '" << identifier << "' is in memory already, attaching." << endl;
+			Attach(verbose, preferredNumaNode);
+			return;
+		}
+		if (verbose) cout << "Building the graph '" << identifier << "' with " << numt << " threads." << endl;
+
+		// Count the arcs at each vertex.
+		vector<atomic<ArcIdType>> position(numVertices + 1);
+#pragma omp parallel for num_threads(numt)
+		for (int32_t u = 0; u <= numVertices; ++u)
+			position[u].store(0, memory_order_relaxed);
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+		for (int32_t u = 0; u < numVertices; ++u) {
+			VertexIdType tail, head;
+			for (ArcIdType a = source.vertices[u].FirstArcId(); a < source.vertices[u + 1].FirstArcId(); ++a) {
+				if (!TransformArc(u, source.arcs[a], sourceDirected, sourceForward, transform, tail, head)) continue;
+				if (storeAtTail) position[tail].fetch_add(1, memory_order_relaxed);
+				if (storeAtHead) position[head].fetch_add(1, memory_order_relaxed);
+			}
+		}
+		vector<ArcIdType> firstArcId(numVertices + 1, 0);
+		for (int32_t u = 0; u < numVertices; ++u) {
+			firstArcId[u + 1] = firstArcId[u] + position[u].load(memory_order_relaxed);
+			position[u].store(firstArcId[u], memory_order_relaxed);
+		}
+
+		// Scatter the arcs. Symmetrizing can create parallel arcs, so these go to a scratch array first.
+		const bool deduplicate = transform == SYMMETRIZE;
+		vector<ArcType> scratch;
+		ArcType *target(nullptr);
+		if (deduplicate) {
+			scratch.resize(firstArcId[numVertices]);
+			target = scratch.data();
 		}
+		else target = Allocate(numVertices, firstArcId[numVertices], isDirected, verbose, preferredNumaNode);
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+		for (int32_t u = 0; u < numVertices; ++u) {
+			VertexIdType tail, head;
+			for (ArcIdType a = source.vertices[u].FirstArcId(); a < source.vertices[u + 1].FirstArcId(); ++a) {
+				if (!TransformArc(u, source.arcs[a], sourceDirected, sourceForward, transform, tail, head)) continue;
+				if (storeAtTail) {
+					ArcType &arc = target[position[tail].fetch_add(1, memory_order_relaxed)];
+					arc.SetOtherVertexId(head);
+					if (buildOutgoingArcs) arc.SetForwardFlag();
+					if (!isDirected && buildIncomingArcs) arc.SetBackwardFlag();
+				}
+				if (storeAtHead) {
+					ArcType &arc = target[position[head].fetch_add(1, memory_order_relaxed)];
+					arc.SetOtherVertexId(tail);
+					if (!isDirected && buildOutgoingArcs) arc.SetForwardFlag();
+					if (buildIncomingArcs) arc.SetBackwardFlag();
+				}
+			}
+		}
+
+		// Sort the arcs at each vertex, and remove parallel arcs if necessary.
+		vector<ArcIdType> degree(deduplicate ? numVertices : 0);
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+		for (int32_t u = 0; u < numVertices; ++u) {
+			sort(target + firstArcId[u], target + firstArcId[u + 1]);
+			if (deduplicate)
+				degree[u] = static_cast<ArcIdType>(unique(target + firstArcId[u], target + firstArcId[u + 1], [](const ArcType &a, const ArcType &b) { return a.OtherVertexId() == b.OtherVertexId(); }) - (target + firstArcId[u]));
+		}
+		if (deduplicate) {
+			vector<ArcIdType> compactFirstArcId(numVertices + 1, 0);
+			for (int32_t u = 0; u < numVertices; ++u)
+				compactFirstArcId[u + 1] = compactFirstArcId[u] + degree[u];
+			ArcType *compact = Allocate(numVertices, compactFirstArcId[numVertices], isDirected, verbose, preferredNumaNode);
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+			for (int32_t u = 0; u < numVertices; ++u)
+				copy(target + firstArcId[u], target + firstArcId[u] + degree[u], compact + compactFirstArcId[u]);
+			firstArcId.swap(compactFirstArcId);
+		}
+
+		// Finalize construction.
+#pragma omp parallel for num_threads(numt)
+		for (int32_t u = 0; u <= numVertices; ++u)
+			vertices[u].SetFirstArcId(firstArcId[u]);
+		arcs[header->NumArcs].SetOtherVertexId(static_cast<VertexIdType>(numVertices));
 
 		// Perform a consistency check.
 		int numErrors = GetErrors(verbose);
@@ -269,6 +412,66 @@ public:
 
 protected:
 
+	// Get the part of the identifier that encodes which arcs are stored.
+	static inline string GetArcModeIdentifier(const bool buildIncomingArcs, const bool buildOutgoingArcs) {
+		Assert(buildIncomingArcs || buildOutgoingArcs);
+		if (!buildOutgoingArcs) return "in";
+		return buildIncomingArcs ? "bi" : "uni";
+	}
+
+	// Get the part of the identifier that encodes a transform.
+	static inline string GetTransformIdentifier(const TransformType transform) {
+		switch (transform) {
+		case TRANSPOSE: return "transpose";
+		case SYMMETRIZE: return "symmetrize";
+		case DROP_BACKWARD: return "dropbackward";
+		default: return "addbackward";
+		}
+	}
+
+	// Map an arc stored at vertex u of a source graph to the arc (tail, head) of the transformed arc list.
+	// Returns false if the stored arc is not the representative of an arc of the source's arc list.
+	static inline bool TransformArc(const VertexIdType u, const ArcType &arc, const bool sourceDirected, const bool sourceForward, const TransformType transform, VertexIdType &tail, VertexIdType &head) {
+		const VertexIdType v = arc.OtherVertexId();
+		if (!sourceDirected) {
+			// Undirected arcs are stored at both ends.
+			if (v <= u) return false;
+			tail = u;
+			head = v;
+		}
+		else if (sourceForward) {
+			if (!arc.Forward()) return false;
+			tail = u;
+			head = v;
+		}
+		else {
+			if (!arc.Backward()) return false;
+			tail = v;
+			head = u;
+		}
+		if (transform == TRANSPOSE && sourceDirected)
+			swap(tail, head);
+		if (transform == SYMMETRIZE) {
+			if (tail == head) return false;
+			if (head < tail) swap(tail, head);
+		}
+		return true;
+	}
+
+	// Allocate the header, the vertices, and the arcs, and return the arcs.
+	inline ArcType *Allocate(const Types::SizeType numVertices, const Types::SizeType numArcs, const bool isDirected, const bool verbose, const Platform::DWORD preferredNumaNode) {
+		header = (HeaderType*)Platform::SharedMemoryManager::CreateSharedMemoryFile(sizeof(HeaderType), identifierHeader, verbose, preferredNumaNode);
+		Assert(header != nullptr);
+		vertices = (VertexType*)Platform::SharedMemoryManager::CreateSharedMemoryFile((numVertices + 1)*sizeof(VertexType), identifierVertices, verbose, preferredNumaNode);
+		Assert(vertices != nullptr);
+		arcs = (ArcType*)Platform::SharedMemoryManager::CreateSharedMemoryFile((numArcs + 1)*sizeof(ArcType), identifierArcs, verbose, preferredNumaNode);
+		Assert(arcs != nullptr);
+		header->NumVertices = numVertices;
+		header->NumArcs = numArcs;
+		header->IsDirected = isDirected;
+		return arcs;
+	}
+
 	// Attach the graph to shared memory.
 	inline void Attach(const bool verbose, const Platform::DWORD preferredNumaNode) {
 		// Get the header.
@@ -309,7 +512,7 @@ protected:
 
 	// Read the graph from a vector<pair> which contains the arcs.
 	template<typename containerType>
-	inline void ReadFromArcList(const VertexIdType numVertices, const containerType &inArcs, const bool isDirected, const bool buildIncomingArcs, const bool verbose, const Platform::DWORD preferredNumaNode) {
+	inline void ReadFromArcList(const VertexIdType numVertices, const containerType &inArcs, const bool isDirected, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool verbose, const Platform::DWORD preferredNumaNode) {
 		// Allocate memory for the header.
 		if (header != nullptr) {
 			Platform::SharedMemoryManager::CloseSharedMemoryFile(identifierHeader);
@@ -324,8 +527,9 @@ protected:
 		// Print some stats about the graph.
 		if (verbose) cout << "Awaiting " << numVertices << " vertices and " << numArcs << " arcs." << endl;
 		if (verbose) cout << "Incoming arcs will be built: " << (buildIncomingArcs ? "YES" : "NO") << "." << endl;
+		if (verbose) cout << "Outgoing arcs will be built: " << (buildOutgoingArcs ? "YES" : "NO") << "." << endl;
 		if (verbose) cout << "The graph will be: " << (isDirected ? "directed" : "undirected") << "." << endl;
-		if (verbose) cout << "Total number of arc entities in data structure: " << ((buildIncomingArcs || !isDirected) ? (numArcs * 2) : numArcs) << "." << endl << endl;
+		if (verbose) cout << "Total number of arc entities in data structure: " << ((buildIncomingArcs && buildOutgoingArcs) || !isDirected ? (numArcs * 2) : numArcs) << "." << endl << endl;
 
 		// Allocate storage for the vertices.
 		if (vertices != nullptr) {
@@ -336,8 +540,10 @@ protected:
 		Assert(vertices != nullptr);
 
 		// Allocate storage for the arcs.
-		const double memoryConsumptionArcs = (sizeof(ArcType)* numArcs) / 1024.0 / 1024.0 * (buildIncomingArcs || !isDirected ? 2 : 1);
-		numArcs *= (buildIncomingArcs || isDirected) ? 2 : 1;
+		Assert(buildIncomingArcs || buildOutgoingArcs);
+		const bool storeAtTail = buildOutgoingArcs || !isDirected;
+		const bool storeAtHead = buildIncomingArcs || !isDirected;
+		numArcs *= (storeAtTail && storeAtHead) ? 2 : 1;
 		if (arcs != nullptr) {
 			Platform::SharedMemoryManager::CloseSharedMemoryFile(identifierArcs);
 			arcs = nullptr;
@@ -357,10 +563,11 @@ protected:
 			Assert(isDirected || fromVertexId < toVertexId);
 
 			// Increase out-degree at source vertex.
-			vertices[fromVertexId].SetFirstArcId(vertices[fromVertexId].FirstArcId() + 1);
+			if (storeAtTail)
+				vertices[fromVertexId].SetFirstArcId(vertices[fromVertexId].FirstArcId() + 1);
 
 			// If we build incoming arcs or the graph is undirected, also increase in-degree at target vertex.
-			if (buildIncomingArcs || !isDirected)
+			if (storeAtHead)
 				vertices[toVertexId].SetFirstArcId(vertices[toVertexId].FirstArcId() + 1);
 		}
 		bar.Finish();
@@ -388,18 +595,21 @@ protected:
 			VertexIdType fromVertexId(inArc.first), toVertexId(inArc.second);
 
 			// Add outgoing arc.
-			Assert(firstFreeArcId[fromVertexId] < firstFreeArcId[fromVertexId + 1]);
-			arcs[firstFreeArcId[fromVertexId]].SetOtherVertexId(toVertexId);
-			arcs[firstFreeArcId[fromVertexId]].SetForwardFlag();
-			if (!isDirected && buildIncomingArcs)
-				arcs[firstFreeArcId[fromVertexId]].SetBackwardFlag();
-			++firstFreeArcId[fromVertexId];
+			if (storeAtTail) {
+				Assert(firstFreeArcId[fromVertexId] < firstFreeArcId[fromVertexId + 1]);
+				arcs[firstFreeArcId[fromVertexId]].SetOtherVertexId(toVertexId);
+				if (buildOutgoingArcs)
+					arcs[firstFreeArcId[fromVertexId]].SetForwardFlag();
+				if (!isDirected && buildIncomingArcs)
+					arcs[firstFreeArcId[fromVertexId]].SetBackwardFlag();
+				++firstFreeArcId[fromVertexId];
+			}
 
 			// If we shall add incoming arcs, do that as well.
-			if (buildIncomingArcs || !isDirected) {
+			if (storeAtHead) {
 				Assert(firstFreeArcId[toVertexId] < firstFreeArcId[toVertexId + 1]);
 				arcs[firstFreeArcId[toVertexId]].SetOtherVertexId(fromVertexId);
-				if (!isDirected)
+				if (!isDirected && buildOutgoingArcs)
 					arcs[firstFreeArcId[toVertexId]].SetForwardFlag();
 				if (buildIncomingArcs)
 					arcs[firstFreeArcId[toVertexId]].SetBackwardFlag();
@@ -420,8 +630,8 @@ protected:
 		header->NumArcs = numArcs;
 		header->IsDirected = isDirected;
 
-		// Sort the arcs if the graph is directed and incoming arcs should have been build.
-		if (buildIncomingArcs && isDirected) {
+		// Sort the arcs if the graph is directed and both incoming and outgoing arcs should have been build.
+		if (buildIncomingArcs && buildOutgoingArcs && isDirected) {
 			if (verbose) cout << "Sorting the arcs at each vertex:" << endl;
 			bar.Initialize(NumVertices(), "", verbose);
 			for (VertexIdType u = 0; u < NumVertices(); ++u) {
@@ -434,7 +644,7 @@ protected:
 
 
 	// Read the graph from disk. Uses the standard .gr format. I.e., this is binary compatible.
-	inline void ReadFromDisk(const string filename, const bool buildIncomingArcs, const bool verbose, const Platform::DWORD preferredNumaNode) {
+	inline void ReadFromDisk(const string filename, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool verbose, const Platform::DWORD preferredNumaNode) {
 		const Types::SizeType fileSize = IO::FileSize(filename + ".gr");
 		IO::FastCompatibleGraphStream<arcIdType> stream(filename);
 
@@ -454,8 +664,9 @@ protected:
 		if (verbose) cout << "Size of file: " << fixed << setprecision(1) << (fileSize / 1024.0 / 1024.0) << " MiB." << endl;
 		if (verbose) cout << "Awaiting " << numVertices << " vertices and " << numArcs << " arcs." << endl;
 		if (verbose) cout << "Incoming arcs will be built: " << (buildIncomingArcs ? "YES" : "NO") << "." << endl;
+		if (verbose) cout << "Outgoing arcs will be built: " << (buildOutgoingArcs ? "YES" : "NO") << "." << endl;
 		if (verbose) cout << "The graph will be: " << (isDirected ? "directed" : "undirected") << "." << endl;
-		if (verbose) cout << "Total number of arc entities in data structure: " << ((buildIncomingArcs || !isDirected) ? (numArcs * 2) : numArcs) << "." << endl << endl;
+		if (verbose) cout << "Total number of arc entities in data structure: " << ((buildIncomingArcs && buildOutgoingArcs) || !isDirected ? (numArcs * 2) : numArcs) << "." << endl << endl;
 
 		// Allocate storage for the vertices.
 		if (vertices != nullptr) {
@@ -466,8 +677,10 @@ protected:
 		Assert(vertices != nullptr);
 
 		// Allocate storage for the arcs.
-		const double memoryConsumptionArcs = (sizeof(ArcType)* numArcs) / 1024.0 / 1024.0 * (buildIncomingArcs || !isDirected ? 2 : 1);
-		numArcs *= (buildIncomingArcs || !stream.IsDirected()) ? 2 : 1;
+		Assert(buildIncomingArcs || buildOutgoingArcs);
+		const bool storeAtTail = buildOutgoingArcs || !isDirected;
+		const bool storeAtHead = buildIncomingArcs || !isDirected;
+		numArcs *= (storeAtTail && storeAtHead) ? 2 : 1;
 		if (arcs != nullptr) {
 			Platform::SharedMemoryManager::CloseSharedMemoryFile(identifierArcs);
 			arcs = nullptr;
@@ -489,10 +702,11 @@ protected:
 			Assert(isDirected || fromVertexId < toVertexId);
 
 			// Increase out-degree at source vertex.
-			vertices[fromVertexId].SetFirstArcId(vertices[fromVertexId].FirstArcId() + 1);
+			if (storeAtTail)
+				vertices[fromVertexId].SetFirstArcId(vertices[fromVertexId].FirstArcId() + 1);
 
 			// If we build incoming arcs or the graph is undirected, also increase in-degree at target vertex.
-			if (buildIncomingArcs || !isDirected)
+			if (storeAtHead)
 				vertices[toVertexId].SetFirstArcId(vertices[toVertexId].FirstArcId() + 1);
 
 			++numArcsRead;
@@ -529,18 +743,21 @@ protected:
 			tie(fromVertexId, toVertexId) = stream.GetNextArc();
 
 			// Add outgoing arc.
-			Assert(firstFreeArcId[fromVertexId] < firstFreeArcId[fromVertexId + 1]);
-			arcs[firstFreeArcId[fromVertexId]].SetOtherVertexId(toVertexId);
-			arcs[firstFreeArcId[fromVertexId]].SetForwardFlag();
-			if (!isDirected && buildIncomingArcs)
-				arcs[firstFreeArcId[fromVertexId]].SetBackwardFlag();
-			++firstFreeArcId[fromVertexId];
+			if (storeAtTail) {
+				Assert(firstFreeArcId[fromVertexId] < firstFreeArcId[fromVertexId + 1]);
+				arcs[firstFreeArcId[fromVertexId]].SetOtherVertexId(toVertexId);
+				if (buildOutgoingArcs)
+					arcs[firstFreeArcId[fromVertexId]].SetForwardFlag();
+				if (!isDirected && buildIncomingArcs)
+					arcs[firstFreeArcId[fromVertexId]].SetBackwardFlag();
+				++firstFreeArcId[fromVertexId];
+			}
 
 			// If we shall add incoming arcs, do that as well.
-			if (buildIncomingArcs || !isDirected) {
+			if (storeAtHead) {
 				Assert(firstFreeArcId[toVertexId] < firstFreeArcId[toVertexId + 1]);
 				arcs[firstFreeArcId[toVertexId]].SetOtherVertexId(fromVertexId);
-				if (!isDirected)
+				if (!isDirected && buildOutgoingArcs)
 					arcs[firstFreeArcId[toVertexId]].SetForwardFlag();
 				if (buildIncomingArcs)
 					arcs[firstFreeArcId[toVertexId]].SetBackwardFlag();
@@ -563,8 +780,8 @@ protected:
 		header->NumArcs = numArcs;
 		header->IsDirected = isDirected;
 
-		// Sort the arcs if the graph is directed and incoming arcs should have been build.
-		if (buildIncomingArcs && isDirected) {
+		// Sort the arcs if the graph is directed and both incoming and outgoing arcs should have been build.
+		if (buildIncomingArcs && buildOutgoingArcs && isDirected) {
 			if (verbose) cout << "Sorting the arcs at each vertex:" << endl;
 			bar.Initialize(NumVertices(), "", verbose);
 			for (VertexIdType u = 0; u < NumVertices(); ++u) {
@@ -17,10 +17,12 @@ THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <fstream>
 #include <cstring>
+#include <memory>
 
 #include "Assert.h"
 #include "Types.h"
 #include "Constants.h"
+#include "CompressedInput.h"
 
 using namespace std;
 
@@ -39,23 +41,36 @@ public:
 		bytesRead(0), 
 		bytesWritten(0),
 		readToEnd(true),
-		previousOperation(NO_OPERATION)
+		previousOperation(NO_OPERATION),
+		compression(NO_COMPRESSION),
+		hasPendingBlock(false),
+		openFailed(false)
 	{
 		buffer = new char[bufferCapacity];
 		Assert(buffer != nullptr);
 	}
 
 
-	// Opens a file.
+	// Opens a file. Files compressed with gzip or zstd are decompressed transparently when reading.
 	inline void OpenForReading(const string filename) { Open(filename, ios::binary | ios::in); }
 	inline void OpenNewForWriting(const string filename) { Open(filename, ios::binary | ios::out | ios::trunc); }
 	inline void OpenForReadingWriting(const string filename) { Open(filename, ios::binary | ios::in | ios::out); }
 	inline void Open(const string filename, const ios_base::openmode mode) {
-		// Try to open the file.
-		file.open(filename.c_str(), mode);
+		// Compressed files are decompressed on a separate thread (read-only).
+		compressedInput.reset();
+		openFailed = false;
+		compression = (mode & ios::out) ? NO_COMPRESSION : DetectCompression(filename);
+		if (compression != NO_COMPRESSION) {
+			compressedFilename = filename;
+			if (!OpenCompressed()) return;
+		}
+		else {
+			// Try to open the file.
+			file.open(filename.c_str(), mode);
 
-		// Abort if the file is not open.
-		if (!file.is_open()) return;
+			// Abort if the file is not open.
+			if (!file.is_open()) return;
+		}
 
 		// Not finished reading.
 		readToEnd = false;
@@ -76,6 +91,15 @@ public:
 
 	// Close the file.
 	inline void Close() {
+		if (compressedInput) {
+			compressedInput.reset();
+			hasPendingBlock = false;
+			bufferIndex = 0;
+			bufferSize = 0;
+			bytesRead = 0;
+			readToEnd = true;
+			return;
+		}
 		if (!file.is_open()) return;
 
 		// If the previous operation was a write, flush the buffer.
@@ -92,9 +116,18 @@ public:
 
 	// Reset the file stream. Seeks to the beginning.
 	inline void Reset() {
-		Assert(file.is_open());
-		file.clear();
-		file.seekg(0, ios::beg); 
+		if (compressedInput) {
+			// Compressed files are decompressed again from the start.
+			if (!OpenCompressed()) {
+				readToEnd = true;
+				return;
+			}
+		}
+		else {
+			Assert(file.is_open());
+			file.clear();
+			file.seekg(0, ios::beg);
+		}
 		readToEnd = false;
 		bufferIndex = 0;
 		bufferSize = 0;
@@ -105,7 +138,13 @@ public:
 
 	// Check if file is open.
 	inline bool IsOpen() {
-		return file.is_open();
+		return file.is_open() || compressedInput != nullptr;
+	}
+
+	// Test whether a compressed file could not be decompressed (unsupported, corrupt, or truncated).
+	// The data read so far is then incomplete; this is final once Finished() holds.
+	inline bool Failed() const {
+		return openFailed || (compressedInput != nullptr && compressedInput->Failed());
 	}
 
 	// If the object gets destroyed, close the file.
@@ -116,7 +155,7 @@ public:
 	}
 
 
-	// Return the number of bytes read from the file.
+	// Return the number of bytes read from the file (compressed bytes, for compressed files).
 	inline streamsize NumBytesRead() const {
 		return bytesRead;
 	}
@@ -134,6 +173,7 @@ public:
 
 	// Seek in the file.
 	inline void SeekFromEnd(streampos position) {
+		Assert(!compressedInput);
 		// If the previous operation was write, we first need to flush buffers.
 		if (previousOperation == WRITE_OPERATION)
 			Flush();
@@ -150,6 +190,7 @@ public:
 
 	// Seek in the file.
 	inline void SeekFromBeginning(streampos position) {
+		Assert(!compressedInput);
 		// If the previous operation was write, we first need to flush buffers.
 		if (previousOperation == WRITE_OPERATION)
 			Flush();
@@ -183,7 +224,7 @@ public:
 					line.append(buffer + fromIndex, bufferSize - fromIndex);
 
 				// If the file is eof. Return whatever is in the string, and stop.
-				if (file.eof()) {
+				if (SourceExhausted()) {
 					readToEnd = true;
 					return;
 				}
@@ -217,7 +258,7 @@ public:
 
 		// See if we need to read in stuff.
 		if (ReadRequired()) {
-			if (file.eof()) {
+			if (SourceExhausted()) {
 				readToEnd = true;
 				return '\0'; // Uhm...
 			}
@@ -230,8 +271,8 @@ public:
 
 
 
-	// Reads a chunk of binary data.
-	inline void Read(char *targetBuffer, streamsize numBytes) {
+	// Reads a chunk of binary data. Returns false if the file ends before all bytes were read.
+	inline bool Read(char *targetBuffer, streamsize numBytes) {
 		PrepareRead();
 		streamsize remainingBytesToExtract = numBytes;
 
@@ -253,14 +294,15 @@ public:
 				}
 
 				// Try to read, but if it failed, we cannot read more, and return whatever we have read.
-				if (file.eof()) {
+				if (SourceExhausted()) {
 					readToEnd = true;
-					return;
+					return false;
 				}
 				
 				Read();
 			}
 		}
+		return true;
 	}
 
 
@@ -282,7 +324,7 @@ public:
 					remainingBytesToExtract -= bytesToExtract;
 
 				// Try to read, but if it failed, we cannot read more, and return whatever we have read.
-				if (file.eof()) {
+				if (SourceExhausted()) {
 					readToEnd = true;
 					return;
 				}
@@ -294,6 +336,7 @@ public:
 
 	// Writes a chunk of binary data.
 	inline void Write(const char* sourceBuffer, streamsize numBytes) {
+		Assert(!compressedInput);
 		PrepareWrite();
 		streamsize remainingBytesToCopy = numBytes;
 
@@ -334,13 +377,47 @@ private:
 	inline void UpdateFinished() {
 		if (previousOperation != READ_OPERATION) return;
 		//cout << "Read operation done; pos = " << file.tellg() << "; bufferIndex = " << bufferIndex << "; bufferSize = " << bufferSize << "; file.eof() = " << file.eof() << endl;
-		if (bufferSize == bufferIndex && file.peek() == EOF)
+		if (bufferSize == bufferIndex && (compressedInput ? !hasPendingBlock : file.peek() == EOF))
 			readToEnd = true;
 	}
 
+	// Test if the underlying file has no more data to read.
+	inline bool SourceExhausted() {
+		return compressedInput ? !hasPendingBlock : file.eof();
+	}
+
+	// Start decompressing the file, and wait for its first block.
+	inline bool OpenCompressed() {
+		if (!CompressedInput::Supported(compression)) {
+			cerr << "ERROR: Reading '" << compressedFilename << "' requires building with " << (compression == GZIP_COMPRESSION ? "ZLIB=1" : "ZSTD=1") << "." << endl;
+			compressedInput.reset();
+			openFailed = true;
+			return false;
+		}
+		compressedInput.reset(new CompressedInput());
+		if (!compressedInput->Open(compressedFilename, compression, static_cast<size_t>(bufferCapacity))) {
+			compressedInput.reset();
+			openFailed = true;
+			return false;
+		}
+		hasPendingBlock = compressedInput->NextBlock(pendingBlock);
+		return true;
+	}
+
 	// Read data, and set file pointer to zero.
 	inline bool Read() {
 		bufferIndex = 0;
+		if (compressedInput) {
+			// Take the block decompressed ahead, and wait for the next one.
+			bufferSize = 0;
+			if (hasPendingBlock) {
+				bufferSize = static_cast<int>(pendingBlock.Data.size());
+				memcpy(buffer, pendingBlock.Data.data(), pendingBlock.Data.size());
+				bytesRead = pendingBlock.CompressedBytes;
+				hasPendingBlock = compressedInput->NextBlock(pendingBlock);
+			}
+			return bufferSize > 0;
+		}
 		file.read(buffer, bufferCapacity);
 		bufferSize = static_cast<int>(file.gcount());
 		bytesRead += bufferSize;
@@ -412,6 +489,16 @@ private:
 
 	// Indicates the previous operation on the disk.
 	OperationType previousOperation;
+
+	// The decompression of a compressed file, and the next block it produced.
+	CompressionType compression;
+	string compressedFilename;
+	unique_ptr<CompressedInput> compressedInput;
+	CompressedInput::BlockType pendingBlock;
+	bool hasPendingBlock;
+
+	// Indicates whether a compressed file could not be opened.
+	bool openFailed;
 };
 
 }
\ No newline at end of file
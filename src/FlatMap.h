@@ -0,0 +1,151 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+
+namespace DataStructures {
+namespace Container {
+
+// A hash map from 64-bit keys (except UINT64_MAX) to values, stored in one array with linear probing.
+// Erasing shifts the following entries of the run back instead of leaving tombstones, so the array
+// only grows when the map exceeds half of it: once the map has reached its largest size, inserts and
+// erases do not allocate. Lookups do not modify the map, so they may run concurrently.
+template<typename valueType>
+class FlatMap {
+
+public:
+
+	// Expose typedefs.
+	typedef valueType ValueType;
+	static const uint64_t EmptyKey = UINT64_MAX;
+
+	// Construct an empty map.
+	FlatMap() : numEntries(0), mask(0) {}
+
+	// Get the number of entries.
+	inline Types::SizeType Size() const {
+		return numEntries;
+	}
+
+	// Get the size of the arrays in bytes.
+	inline Types::SizeType MemoryBytes() const {
+		return keys.capacity() * sizeof(uint64_t) + values.capacity() * sizeof(valueType);
+	}
+
+	// Make room for n entries without growing.
+	inline void Reserve(const Types::SizeType n) {
+		Types::SizeType size = 16;
+		while (size < 2 * n) size *= 2;
+		if (size > keys.size()) Rehash(size);
+	}
+
+	// Returns the value of a key, or nullptr if it is not contained.
+	inline const valueType *Find(const uint64_t key) const {
+		if (numEntries == 0) return nullptr;
+		for (uint64_t p = Hash(key) & mask; keys[p] != EmptyKey; p = (p + 1) & mask)
+			if (keys[p] == key) return &values[p];
+		return nullptr;
+	}
+	inline valueType *Find(const uint64_t key) {
+		return const_cast<valueType*>(static_cast<const FlatMap*>(this)->Find(key));
+	}
+
+	// Returns the value of a key, inserting the key with value if it is not contained.
+	inline valueType &Insert(const uint64_t key, const valueType &value = valueType()) {
+		Assert(key != EmptyKey);
+		if (2 * (numEntries + 1) > keys.size()) Rehash(keys.empty() ? 16 : 2 * keys.size());
+		uint64_t p = Hash(key) & mask;
+		for (; keys[p] != EmptyKey; p = (p + 1) & mask)
+			if (keys[p] == key) return values[p];
+		keys[p] = key;
+		values[p] = value;
+		++numEntries;
+		return values[p];
+	}
+
+	// Erases a key. Returns false if it is not contained.
+	inline bool Erase(const uint64_t key) {
+		if (numEntries == 0) return false;
+		uint64_t p = Hash(key) & mask;
+		for (; keys[p] != key; p = (p + 1) & mask)
+			if (keys[p] == EmptyKey) return false;
+
+		// Move entries of the run back into the hole, unless their home is after it.
+		for (uint64_t q = (p + 1) & mask; keys[q] != EmptyKey; q = (q + 1) & mask) {
+			const uint64_t home = Hash(keys[q]) & mask;
+			if (((q - home) & mask) < ((q - p) & mask)) continue;
+			keys[p] = keys[q];
+			values[p] = values[q];
+			p = q;
+		}
+		keys[p] = EmptyKey;
+		--numEntries;
+		return true;
+	}
+
+	// Erases all entries, keeping the array.
+	inline void Clear() {
+		fill(keys.begin(), keys.end(), EmptyKey);
+		numEntries = 0;
+	}
+
+private:
+
+	// Mixes the bits of a key (the finalizer of SplitMix64).
+	static inline uint64_t Hash(uint64_t key) {
+		key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+		key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+		return key ^ (key >> 31);
+	}
+
+	// Moves the entries into an array of the given size (a power of two).
+	inline void Rehash(const Types::SizeType size) {
+		vector<uint64_t> oldKeys(size, EmptyKey);
+		vector<valueType> oldValues(size);
+		oldKeys.swap(keys);
+		oldValues.swap(values);
+		mask = size - 1;
+		for (Types::IndexType p = 0; p < oldKeys.size(); ++p) {
+			if (oldKeys[p] == EmptyKey) continue;
+			uint64_t q = Hash(oldKeys[p]) & mask;
+			while (keys[q] != EmptyKey) q = (q + 1) & mask;
+			keys[q] = oldKeys[p];
+			values[q] = oldValues[p];
+		}
+	}
+
+	// The keys (EmptyKey for free entries) and values.
+	vector<uint64_t> keys;
+	vector<valueType> values;
+
+	// The number of entries, and the size of the arrays minus one.
+	Types::SizeType numEntries;
+	uint64_t mask;
+};
+
+template<typename valueType>
+const uint64_t FlatMap<valueType>::EmptyKey;
+
+}
+}
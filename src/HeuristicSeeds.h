@@ -0,0 +1,294 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+using namespace std;
+
+#include "FastStaticGraphs.h"
+#include "Macros.h"
+#include "Timer.h"
+#include "AlignedKHeap.h"
+#include "FileStream.h"
+#include "SKIM.h"
+#include "RSInfluenceOracle.h"
+
+namespace Algorithms {
+namespace InfluenceMaximization {
+
+// Fast heuristic seed selection, for answers in well under the time of a SKIM run. The seeds come
+// without a quality guarantee; the exact evaluation of SKIM (on the same instances) measures how
+// much spread they give up:
+// - degree discount: the expected number of vertices a vertex activates itself and by its
+//   outgoing arcs, discounted by the probability that the seeds already activate it (Chen et al.,
+//   generalized to the arc probabilities of the model),
+// - pagerank: the damped expected number of walks from a vertex, x(u) = 1 + d * sum p(u,v) x(v),
+//   computed in parallel (a PageRank on the reverse graph, personalized to all vertices), with
+//   the same discounts for the neighbors of seeds; d is divided by the largest sum of arc
+//   probabilities of a vertex (if above one), so the iteration converges on dense graphs,
+// - singlesketch: the estimated (marginal) influences from the combined bottom-k reachability
+//   sketches of the oracle, built once on k and l (so few instances make it fast).
+class HeuristicSeeds {
+public:
+
+	// Type definitions.
+	typedef SKIM::GraphType GraphType;
+	typedef SKIM::SeedType SeedType;
+	enum MethodType { DEGREE_DISCOUNT, PAGERANK, SINGLE_SKETCH };
+
+	// Default constructor.
+	HeuristicSeeds(GraphType &g, const uint32_t s, const bool v) :
+		verbose(v),
+		randomSeed(s),
+		graph(g),
+		indeg(graph.NumVertices(), 0),
+		binaryProbability(0.1),
+		pageRankRounds(0)
+	{
+		FORALL_ARCS(graph, u, a) {
+			if (!a->Forward()) continue;
+			++indeg[a->OtherVertexId()];
+		}
+	}
+
+	// Set the binary probability.
+	inline void SetBinaryProbability(const double prob) {
+		binaryProbability = prob;
+	}
+
+	// The number of rounds of the last PageRank iteration (at most 50).
+	inline uint32_t PageRankRounds() const {
+		return pageRankRounds;
+	}
+
+	// Parse the name of a method (degreediscount, pagerank, singlesketch). Returns false if unknown.
+	static bool ParseMethod(const string name, MethodType &method) {
+		if (name == "degreediscount") method = DEGREE_DISCOUNT;
+		else if (name == "pagerank") method = PAGERANK;
+		else if (name == "singlesketch") method = SINGLE_SKETCH;
+		else return false;
+		return true;
+	}
+
+	// Computes N seeds (zero means all vertices) with the method, using numt threads. The single
+	// sketch method builds sketches with the given k and l. If lEval is set, the exact marginal
+	// influences of the seeds are evaluated on lEval instances (not measured in the running time).
+	template<SKIM::ModelType modelType>
+	vector<SeedType> Run(const MethodType method, uint32_t N, const uint16_t k, const uint16_t l, const uint16_t lEval, const int32_t numt, const string statsFilename = "") {
+		if (N == 0 || N > graph.NumVertices()) N = static_cast<uint32_t>(graph.NumVertices());
+		static const char *methodNames[] = { "degree discount", "pagerank", "single sketch" };
+		if (verbose) cout << "Computing " << N << " seeds by " << methodNames[method] << "... " << flush;
+		Platform::Timer timer; timer.Start();
+		vector<uint32_t> seeds;
+		vector<double> scores;
+		if (method == DEGREE_DISCOUNT) DegreeDiscount<modelType>(N, numt, seeds, scores);
+		else if (method == PAGERANK) PageRank<modelType>(N, numt, seeds, scores);
+		else SingleSketch<modelType>(N, k, l, seeds, scores);
+		const double elapsedMilliseconds = timer.LiveElapsedMilliseconds();
+		if (verbose) cout << "done (" << seeds.size() << " seeds, " << elapsedMilliseconds << "ms)." << endl;
+
+		vector<SeedType> seedSet(seeds.size());
+		for (size_t i = 0; i < seeds.size(); ++i) {
+			seedSet[i].VertexId = seeds[i];
+			seedSet[i].EstimatedInfluence = scores[i];
+			seedSet[i].BuildSketchesElapsedMilliseconds = elapsedMilliseconds;
+		}
+
+		// Evaluate the seeds on the instances of SKIM.
+		double exinf(0);
+		if (lEval > 0) {
+			SKIM evaluator(graph, randomSeed, verbose);
+			evaluator.SetBinaryProbability(binaryProbability);
+			exinf = evaluator.EvaluateSeeds<modelType>(seedSet, lEval);
+		}
+
+		cout << "Heuristic: " << methodNames[method] << "." << endl
+			<< "Random seed: " << randomSeed << "." << endl
+			<< "Number of seed vertices computed: " << seedSet.size() << "." << endl
+			<< "Total time: " << elapsedMilliseconds / 1000.0 << " sec." << endl;
+		if (lEval > 0)
+			cout << "Exact spread of solution: " << exinf << " (" << (100.0*exinf / static_cast<double>(graph.NumVertices())) << " %)." << endl;
+
+		if (!statsFilename.empty()) {
+			IO::FileStream file;
+			file.OpenNewForWriting(statsFilename);
+			if (file.IsOpen()) {
+				stringstream ss;
+				ss << "NumberOfVertices = " << graph.NumVertices() << endl
+					<< "NumberOfArcs = " << graph.NumArcs() / 2 << endl
+					<< "Heuristic = " << methodNames[method] << endl
+					<< "TotalExactInfluence = " << exinf << endl
+					<< "TotalElapsedMilliseconds = " << elapsedMilliseconds << endl
+					<< "NumberOfSeedVertices = " << seedSet.size() << endl;
+				double sumExactInfluence(0.0);
+				for (Types::IndexType i = 0; i < seedSet.size(); ++i) {
+					sumExactInfluence += seedSet[i].ExactInfluence;
+					ss << i << "_Score = " << seedSet[i].EstimatedInfluence << endl
+						<< i << "_MarginalExactInfluence = " << seedSet[i].ExactInfluence << endl
+						<< i << "_CumulativeExactInfluence = " << sumExactInfluence << endl
+						<< i << "_VertexId = " << seedSet[i].VertexId << endl;
+				}
+				file.WriteString(ss.str());
+			}
+		}
+		return seedSet;
+	}
+
+protected:
+
+	// The (expected) probability of the arc from u to v.
+	template<SKIM::ModelType modelType>
+	inline double Probability(const uint32_t, const uint32_t v) const {
+		if (modelType == SKIM::WEIGHTED) return 1.0 / double(indeg[v]);
+		if (modelType == SKIM::BINARY) return binaryProbability;
+		return (0.1 + 0.01 + 0.001) / 3.0; // the mean of the trivalency probabilities.
+	}
+
+	// Degree discount. The score of u is q(u) * (1 + e(u)), where q(u) is the probability that no
+	// seed activates u by an arc, and e(u) the sum of the probabilities of its arcs to non-seeds.
+	// A new seed lowers e of its in-neighbors and q of its out-neighbors.
+	template<SKIM::ModelType modelType>
+	void DegreeDiscount(const uint32_t N, const int32_t numt, vector<uint32_t> &seeds, vector<double> &scores) {
+		const int64_t n = static_cast<int64_t>(graph.NumVertices());
+		vector<double> q(n, 1.0), e(n, 0.0);
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+		for (int64_t u = 0; u < n; ++u) {
+			double sum = 0;
+			FORALL_INCIDENT_ARCS(graph, static_cast<uint32_t>(u), a) {
+				if (!a->Forward()) continue;
+				sum += Probability<modelType>(static_cast<uint32_t>(u), a->OtherVertexId());
+			}
+			e[u] = sum;
+		}
+		SelectDiscounted(N, seeds, scores, [&](const uint32_t u) { return q[u] * (1.0 + e[u]); }, [&](const uint32_t u, const uint32_t v, const bool forward) {
+			if (forward) q[v] *= 1.0 - Probability<modelType>(u, v);
+			else e[v] -= Probability<modelType>(v, u);
+		});
+	}
+
+	// PageRank-style scores, iterated in parallel (Jacobi) until the largest relative change is
+	// below 1e-4 (or for at most 50 rounds). The damping is scaled by the largest row sum of the
+	// arc probabilities, which makes the iteration a contraction (by 0.85 in the maximum norm), so
+	// the scores stay below 1 / 0.15. A new seed removes its share from the scores of its
+	// in-neighbors and discounts its out-neighbors by the probability of its arc.
+	template<SKIM::ModelType modelType>
+	void PageRank(const uint32_t N, const int32_t numt, vector<uint32_t> &seeds, vector<double> &scores) {
+		const int64_t n = static_cast<int64_t>(graph.NumVertices());
+		double rowMax = 0;
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024) reduction(max : rowMax)
+		for (int64_t u = 0; u < n; ++u) {
+			double sum = 0;
+			FORALL_INCIDENT_ARCS(graph, static_cast<uint32_t>(u), a) {
+				if (!a->Forward()) continue;
+				sum += Probability<modelType>(static_cast<uint32_t>(u), a->OtherVertexId());
+			}
+			rowMax = max(rowMax, sum);
+		}
+		const double damping = 0.85 / max(1.0, rowMax);
+		vector<double> x(n, 1.0), y(n, 1.0);
+		pageRankRounds = 0;
+		while (pageRankRounds < 50) {
+			++pageRankRounds;
+			double change = 0;
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024) reduction(max : change)
+			for (int64_t u = 0; u < n; ++u) {
+				double sum = 0;
+				FORALL_INCIDENT_ARCS(graph, static_cast<uint32_t>(u), a) {
+					if (!a->Forward()) continue;
+					sum += Probability<modelType>(static_cast<uint32_t>(u), a->OtherVertexId()) * x[a->OtherVertexId()];
+				}
+				y[u] = 1.0 + damping * sum;
+				change = max(change, abs(y[u] - x[u]) / y[u]);
+			}
+			x.swap(y);
+			if (change < 1e-4) break;
+		}
+		SelectDiscounted(N, seeds, scores, [&](const uint32_t u) { return x[u]; }, [&](const uint32_t u, const uint32_t v, const bool forward) {
+			if (forward) x[v] *= 1.0 - Probability<modelType>(u, v);
+			else x[v] = max(1.0, x[v] - damping * Probability<modelType>(v, u) * x[u]);
+		});
+	}
+
+	// Greedy on the estimates of the oracle sketches, which are built once (unlike SKIM, which
+	// rebuilds them on the residual problem). The first seed is the vertex of largest estimated
+	// influence, later ones have the largest estimated marginal influence.
+	template<SKIM::ModelType modelType>
+	void SingleSketch(const uint32_t N, const uint16_t k, const uint16_t l, vector<uint32_t> &seeds, vector<double> &scores) {
+		const FastRSInfluenceOracle::ModelType oracleModelType = static_cast<FastRSInfluenceOracle::ModelType>(modelType);
+		FastRSInfluenceOracle oracle(graph, randomSeed, false);
+		oracle.SetBinaryProbability(binaryProbability);
+		oracle.RunPreprocessing<oracleModelType>(k, l);
+		oracle.GreedySequence(N, k, l, seeds, scores);
+	}
+
+	// Picks N vertices of largest score in turn. After each pick u, discount(u, v, forward) is called
+	// for each non-seed neighbor v (forward for the heads of its arcs, backward for the tails), whose
+	// scores are then updated.
+	template<typename scoreType, typename discountType>
+	void SelectDiscounted(const uint32_t N, vector<uint32_t> &seeds, vector<double> &scores, scoreType score, discountType discount) {
+		DataStructures::Container::AlignedKHeap<double, uint32_t, 3> queue(graph.NumVertices()); // the negated scores.
+		vector<uint32_t> vertices(graph.NumVertices());
+		vector<double> keys(graph.NumVertices());
+		FORALL_VERTICES(graph, u) {
+			vertices[u] = u;
+			keys[u] = -score(u);
+		}
+		queue.Build(vertices.data(), keys.data(), vertices.size());
+		vector<pair<uint32_t, double>> updates;
+		while (seeds.size() < N && !queue.Empty()) {
+			double key;
+			const uint32_t u = queue.DeleteMin(key);
+			seeds.push_back(u);
+			scores.push_back(-key);
+			updates.clear();
+			FORALL_INCIDENT_ARCS(graph, u, a) {
+				const uint32_t v = a->OtherVertexId();
+				if (!queue.Contains(v)) continue;
+				if (a->Forward()) discount(u, v, true);
+				if (a->Backward()) discount(u, v, false);
+				updates.push_back(make_pair(v, -score(v)));
+			}
+			queue.UpdateBatch(updates);
+		}
+	}
+
+	// Indicates whether the algorithm produces output.
+	const bool verbose;
+
+	// This is the random seed (of the sketches and of the evaluation instances).
+	const uint32_t randomSeed;
+
+	// The graph.
+	GraphType &graph;
+
+	// The in-degrees of the vertices.
+	vector<uint32_t> indeg;
+
+	// The binary probability.
+	double binaryProbability;
+
+	// The number of rounds of the last PageRank iteration.
+	uint32_t pageRankRounds;
+};
+
+}
+}
@@ -0,0 +1,138 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <climits>
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+#include "Macros.h"
+
+namespace DataStructures {
+namespace Graphs {
+
+// This represents the neighborhoods of hubs (vertices with many arcs in one direction) additionally
+// as bitmaps: the neighbors are grouped into blocks of 64 consecutive vertex ids, and each block
+// holds a bit mask of the neighbors in it. A BFS can then exclude visited (or covered) neighbors of
+// a hub word by word, instead of testing each arc.
+// Only hubs whose arcs are sorted by neighbor id (in the order in which a BFS scans them) are
+// represented, such that scanning the bits visits the neighbors in the order of the arcs:
+// ascending for forward arcs, and descending for backward arcs (which are scanned from the last arc).
+template<typename graphType>
+class HubAdjacency {
+public:
+
+	// A block of 64 vertex ids and the mask of neighbors in it.
+	struct BlockType {
+		uint32_t Index;
+		uint64_t Mask;
+	};
+
+	// Default constructor, without hubs.
+	HubAdjacency() {}
+
+	// Build the bitmaps of all vertices with at least threshold arcs in the direction.
+	// A threshold of zero removes all hubs.
+	void Build(graphType &graph, const Types::Direction direction, const Types::SizeType threshold) {
+		hubIndex.clear();
+		firstBlock.clear();
+		blocks.clear();
+		if (threshold == 0) return;
+		hubIndex.resize(graph.NumVertices(), NotAHub);
+		vector<uint32_t> neighbors;
+		FORALL_VERTICES(graph, u) {
+			// Collect the neighbors in the order of the scan.
+			neighbors.clear();
+			if (direction == Types::FORWARD_DIRECTION) {
+				FORALL_INCIDENT_ARCS(graph, u, a) {
+					if (!a->Forward()) break;
+					neighbors.push_back(a->OtherVertexId());
+				}
+			}
+			else {
+				FORALL_INCIDENT_ARCS_BACKWARD(graph, u, a) {
+					if (!a->Backward()) break;
+					neighbors.push_back(a->OtherVertexId());
+				}
+				reverse(neighbors.begin(), neighbors.end());
+			}
+			if (neighbors.size() < threshold || !is_sorted(neighbors.begin(), neighbors.end()))
+				continue;
+
+			// Group them by blocks.
+			hubIndex[u] = static_cast<uint32_t>(firstBlock.size());
+			firstBlock.push_back(blocks.size());
+			for (const uint32_t v : neighbors) {
+				if (blocks.size() == firstBlock.back() || blocks.back().Index != v / 64)
+					blocks.push_back(BlockType{ v / 64, 0 });
+				blocks.back().Mask |= uint64_t(1) << (v % 64);
+			}
+		}
+		firstBlock.push_back(blocks.size()); // sentinel
+	}
+
+	// Test whether u is represented as a hub.
+	inline bool IsHub(const uint32_t u) const {
+		return !hubIndex.empty() && hubIndex[u] != NotAHub;
+	}
+
+	// Get the blocks of hub u, sorted by index.
+	inline const BlockType *BeginBlock(const uint32_t u) const {
+		Assert(IsHub(u));
+		return blocks.data() + firstBlock[hubIndex[u]];
+	}
+	inline const BlockType *EndBlock(const uint32_t u) const {
+		Assert(IsHub(u));
+		return blocks.data() + firstBlock[hubIndex[u] + 1];
+	}
+
+	// Get the number of hubs.
+	inline Types::SizeType NumHubs() const { return firstBlock.empty() ? 0 : firstBlock.size() - 1; }
+
+	// Get the memory footprint of the bitmaps.
+	inline uint64_t MemoryFootprint() const {
+		return hubIndex.size()*sizeof(uint32_t) + firstBlock.size()*sizeof(size_t) + blocks.size()*sizeof(BlockType);
+	}
+
+	// Dump statistics.
+	void DumpStatistics(ostream &os) const {
+		os << "Hub bitmaps: " << NumHubs() << " hubs, " << blocks.size() << " blocks, "
+			<< (MemoryFootprint() / 1024.0 / 1024.0) << " MiB." << endl;
+	}
+
+private:
+
+	// The index of a vertex that is not a hub.
+	static const uint32_t NotAHub = UINT_MAX;
+
+	// The hub index of each vertex.
+	vector<uint32_t> hubIndex;
+
+	// The first block of each hub.
+	vector<size_t> firstBlock;
+
+	// The blocks of all hubs.
+	vector<BlockType> blocks;
+};
+
+template<typename graphType>
+const uint32_t HubAdjacency<graphType>::NotAHub;
+
+}
+}
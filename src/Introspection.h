@@ -0,0 +1,179 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+using namespace std;
+
+#include "Types.h"
+#include "Timer.h"
+#include "Conversion.h"
+#include "AllocationTracker.h"
+
+namespace Tools {
+
+namespace IntrospectionDetail {
+
+// Set by the signal handler, which may only store to a lock-free atomic.
+static atomic<bool> requested(false);
+
+extern "C" inline void HandleSignal(int) {
+	requested.store(true, memory_order_relaxed);
+}
+
+}
+
+// Snapshots of a long running algorithm on request, to tell a stall from a slow phase. SIGUSR1 (on
+// platforms that have it) only raises a flag; the main loops test it at safe points (between
+// searches, outside of parallel sections) and then write a snapshot of their state. A snapshot
+// starts with the time since installation and the current (allocation tracker) phase, and it goes
+// to stderr, or is appended to a file.
+class Introspection {
+public:
+
+	// Installs the signal handler. Snapshots are appended to the file (stderr if it is empty).
+	static void Install(const string filename = "") {
+		State &state = GetState();
+		state.Filename = filename;
+		state.Installed.Start();
+#if defined(SIGUSR1)
+		signal(SIGUSR1, IntrospectionDetail::HandleSignal);
+#else
+		cerr << "WARNING: Snapshots cannot be requested by a signal on this platform." << endl;
+#endif
+	}
+
+	// Whether a snapshot has been requested. This is the (cheap) test at the safe points.
+	static inline bool Requested() {
+		return IntrospectionDetail::requested.load(memory_order_relaxed);
+	}
+
+	// Requests a snapshot, as the signal does.
+	static inline void Request() {
+		IntrospectionDetail::requested.store(true, memory_order_relaxed);
+	}
+
+	// Writes a snapshot of the algorithm: the header, whatever write(os) writes, and the allocation
+	// counters (if they are tracked). Clears the request.
+	template<typename writeType>
+	static void Write(const string algorithm, writeType &&write) {
+		IntrospectionDetail::requested.store(false, memory_order_relaxed);
+		State &state = GetState();
+		stringstream ss;
+		ss << "=== Snapshot of " << algorithm << " after " << MillisecondsToString(state.Installed.LiveElapsedMilliseconds())
+			<< " (phase: " << AllocationTracker::CurrentPhaseName() << ") ===" << endl;
+		write(ss);
+		AllocationTracker::DumpStatistics(ss);
+		if (state.Filename.empty()) {
+			cerr << ss.str() << flush;
+			return;
+		}
+		ofstream file(state.Filename, ios::app);
+		if (!file.is_open()) {
+			cerr << "ERROR: Could not open snapshot file '" << state.Filename << "'." << endl << ss.str() << flush;
+			return;
+		}
+		file << ss.str() << flush;
+	}
+
+	// Writes a memory footprint line of a structure.
+	static inline void WriteMemory(ostream &os, const string name, const Types::SizeType bytes) {
+		os << "    " << name << ": " << bytes / 1024.0 / 1024.0 << " MiB" << endl;
+	}
+
+private:
+
+	// The destination and the time of installation.
+	struct State {
+		string Filename;
+		Platform::Timer Installed;
+	};
+	static inline State &GetState() {
+		static State state;
+		return state;
+	}
+};
+
+
+// Progress counters per thread. Each counter is only added to by its own thread, but any thread may
+// read them (such as when writing a snapshot); they are on separate cache lines.
+class ProgressCounters {
+public:
+	ProgressCounters(const int32_t numThreads = 1) : counters(numThreads) {}
+
+	// Adds n to the counter of thread t.
+	inline void Add(const int32_t t, const uint64_t n = 1) {
+		atomic<uint64_t> &value = counters[t].Value;
+		value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed);
+	}
+
+	// Access the counter of thread t, and their sum.
+	inline uint64_t Value(const int32_t t) const { return counters[t].Value.load(memory_order_relaxed); }
+	inline uint64_t Sum() const {
+		uint64_t sum(0);
+		for (int32_t t = 0; t < static_cast<int32_t>(counters.size()); ++t) sum += Value(t);
+		return sum;
+	}
+
+	// Writes the counters as a line.
+	void Write(ostream &os, const string name) const {
+		os << "  " << name << ": " << Sum();
+		if (counters.size() > 1)
+			for (int32_t t = 0; t < static_cast<int32_t>(counters.size()); ++t) os << "; thread " << t << ": " << Value(t);
+		os << endl;
+	}
+
+private:
+	struct Counter {
+		Counter() : Value(0) {}
+		atomic<uint64_t> Value;
+		char Padding[56];
+	};
+	vector<Counter> counters;
+};
+
+
+// The durations of the most recent iterations of a loop.
+class RecentTimings {
+public:
+	RecentTimings(const size_t capacity = 8) : durations(capacity, 0.0), numAdded(0) {}
+
+	// Adds the duration of an iteration.
+	inline void Add(const double milliseconds) {
+		durations[numAdded++ % durations.size()] = milliseconds;
+	}
+
+	// Writes the durations as a line, from the oldest to the newest.
+	void Write(ostream &os, const string name) const {
+		os << "  " << name << " (ms, last " << min<uint64_t>(numAdded, durations.size()) << " of " << numAdded << "):";
+		for (uint64_t i = numAdded > durations.size() ? numAdded - durations.size() : 0; i < numAdded; ++i)
+			os << " " << durations[i % durations.size()];
+		os << endl;
+	}
+
+private:
+	vector<double> durations;
+	uint64_t numAdded;
+};
+
+}
@@ -0,0 +1,142 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+#include "FlatMap.h"
+
+namespace DataStructures {
+namespace Container {
+
+// Lists of 32-bit values by 64-bit key (except UINT64_MAX), stored one after another in a single
+// array: a list is appended while it is open, and erasing it only marks it. Once the erased lists
+// take up half of the array, the ones left are compacted to its front. Hence, when the lists stop
+// growing in total, adding and erasing them does not allocate, unlike a map of vectors. Lookups do
+// not modify the arena, so they may run concurrently.
+class ListArena {
+
+public:
+
+	// A list, which can be iterated over.
+	struct Range {
+		const uint32_t *First, *Last;
+		inline const uint32_t *begin() const { return First; }
+		inline const uint32_t *end() const { return Last; }
+		inline size_t size() const { return Last - First; }
+	};
+
+	// Construct an empty arena.
+	ListArena() : openOffset(NoOffset), numErased(0) {}
+
+	// Get the number of lists, and of the array entries in use (with list headers).
+	inline Types::SizeType NumLists() const { return index.Size(); }
+	inline Types::SizeType NumEntries() const { return data.size() - numErased; }
+
+	// Get the size of the array and the index in bytes.
+	inline Types::SizeType MemoryBytes() const {
+		return data.capacity() * sizeof(uint32_t) + index.MemoryBytes();
+	}
+
+	// Start a new (empty) list for the key, which must not have one. Values are appended to it
+	// until it is closed.
+	inline void Open(const uint64_t key) {
+		Assert(openOffset == NoOffset);
+		Assert(index.Find(key) == nullptr);
+		openOffset = data.size();
+		index.Insert(key, openOffset);
+		data.push_back(0);
+		data.push_back(static_cast<uint32_t>(key));
+		data.push_back(static_cast<uint32_t>(key >> 32));
+	}
+	inline void Append(const uint32_t value) {
+		Assert(openOffset != NoOffset);
+		data.push_back(value);
+	}
+	inline void Close() {
+		Assert(openOffset != NoOffset);
+		data[openOffset] = static_cast<uint32_t>(data.size() - openOffset - HeaderSize);
+		openOffset = NoOffset;
+	}
+
+	// Test whether the key has a list.
+	inline bool Contains(const uint64_t key) const {
+		return index.Find(key) != nullptr;
+	}
+
+	// Returns the list of a key (which must have one). It stays valid until the next list is opened
+	// or the arena is compacted.
+	inline Range List(const uint64_t key) const {
+		const uint64_t *offset = index.Find(key);
+		Assert(offset != nullptr);
+		Range range;
+		range.First = data.data() + *offset + HeaderSize;
+		range.Last = range.First + data[*offset];
+		return range;
+	}
+
+	// Erase the list of a key (which must have one).
+	inline void Erase(const uint64_t key) {
+		const uint64_t *offset = index.Find(key);
+		Assert(offset != nullptr);
+		Assert(*offset != openOffset);
+		numErased += HeaderSize + data[*offset];
+		index.Erase(key);
+	}
+
+	// Moves the lists left to the front of the array if the erased ones take up half of it. No list
+	// may be open.
+	inline void Compact() {
+		Assert(openOffset == NoOffset);
+		if (2 * numErased < data.size()) return;
+		uint64_t to = 0;
+		for (uint64_t from = 0; from < data.size(); ) {
+			const uint64_t length = HeaderSize + data[from];
+			const uint64_t key = static_cast<uint64_t>(data[from + 1]) | (static_cast<uint64_t>(data[from + 2]) << 32);
+			uint64_t *offset = index.Find(key);
+			if (offset != nullptr && *offset == from) {
+				if (to != from) copy(data.begin() + from, data.begin() + from + length, data.begin() + to);
+				*offset = to;
+				to += length;
+			}
+			from += length;
+		}
+		data.resize(to);
+		numErased = 0;
+	}
+
+private:
+
+	// Each list starts with its length and the two halves of its key.
+	static const uint64_t HeaderSize = 3;
+	static const uint64_t NoOffset = UINT64_MAX;
+
+	// The lists, and their offsets by key.
+	vector<uint32_t> data;
+	FlatMap<uint64_t> index;
+
+	// The offset of the open list (NoOffset if none), and the number of entries of erased lists.
+	uint64_t openOffset;
+	Types::SizeType numErased;
+};
+
+}
+}
@@ -0,0 +1,198 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#include <Windows.h>
+#else
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+
+namespace Platform {
+
+// A temporary file of a fixed size, mapped into memory and initialized to zero. The operating system
+// pages it in and out, so it can be larger than the main memory. The file is removed when it is
+// closed (or when the process ends).
+class MappedFile {
+public:
+
+	// Hints for the paging of a range.
+	enum AccessPattern {
+		NORMAL_ACCESS,
+		RANDOM_ACCESS, // no read-ahead.
+		SEQUENTIAL_ACCESS, // aggressive read-ahead, early eviction behind.
+		WILL_NEED, // start reading the range.
+		DONT_NEED // the range can be evicted (after being written back).
+	};
+
+	MappedFile() : data(nullptr), numBytes(0)
+#if defined(_WIN32) || defined(__CYGWIN__)
+		, fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL)
+#endif
+	{}
+
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	// Creates a temporary file of n bytes in the directory and maps it. Returns false on failure.
+	bool Create(const string directory, const Types::SizeType n) {
+		Close();
+		numBytes = n;
+#if defined(_WIN32) || defined(__CYGWIN__)
+		char name[MAX_PATH];
+		if (GetTempFileNameA(directory.c_str(), "skm", 0, name) == 0) {
+			cerr << "ERROR: Could not create a temporary file in '" << directory << "': " << GetLastError() << endl;
+			return false;
+		}
+		filename = name;
+		fileHandle = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+		if (fileHandle == INVALID_HANDLE_VALUE) {
+			cerr << "ERROR: Could not open '" << filename << "': " << GetLastError() << endl;
+			return false;
+		}
+		mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READWRITE, static_cast<DWORD>(uint64_t(n) >> 32), static_cast<DWORD>(n), NULL);
+		if (mappingHandle == NULL) {
+			cerr << "ERROR: Could not create a mapping of '" << filename << "': " << GetLastError() << endl;
+			Close();
+			return false;
+		}
+		data = static_cast<char*>(MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+		if (data == nullptr) {
+			cerr << "ERROR: Could not map '" << filename << "': " << GetLastError() << endl;
+			Close();
+			return false;
+		}
+#else
+		filename = directory + "/skim-XXXXXX";
+		const int fd = mkstemp(&filename[0]);
+		if (fd < 0) {
+			cerr << "ERROR: Could not create a temporary file in '" << directory << "': " << strerror(errno) << endl;
+			return false;
+		}
+		unlink(filename.c_str()); // the mapping keeps the file alive.
+		if (ftruncate(fd, static_cast<off_t>(n)) != 0) {
+			cerr << "ERROR: Could not resize '" << filename << "' to " << n << " bytes: " << strerror(errno) << endl;
+			close(fd);
+			return false;
+		}
+		void *address = n > 0 ? mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : nullptr;
+		close(fd);
+		if (address == MAP_FAILED) {
+			cerr << "ERROR: Could not map '" << filename << "': " << strerror(errno) << endl;
+			return false;
+		}
+		data = static_cast<char*>(address);
+#endif
+		return true;
+	}
+
+	// Unmaps and removes the file.
+	void Close() {
+#if defined(_WIN32) || defined(__CYGWIN__)
+		if (data != nullptr) UnmapViewOfFile(data);
+		if (mappingHandle != NULL) CloseHandle(mappingHandle);
+		if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+		mappingHandle = NULL;
+		fileHandle = INVALID_HANDLE_VALUE;
+#else
+		if (data != nullptr) munmap(data, numBytes);
+#endif
+		data = nullptr;
+		numBytes = 0;
+	}
+
+	// Access the mapped bytes.
+	inline bool IsOpen() const { return data != nullptr; }
+	inline char *Data() const { return data; }
+	inline Types::SizeType NumBytes() const { return numBytes; }
+	inline const string &Filename() const { return filename; }
+
+	// Gives the paging hint for the bytes [offset, offset+n) (extended to whole pages).
+	void Advise(const Types::SizeType offset, const Types::SizeType n, const AccessPattern pattern) {
+		Assert(offset + n <= numBytes);
+		if (n == 0) return;
+#if defined(_WIN32) || defined(__CYGWIN__)
+		// Windows only knows prefetching and unlocking of ranges.
+		if (pattern == WILL_NEED) {
+			WIN32_MEMORY_RANGE_ENTRY range;
+			range.VirtualAddress = data + offset;
+			range.NumberOfBytes = n;
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+		else if (pattern == DONT_NEED) {
+			VirtualUnlock(data + offset, n);
+		}
+#else
+		const Types::SizeType begin = PageBegin(offset);
+		const int advice = pattern == RANDOM_ACCESS ? MADV_RANDOM : pattern == SEQUENTIAL_ACCESS ? MADV_SEQUENTIAL :
+			pattern == WILL_NEED ? MADV_WILLNEED : pattern == DONT_NEED ? MADV_DONTNEED : MADV_NORMAL;
+		madvise(data + begin, offset + n - begin, advice);
+#endif
+	}
+
+	// Starts writing back the modified pages of [offset, offset+n) without waiting, such that they
+	// can be evicted without stalling a later page fault.
+	void Flush(const Types::SizeType offset, const Types::SizeType n) {
+		Assert(offset + n <= numBytes);
+		if (n == 0) return;
+#if defined(_WIN32) || defined(__CYGWIN__)
+		FlushViewOfFile(data + offset, n);
+#else
+		const Types::SizeType begin = PageBegin(offset);
+		msync(data + begin, offset + n - begin, MS_ASYNC);
+#endif
+	}
+
+private:
+
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+	// The offset of the page holding the byte at offset.
+	static inline Types::SizeType PageBegin(const Types::SizeType offset) {
+		static const Types::SizeType pageSize = static_cast<Types::SizeType>(sysconf(_SC_PAGESIZE));
+		return offset - offset % pageSize;
+	}
+#endif
+
+	// The mapped bytes.
+	char *data;
+	Types::SizeType numBytes;
+
+	// The name of the file.
+	string filename;
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE fileHandle;
+	HANDLE mappingHandle;
+#endif
+};
+
+}
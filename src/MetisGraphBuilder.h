@@ -31,8 +31,9 @@ using namespace std;
 namespace RawData {
 
 // Build a metis graph directly into a fast unweighted graph.
+// Returns false (after an error message) if the file cannot be read completely.
 template<typename graphType>
-void BuildMetisGraph(const string inFilename, graphType &outGraph, const bool ignoreSelfLoops, const bool transpose, const bool directed, const bool buildIncomingArcs, const bool removeParallelArcs, const bool verbose) {
+bool BuildMetisGraph(const string inFilename, graphType &outGraph, const bool ignoreSelfLoops, const bool transpose, const bool directed, const bool buildIncomingArcs, const bool buildOutgoingArcs, const bool removeParallelArcs, const bool verbose) {
 	typedef typename graphType::VertexIdType vertexIdType;
 	// Get the file size of the input filestream.
 	Types::SizeType fileSize = IO::FileSize(inFilename);
@@ -40,6 +41,10 @@ void BuildMetisGraph(const string inFilename, graphType &outGraph, const bool ig
 	// Open the input file as a stream.
 	IO::FileStream inStream;
 	inStream.OpenForReading(inFilename);
+	if (!inStream.IsOpen()) {
+		cerr << "ERROR: Could not open '" << inFilename << "'." << endl;
+		return false;
+	}
 
 	// Create timer and progress bar.
 	if (verbose) cout << "Streaming from " << inFilename << " (" << (fileSize / 1024.0 / 1024.0) << " MiB): " << endl;
@@ -111,6 +116,10 @@ void BuildMetisGraph(const string inFilename, graphType &outGraph, const bool ig
 		}
 	}
 	bar.Finish();
+	if (inStream.Failed()) {
+		cerr << "ERROR: Could not read all of '" << inFilename << "'." << endl;
+		return false;
+	}
 
 	// Remove parallel arcs?
 	if (removeParallelArcs) {
@@ -131,13 +140,14 @@ void BuildMetisGraph(const string inFilename, graphType &outGraph, const bool ig
 	const string identifier = Platform::SharedMemoryManager::GetIdentifierFromFilename(inFilename);
 
 	// Build the graph.
-	outGraph.BuildFromArcList(identifier, numVertices, arcs, directed, buildIncomingArcs, verbose);
+	outGraph.BuildFromArcList(identifier, numVertices, arcs, directed, buildIncomingArcs, buildOutgoingArcs, verbose);
+	return true;
 }
 
 
-// Stream a graph.
+// Stream a graph. Returns false (after an error message) if the file cannot be read completely.
 template<typename graphType>
-void StreamMetisGraph(const string inFilename, const string outFilename, const bool ignoreSelfLoops, const bool undirected, const bool transpose, const bool verbose) {
+bool StreamMetisGraph(const string inFilename, const string outFilename, const bool ignoreSelfLoops, const bool undirected, const bool transpose, const bool verbose) {
 	// Get the file size of the input filestream.
 	Types::SizeType fileSize = IO::FileSize(inFilename);
 
@@ -147,6 +157,10 @@ void StreamMetisGraph(const string inFilename, const string outFilename, const b
 	// Open the input file as a stream.
 	IO::FileStream inStream;
 	inStream.OpenForReading(inFilename);
+	if (!inStream.IsOpen()) {
+		cerr << "ERROR: Could not open '" << inFilename << "'." << endl;
+		return false;
+	}
 
 	// Create a new graph stream.
 	graphStreamType outStream;
@@ -220,12 +234,17 @@ void StreamMetisGraph(const string inFilename, const string outFilename, const b
 		}
 	}
 	bar.Finish();
+	if (inStream.Failed()) {
+		cerr << "ERROR: Could not read all of '" << inFilename << "'." << endl;
+		return false;
+	}
 
 	// Close graph stream.
 	outStream.Close();
 
 	// Dump statistics.
 	if (verbose) outStream.DumpStatistics(cout);
+	return true;
 }
 
 
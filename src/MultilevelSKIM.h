@@ -0,0 +1,206 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+#include "FastStaticGraphs.h"
+#include "BitVector.h"
+#include "Timer.h"
+#include "FileStream.h"
+#include "Coarsening.h"
+#include "SKIM.h"
+
+namespace Algorithms {
+namespace InfluenceMaximization {
+
+// Coarsen-then-refine SKIM for large graphs. The vertices are clustered by label propagation and
+// the clusters contracted into a coarse graph, weighted by their sizes. SKIM on the coarse graph picks
+// regionsPerSeed*N clusters, and SKIM on the original graph then picks the N seeds among the vertices
+// of these clusters only: its sketches are built on the subgraph induced by the candidates, while the
+// exact influences of the seeds (and thus the greedy coverage) are computed on the whole graph.
+// Optionally, plain SKIM runs on the same instances for comparison.
+class MultilevelSKIM {
+public:
+
+	// Type definitions.
+	typedef SKIM::GraphType GraphType;
+	typedef SKIM::SeedType SeedType;
+
+	// Default constructor.
+	MultilevelSKIM(GraphType &g, const uint32_t s, const bool v) :
+		verbose(v),
+		randomSeed(s),
+		graph(g),
+		binaryProbability(0.1),
+		maxClusterSize(64),
+		numRounds(10),
+		regionsPerSeed(4)
+	{}
+
+	// Set the binary probability.
+	inline void SetBinaryProbability(const double prob) {
+		binaryProbability = prob;
+	}
+
+	// Set the maximum number of vertices per cluster, the number of label propagation rounds, and the
+	// number of clusters selected on the coarse graph per seed.
+	inline void SetCoarsening(const uint32_t clusterSize, const uint32_t rounds, const uint32_t regions) {
+		maxClusterSize = max<uint32_t>(clusterSize, 1);
+		numRounds = rounds;
+		regionsPerSeed = max<uint32_t>(regions, 1);
+	}
+
+	// Computes N seeds with the k and l of SKIM, using numt threads. If lEval is set, the seeds are
+	// evaluated exactly on lEval instances (not measured in the running time). If compare is set, plain
+	// SKIM runs as well, and its time and spread are reported next to the multilevel ones.
+	template<SKIM::ModelType modelType>
+	vector<SeedType> Run(uint32_t N, const uint16_t k, const uint16_t l, const uint16_t lEval, const int32_t numt, const bool compare, const string statsFilename = "", const string coverageFilename = "") {
+		if (N == 0 || N > graph.NumVertices()) N = static_cast<uint32_t>(graph.NumVertices());
+		Platform::Timer timer; timer.Start();
+
+		// Coarsen.
+		vector<uint32_t> clusters, weights;
+		const uint32_t numClusters = DataStructures::Graphs::LabelPropagation(graph, numRounds, maxClusterSize, numt, clusters, verbose);
+		GraphType coarse;
+		DataStructures::Graphs::Contract(graph, clusters, numClusters, coarse, weights, numt, verbose);
+		const double coarsenMilliseconds = timer.LiveElapsedMilliseconds();
+
+		// Select regions on the coarse graph.
+		const uint32_t numRegions = static_cast<uint32_t>(min<uint64_t>(static_cast<uint64_t>(regionsPerSeed) * N, numClusters));
+		if (verbose) cout << "Selecting " << numRegions << " regions on the coarse graph:" << endl;
+		SKIM coarseSkim(coarse, randomSeed, verbose);
+		coarseSkim.SetBinaryProbability(binaryProbability);
+		coarseSkim.SetVertexWeights(&weights);
+		const vector<SeedType> regions = coarseSkim.Run<modelType>(numRegions, k, l, 0, numt);
+		DataStructures::Container::BitVector selected(numClusters), candidates(graph.NumVertices());
+		for (const SeedType &region : regions) selected.Set(region.VertexId);
+		uint64_t numCandidates = 0;
+		FORALL_VERTICES(graph, u) {
+			if (!selected[clusters[u]]) continue;
+			candidates.Set(u);
+			++numCandidates;
+		}
+		const double regionsMilliseconds = timer.LiveElapsedMilliseconds() - coarsenMilliseconds;
+
+		// Refine on the original graph.
+		if (verbose) cout << "Selecting " << N << " seeds among " << numCandidates << " candidates:" << endl;
+		SKIM fineSkim(graph, randomSeed, verbose);
+		fineSkim.SetBinaryProbability(binaryProbability);
+		fineSkim.SetCandidates(&candidates);
+		vector<SeedType> seedSet = fineSkim.Run<modelType>(N, k, l, 0, numt, "", coverageFilename);
+		const double totalMilliseconds = timer.LiveElapsedMilliseconds();
+		const double refineMilliseconds = totalMilliseconds - coarsenMilliseconds - regionsMilliseconds;
+
+		// Run plain SKIM for comparison.
+		vector<SeedType> plainSeedSet;
+		double plainMilliseconds(0);
+		if (compare) {
+			if (verbose) cout << "Running plain SKIM for comparison:" << endl;
+			timer.Start();
+			SKIM plainSkim(graph, randomSeed, verbose);
+			plainSkim.SetBinaryProbability(binaryProbability);
+			plainSeedSet = plainSkim.Run<modelType>(N, k, l, 0, numt);
+			plainMilliseconds = timer.LiveElapsedMilliseconds();
+		}
+
+		// Evaluate the seeds on the same instances.
+		double exinf(0), plainExinf(0);
+		if (lEval > 0) {
+			SKIM evaluator(graph, randomSeed, verbose);
+			evaluator.SetBinaryProbability(binaryProbability);
+			exinf = evaluator.EvaluateSeeds<modelType>(seedSet, lEval);
+			if (compare) plainExinf = evaluator.EvaluateSeeds<modelType>(plainSeedSet, lEval);
+		}
+
+		const double n = static_cast<double>(graph.NumVertices());
+		cout << "Multilevel SKIM." << endl
+			<< "Random seed: " << randomSeed << "." << endl
+			<< "Clusters: " << numClusters << " (at most " << maxClusterSize << " vertices), " << coarse.NumArcs() / 2 << " arcs." << endl
+			<< "Regions selected: " << regions.size() << ", candidates: " << numCandidates << " (" << (100.0*numCandidates / n) << " %)." << endl
+			<< "Number of seed vertices computed: " << seedSet.size() << "." << endl
+			<< "Time coarsening: " << coarsenMilliseconds / 1000.0 << " sec, regions: " << regionsMilliseconds / 1000.0 << " sec, refinement: " << refineMilliseconds / 1000.0 << " sec." << endl
+			<< "Total time: " << totalMilliseconds / 1000.0 << " sec." << endl;
+		if (lEval > 0)
+			cout << "Exact spread of solution: " << exinf << " (" << (100.0*exinf / n) << " %)." << endl;
+		if (compare) {
+			cout << "Plain SKIM time: " << plainMilliseconds / 1000.0 << " sec (speedup " << plainMilliseconds / max(totalMilliseconds, 1.0) << ")." << endl;
+			if (lEval > 0)
+				cout << "Plain SKIM exact spread: " << plainExinf << " (" << (100.0*plainExinf / n) << " %), multilevel reaches " << (plainExinf > 0 ? 100.0*exinf / plainExinf : 100.0) << " % of it." << endl;
+		}
+
+		if (!statsFilename.empty()) {
+			IO::FileStream file;
+			file.OpenNewForWriting(statsFilename);
+			if (file.IsOpen()) {
+				stringstream ss;
+				ss << "NumberOfVertices = " << graph.NumVertices() << endl
+					<< "NumberOfArcs = " << graph.NumArcs() / 2 << endl
+					<< "NumberOfClusters = " << numClusters << endl
+					<< "MaxClusterSize = " << maxClusterSize << endl
+					<< "NumberOfRegions = " << regions.size() << endl
+					<< "NumberOfCandidates = " << numCandidates << endl
+					<< "CoarsenElapsedMilliseconds = " << coarsenMilliseconds << endl
+					<< "RegionsElapsedMilliseconds = " << regionsMilliseconds << endl
+					<< "RefineElapsedMilliseconds = " << refineMilliseconds << endl
+					<< "TotalElapsedMilliseconds = " << totalMilliseconds << endl
+					<< "TotalExactInfluence = " << exinf << endl;
+				if (compare) {
+					ss << "PlainElapsedMilliseconds = " << plainMilliseconds << endl
+						<< "PlainTotalExactInfluence = " << plainExinf << endl;
+				}
+				ss << "NumberOfSeedVertices = " << seedSet.size() << endl;
+				double sumExactInfluence(0.0);
+				for (Types::IndexType i = 0; i < seedSet.size(); ++i) {
+					sumExactInfluence += seedSet[i].ExactInfluence;
+					ss << i << "_EstimatedInfluence = " << seedSet[i].EstimatedInfluence << endl
+						<< i << "_MarginalExactInfluence = " << seedSet[i].ExactInfluence << endl
+						<< i << "_CumulativeExactInfluence = " << sumExactInfluence << endl
+						<< i << "_VertexId = " << seedSet[i].VertexId << endl;
+				}
+				file.WriteString(ss.str());
+			}
+		}
+		return seedSet;
+	}
+
+protected:
+
+	// Whether to print output.
+	bool verbose;
+
+	// The random seed of the instances.
+	uint32_t randomSeed;
+
+	// The graph.
+	GraphType &graph;
+
+	// The binary probability.
+	double binaryProbability;
+
+	// The coarsening parameters.
+	uint32_t maxClusterSize;
+	uint32_t numRounds;
+	uint32_t regionsPerSeed;
+};
+
+}
+}
@@ -26,14 +26,32 @@ THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <random>
 #include <climits>
 #include <algorithm>
+#include <memory>
+#include <functional>
+#include <omp.h>
 using namespace std;
 
 #include "FastStaticGraphs.h"
 #include "Macros.h"
 #include "Timer.h"
 #include "FastSet.h"
+#include "Traversal.h"
 #include "Permutations.h"
 #include "RangeExtraction.h"
+#include "FileStream.h"
+#include "Split.h"
+#include "Conversion.h"
+#include "BitOperations.h"
+#include "EntityIO.h"
+#include "AlignedKHeap.h"
+#include "SortedMerge.h"
+#include "BitVector.h"
+#include "HubAdjacency.h"
+#include "AccessProfile.h"
+#include "SketchStore.h"
+#include "HashPair.h"
+#include "AllocationTracker.h"
+#include "Introspection.h"
 
 namespace std {
 	template<>
@@ -71,16 +89,17 @@ public:
 		binprob(resolution / 10),
 		triprob{ { resolution / 10, resolution / 100, resolution / 1000 } },
 		searchSpace(graph.NumVertices()),
-		levels(graph.NumVertices(), UINT32_MAX),
 		twisty(s),
+		preprocessingElapsedMilliseconds(0),
 		sketchSize(0),
+		snapshotBatch(0),
 		verbose(v)
 	{
 		cout << "Computing in-degrees... " << flush;
-		// Compute the degrees.
+		// Compute the degrees from the incoming arcs, which also works if only those are built.
 		FORALL_ARCS(graph, vertexId, arc) {
-			if (!arc->Forward()) continue;
-			++indeg[arc->OtherVertexId()];
+			if (!arc->Backward()) continue;
+			++indeg[vertexId];
 		}
 		cout << "done." << endl;
 	}
@@ -90,6 +109,49 @@ public:
 	inline void SetBinaryProbability(const double prob) {
 		binprob = uint32_t(prob * double(resolution));
 	}
+
+	// Represent the neighborhoods of vertices with at least threshold arcs (in either direction)
+	// additionally as bitmaps (zero turns this off). This does not change the results.
+	inline void SetHubThreshold(const Types::SizeType threshold) {
+		cout << "Building hub bitmaps (threshold " << threshold << ")... " << flush;
+		forwardHubs.Build(graph, Types::FORWARD_DIRECTION, threshold);
+		backwardHubs.Build(graph, Types::BACKWARD_DIRECTION, threshold);
+		cout << "done." << endl;
+		if (verbose) forwardHubs.DumpStatistics(cout);
+		if (verbose) backwardHubs.DumpStatistics(cout);
+	}
+
+	// Count the vertex visits of the preprocessing and exact influence BFSes in a profile (nullptr turns this off).
+	inline void SetProfile(Tools::AccessProfile *p) {
+		profile = p;
+		if (profile == nullptr) return;
+		preprocessingPhase = profile->Phase("oracle preprocessing", Types::BACKWARD_DIRECTION);
+		influencePhase = profile->Phase("oracle influence", Types::FORWARD_DIRECTION);
+	}
+
+	// Keep sketches only for the candidate vertices in the next preprocessing (nullptr keeps all).
+	// The searches still prune at every vertex, which only needs the number of ranks it got in the
+	// current instance, so the other vertices cost a sketch id and a counter. Only sets of candidates
+	// can be estimated afterwards.
+	inline void SetCandidates(const DataStructures::Container::BitVector *c) {
+		candidates = c;
+	}
+
+	// Measure influence on the targets only (nullptr turns this off), e.g., a region or an audience.
+	// Ranks are drawn from the target/instance pairs only, so the reverse BFSes start at targets, and
+	// there are |T|*l instead of n*l of them. The estimates and the exact influence count targets.
+	// This applies to the next preprocessing and the exact evaluation; index files keep the targets.
+	void SetTargets(const DataStructures::Container::BitVector *t) {
+		targetVertices.clear();
+		targetFlags = DataStructures::Container::BitVector(t != nullptr ? graph.NumVertices() : 0);
+		if (t == nullptr) return;
+		FORALL_VERTICES(graph, u) {
+			if (!(*t)[u]) continue;
+			targetFlags.Set(u);
+			targetVertices.push_back(u);
+		}
+		Assert(!targetVertices.empty());
+	}
 	
 	// This runs a specific query, once the preprocessing is established.
 	// It returns the estimated influence of the vertex set S.
@@ -100,13 +162,20 @@ public:
 
 	// This runs random queries of varying size ranges.
 	// This assumes that sketches have already been computed.
+	// If lEval is zero, the exact influence is not evaluated (e.g., if outgoing arcs are not built).
 	template<ModelType modelType>
 	void Run(const string seedSizeRange, const SeedMethodType method, const uint16_t numQueries, const uint16_t k, const uint16_t l, const uint16_t lEval, const string statsFilename) {
 		vector<Types::IndexType> seedSetSizes = Tools::ExtractRange(seedSizeRange);
 		
 		// Set up random number generator.
-		vector<uint32_t> S;
-		uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(method == UNIFORM ? graph.NumVertices() : graph.NumArcs())-1);
+		vector<vector<uint32_t>> queries(numQueries);
+		vector<double> exactInfluences(numQueries, 0.0);
+		if (HasCandidateSketches() && method != UNIFORM) {
+			cerr << "ERROR: Sketches are kept for candidates only, which supports uniform seed sets only." << endl;
+			return;
+		}
+		const size_t numSeedVertices = HasCandidateSketches() ? sketchVertices.size() : graph.NumVertices();
+		uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(method == UNIFORM ? numSeedVertices : graph.NumArcs())-1);
 
 		// Initiate some statistics.
 		stringstream stats;
@@ -118,15 +187,20 @@ public:
 			<< "SeedGenerator = " << method << endl
 			<< "SeedSizeRange = " << seedSizeRange << endl
 			<< "TotalSketchesSize = " << sketchSize << endl
-			<< "TotalSketchesBytes = " << sketchSize * sizeof(uint64_t) << endl
+			<< "TotalSketchesBytes = " << sketchSize * (HasHIPSketches() ? 2 : 1) * sizeof(uint64_t) << endl
+			<< "HIPSketches = " << HasHIPSketches() << endl
+			<< "NumberOfTargets = " << NumRankVertices() << endl
+			<< "NumberOfSketches = " << (HasCandidateSketches() ? sketchVertices.size() : graph.NumVertices()) << endl
+			<< "IndexBytes = " << IndexBytes() << endl
 			<< "NumberOfSeedSetSizes = " << seedSetSizes.size() << endl;
 
 		// Iterate all ranges.
 		Platform::Timer timer;
+		const uint16_t estimatorAllocations = Tools::AllocationTracker::Phase("Oracle estimator");
 		for (Types::IndexType seedSetSizeIndex = 0; seedSetSizeIndex < seedSetSizes.size(); ++seedSetSizeIndex) {
 			const Types::IndexType N = seedSetSizes[seedSetSizeIndex];
 			//Z.reserve(N*k);
-			sourceZ.reserve(N*k + 1); destZ.reserve(N*k + 1);
+			sourceZ.reserve(N*k + 3); destZ.reserve(N*k + 3); // the merges swap them, and need room for three more.
 			sourceI.reserve(N + 1); destI.reserve(N + 1);
 			cout << "Running " << numQueries << " queries with seed set size " << N << "... " << flush;
 			
@@ -134,20 +208,38 @@ public:
 				stats << seedSetSizeIndex << "_SeedSetSize = " << N << endl;
 
 			double averageError(0), averageEstimatedInfluence(0), averageExactInfluence(0), averageEstimatorElapsedMilliseconds(0), averageExactElapsedMilliseconds(0);
+			double averageHIPError(0), averageHIPEstimatedInfluence(0);
+
+			// Compute N random seed vertices for every query.
+			for (uint32_t q = 0; q < numQueries; ++q) {
+				queries[q].clear();
+				GenerateSeetSet(queries[q], N, method, dist);
+				Assert(queries[q].size() == N);
+			}
+
+			// Run the exact algorithm on batches of queries. The time is split evenly among the queries of a batch.
+			double exactElapsedMilliseconds = 0.0;
+			if (lEval > 0) {
+				timer.Start();
+				ComputeInfluenceBatch<modelType>(queries, lEval, exactInfluences);
+				exactElapsedMilliseconds = timer.LiveElapsedMilliseconds() / double(numQueries);
+			}
+
 			for (uint32_t q = 0; q < numQueries; ++q) {
-				// Compute N random seed vertices.
-				S.clear();
-				GenerateSeetSet(S, N, method, dist);
-				Assert(S.size() == N);
+				const vector<uint32_t> &S = queries[q];
 				
-				// Run estimator and exact algorithm.
+				// Run estimator.
 				timer.Start();
+				const uint16_t previousAllocations = Tools::AllocationTracker::SetPhase(estimatorAllocations);
 				const double estimatedInfluence = Estimator(S, k, l);
+				Tools::AllocationTracker::SetPhase(previousAllocations);
 				const double estimatorElapsedMilliseconds = timer.LiveElapsedMilliseconds();
-				timer.Start();
-				const double exactInfluence = ComputeInfluence<modelType>(S, lEval);
-				const double exactElapsedMilliseconds = timer.LiveElapsedMilliseconds();
-				const double error = abs(estimatedInfluence - exactInfluence) / exactInfluence;
+				const double exactInfluence = exactInfluences[q];
+				const double error = lEval > 0 ? abs(estimatedInfluence - exactInfluence) / exactInfluence : 0.0;
+				const double hipEstimatedInfluence = HasHIPSketches() ? HIPEstimator(S, l) : 0.0;
+				const double hipError = lEval > 0 ? abs(hipEstimatedInfluence - exactInfluence) / exactInfluence : 0.0;
+				averageHIPError += hipError;
+				averageHIPEstimatedInfluence += hipEstimatedInfluence;
 				//cout << "est=" << estimatedInfluence << ", ex=" << exactInfluence << ", err=" << error << endl;
 				averageError += error;
 				averageEstimatedInfluence += estimatedInfluence;
@@ -169,6 +261,9 @@ public:
 						<< seedSetSizeIndex << "_" << q << "_Error = " << error << endl
 						<< seedSetSizeIndex << "_" << q << "_EstimatorElapsedMilliseconds = " << estimatorElapsedMilliseconds << endl
 						<< seedSetSizeIndex << "_" << q << "_ExactElapsedMilliseconds = " << exactElapsedMilliseconds << endl;
+					if (HasHIPSketches())
+						stats << seedSetSizeIndex << "_" << q << "_HIPEstimatedInfluence = " << hipEstimatedInfluence << endl
+						<< seedSetSizeIndex << "_" << q << "_HIPError = " << hipError << endl;
 				}
 			}
 			averageError /= double(numQueries);
@@ -176,14 +271,24 @@ public:
 			averageExactInfluence /= double(numQueries);
 			averageEstimatorElapsedMilliseconds /= double(numQueries);
 			averageExactElapsedMilliseconds /= double(numQueries);
-			cout << "done (est=" << averageEstimatedInfluence << ", ex=" << averageExactInfluence << ", err=" << averageError << ", test=" << setprecision(5) << averageEstimatorElapsedMilliseconds << "ms, tex=" << averageExactElapsedMilliseconds << "ms)." << endl;
+			averageHIPError /= double(numQueries);
+			averageHIPEstimatedInfluence /= double(numQueries);
+			cout << "done (est=" << averageEstimatedInfluence << ", ex=" << averageExactInfluence << ", err=" << averageError;
+			if (HasHIPSketches())
+				cout << ", hip=" << averageHIPEstimatedInfluence << ", errhip=" << averageHIPError;
+			cout << ", test=" << setprecision(5) << averageEstimatorElapsedMilliseconds << "ms, tex=" << averageExactElapsedMilliseconds << "ms)." << endl;
 			if (!statsFilename.empty())
 				stats << seedSetSizeIndex << "_AverageEstimatedInfluence = " << averageEstimatedInfluence << endl
 				<< seedSetSizeIndex << "_AverageExactInfluence = " << averageExactInfluence << endl
 				<< seedSetSizeIndex << "_AverageError = " << averageError << endl
 				<< seedSetSizeIndex << "_AverageEstimatorElapsedMilliseconds = " << averageEstimatorElapsedMilliseconds << endl
 				<< seedSetSizeIndex << "_AverageExactElapsedMilliseconds = " << averageExactElapsedMilliseconds << endl;
+			if (!statsFilename.empty() && HasHIPSketches())
+				stats << seedSetSizeIndex << "_AverageHIPEstimatedInfluence = " << averageHIPEstimatedInfluence << endl
+				<< seedSetSizeIndex << "_AverageHIPError = " << averageHIPError << endl;
 		}
+		Tools::AllocationTracker::DumpStatistics(cout);
+		Tools::AllocationTracker::WriteStatistics(stats);
 
 		if (!statsFilename.empty()) {
 			cout << "Attempting to write statistics to " << statsFilename << "... " << flush;
@@ -198,17 +303,18 @@ public:
 
 
 	// This is the estimator: S is the seed set of vertex ids. Based on sorting a vector.
+	// If HIP sketches are built, the current bottom-k sketch is the first k entries of each sketch.
 	vector<pair<uint64_t, uint64_t>> sourceZ, destZ;
 	vector<size_t> sourceI, destI;
 	double Estimator(const vector<uint32_t> &S, const uint16_t k, const uint16_t l) {
 		sourceI.clear();
 		sourceZ.clear();
-		const uint64_t sentinelRank = graph.NumVertices()*l;
+		const uint64_t sentinelRank = NumRankVertices()*l;
 		// Collect rank and taus.
 		for (const uint32_t s : S) {
-			const vector<uint64_t> &sketch = sketches[s];
-			const size_t num = sketch.size() == k ? sketch.size() - 1 : sketch.size();
-			const uint64_t tau = sketch.size() == k ? sketch.back() : (graph.NumVertices()*l);
+			const vector<uint64_t> &sketch = Sketch(s);
+			const size_t num = sketch.size() >= k ? k - 1 : sketch.size();
+			const uint64_t tau = sketch.size() >= k ? sketch[k - 1] : sentinelRank;
 			sourceI.push_back(sourceZ.size());
 			for (size_t i = 0; i < num; ++i) {
 				sourceZ.push_back(make_pair(sketch[i], tau));
@@ -217,77 +323,425 @@ public:
 		}
 		sourceI.push_back(sourceZ.size()); // sentinel
 
+		return MergeAndAccumulate(sourceZ, sourceI, destZ, destI, sentinelRank)*NumRankVertices();
+	}
+
+
+	// This is the HIP estimator: S is the seed set of vertex ids. Each rank that ever entered
+	// the sketch of a seed vertex carries its HIP threshold, i.e., the inclusion threshold
+	// conditioned on all other ranks. A rank is in the union of the historic sketches iff it
+	// is below the largest of its thresholds, hence the same merge as above applies.
+	double HIPEstimator(const vector<uint32_t> &S, const uint16_t l) {
+		Assert(!hipThresholds.empty());
+		sourceI.clear();
+		sourceZ.clear();
+		const uint64_t sentinelRank = NumRankVertices()*l;
+		// Collect ranks and thresholds.
+		for (const uint32_t s : S) {
+			const vector<uint64_t> &sketch = Sketch(s);
+			const vector<uint64_t> &thresholds = HIPThresholds(s);
+			Assert(sketch.size() == thresholds.size());
+			sourceI.push_back(sourceZ.size());
+			for (size_t i = 0; i < sketch.size(); ++i) {
+				sourceZ.push_back(make_pair(sketch[i], thresholds[i]));
+			}
+			sourceZ.push_back(make_pair(sentinelRank, 0));
+		}
+		sourceI.push_back(sourceZ.size()); // sentinel
+
+		return MergeAndAccumulate(sourceZ, sourceI, destZ, destI, sentinelRank)*NumRankVertices();
+	}
+
+	// An immutable version of the combined sketches of the first NumInstances of NumTotalInstances instances.
+	typedef DataStructures::Container::SketchStore::Version SketchSnapshot;
+
+	// This is called after each published snapshot (from the thread running the preprocessing, which
+	// may use the snapshot during the call without pinning it).
+	typedef function<void(const SketchSnapshot&)> SnapshotCallbackType;
+
+	// Publish a snapshot after every batch of instances during preprocessing (zero turns this off),
+	// and call the callback (if any) for each of them.
+	inline void SetProgressiveSnapshots(const uint16_t batch, SnapshotCallbackType callback = SnapshotCallbackType()) {
+		snapshotBatch = batch;
+		snapshotCallback = callback;
+	}
+
+	// The versioned store of published snapshots. Query threads pin the latest snapshot with
+	// Snapshots().Pin(reader) at any time; their queries see it unchanged until they unpin.
+	inline DataStructures::Container::SketchStore &Snapshots() { return snapshots; }
+
+	// Publishes the current sketches (of the first numInstances of l instances) as a new snapshot,
+	// e.g. after reading a newer index. Only the changed sketches are copied. The snapshot holds the
+	// sketches by id (see SetCandidates and CompactSketches), with the sketch ids of the vertices.
+	inline const SketchSnapshot &PublishSnapshot(const uint16_t numInstances, const uint16_t l) {
+		return snapshots.Publish(sketches, hipThresholds, numInstances, l, sketchIds);
+	}
+
+	// This is the estimator on a snapshot. The ranks of the l' included instances are drawn from the
+	// same space of n*l ranks, so the inverse taus estimate the number of reachable pairs in these
+	// instances; the average over l' instances is the estimate scaled by l/l'. Its coefficient of
+	// variation is still at most 1/sqrt(k-2), but it averages fewer instances (hence the wider error
+	// bars early on). Unlike Estimator, this only uses local buffers, so it is thread-safe.
+	double SnapshotEstimator(const SketchSnapshot &snapshot, const vector<uint32_t> &S, const uint16_t k, const bool hip = false) const {
+		Assert(snapshot.NumInstances > 0);
+		Assert(!hip || snapshot.HasHIPThresholds());
+		vector<pair<uint64_t, uint64_t>> localSourceZ, localDestZ;
+		vector<size_t> localSourceI, localDestI;
+		const uint64_t sentinelRank = NumRankVertices()*snapshot.NumTotalInstances;
+		for (const uint32_t s : S) {
+			Assert(HasSketch(s));
+			const vector<uint64_t> &sketch = snapshot.Sketch(s);
+			const size_t num = hip ? sketch.size() : (sketch.size() >= k ? k - 1 : sketch.size());
+			const uint64_t tau = sketch.size() >= k ? sketch[k - 1] : sentinelRank;
+			localSourceI.push_back(localSourceZ.size());
+			for (size_t i = 0; i < num; ++i) {
+				localSourceZ.push_back(make_pair(sketch[i], hip ? snapshot.HIPThresholds(s)[i] : tau));
+			}
+			localSourceZ.push_back(make_pair(sentinelRank, 0));
+		}
+		localSourceI.push_back(localSourceZ.size()); // sentinel
+		const double estimate = MergeAndAccumulate(localSourceZ, localSourceI, localDestZ, localDestI, sentinelRank)*NumRankVertices();
+		return estimate*(double(snapshot.NumTotalInstances) / double(snapshot.NumInstances));
+	}
+
+	// Returns the sketch of vertex u (with all historic entries, if HIP sketches are built).
+	inline const vector<uint64_t> &Sketch(const uint32_t u) const {
+		Assert(HasSketch(u));
+		return sketchIds.empty() ? sketches[u] : sketches[sketchIds[u]];
+	}
+
+	// Returns the HIP thresholds of the sketch entries of vertex u.
+	inline const vector<uint64_t> &HIPThresholds(const uint32_t u) const { return sketchIds.empty() ? hipThresholds[u] : hipThresholds[sketchIds[u]]; }
+
+	// Returns the number of vertices that ranks are drawn for (the targets, if any), and test whether u is one.
+	inline uint64_t NumRankVertices() const { return targetVertices.empty() ? graph.NumVertices() : targetVertices.size(); }
+	inline bool IsTarget(const uint32_t u) const { return targetVertices.empty() || targetFlags[u]; }
+
+	// Test whether vertex u has a sketch (all vertices do, unless sketches are kept for candidates only).
+	inline bool HasSketch(const uint32_t u) const { return sketchIds.empty() || sketchIds[u] != NoSketch; }
+
+	// Test whether sketches are kept for candidates only, and access these vertices (in increasing order).
+	inline bool HasCandidateSketches() const { return !sketchVertices.empty(); }
+	inline const vector<uint32_t> &SketchVertices() const { return sketchVertices; }
+
+	// Returns the memory of the sketches, their HIP thresholds, and the sketch ids (if any).
+	Types::SizeType IndexBytes() const {
+		Types::SizeType bytes = (sketches.capacity() + hipThresholds.capacity()) * sizeof(vector<uint64_t>)
+			+ (sketchIds.capacity() + sketchVertices.capacity()) * sizeof(uint32_t);
+		for (const vector<uint64_t> &sketch : sketches) bytes += sketch.capacity() * sizeof(uint64_t);
+		for (const vector<uint64_t> &thresholds : hipThresholds) bytes += thresholds.capacity() * sizeof(uint64_t);
+		return bytes;
+	}
+
+	// This stores identical sketches (with identical HIP thresholds) only once: vertices map to the
+	// ids of the distinct sketches, which all queries look up transparently. The sketches are hashed
+	// with numt threads. Preprocessing again expands them first. Returns the number of sketches stored.
+	// Does nothing if the sketches are compacted already, or kept for candidates only. Keeps the direct
+	// layout (ratio 1) if no sketches are identical, or the ids would cost more than the duplicates.
+	size_t CompactSketches(const int32_t numt = 1) {
+		if (!sketchIds.empty() || sketches.empty()) return sketches.size();
+		cout << "Deduplicating sketches... " << flush;
+		Platform::Timer timer; timer.Start();
+		const int numVertices = static_cast<int>(graph.NumVertices());
+		vector<pair<size_t, uint32_t>> hashes(numVertices);
+#pragma omp parallel for num_threads(numt) schedule(dynamic, 1024)
+		for (int u = 0; u < numVertices; ++u) {
+			size_t hash = sketches[u].size();
+			for (const uint64_t rank : sketches[u]) hash_combine(hash, rank);
+			if (HasHIPSketches())
+				for (const uint64_t threshold : hipThresholds[u]) hash_combine(hash, threshold);
+			hashes[u] = make_pair(hash, static_cast<uint32_t>(u));
+		}
+		sort(hashes.begin(), hashes.end());
+
+		// Map each vertex to the first vertex with the same sketch, among those with the same hash.
+		vector<uint32_t> representative(numVertices);
+		for (size_t begin = 0, end = 0; begin < hashes.size(); begin = end) {
+			while (end < hashes.size() && hashes[end].first == hashes[begin].first) ++end;
+			for (size_t i = begin; i < end; ++i) {
+				const uint32_t u = hashes[i].second;
+				representative[u] = u;
+				for (size_t j = begin; j < i; ++j) {
+					const uint32_t v = hashes[j].second;
+					if (representative[v] == v && sketches[v] == sketches[u] && (!HasHIPSketches() || hipThresholds[v] == hipThresholds[u])) {
+						representative[u] = v;
+						break;
+					}
+				}
+			}
+		}
+
+		// Compare the memory of both layouts before changing anything.
+		uint64_t numEntries(0), numDistinctEntries(0);
+		size_t numDistinct(0);
+		for (uint32_t u = 0; u < static_cast<uint32_t>(numVertices); ++u) {
+			numEntries += sketches[u].size();
+			if (representative[u] != u) continue;
+			numDistinctEntries += sketches[u].size();
+			++numDistinct;
+		}
+		const uint64_t entryBytes = HasHIPSketches() ? 16 : 8;
+		const uint64_t bytes = numEntries * entryBytes + numVertices * sizeof(vector<uint64_t>) * (HasHIPSketches() ? 2 : 1);
+		const uint64_t distinctBytes = numDistinctEntries * entryBytes + numDistinct * sizeof(vector<uint64_t>) * (HasHIPSketches() ? 2 : 1) + numVertices * sizeof(uint32_t);
+		if (numDistinct == static_cast<size_t>(numVertices) || distinctBytes >= bytes) {
+			cout << "done (" << numDistinct << " distinct of " << numVertices << " sketches, ratio 1, kept " << (bytes / 1024.0 / 1024.0)
+				<< " MiB, " << timer.LiveElapsedMilliseconds() << "ms)." << endl;
+			return sketches.size();
+		}
+
+		// Keep the sketches of the representatives (which precede the vertices they represent).
+		vector<vector<uint64_t>> distinctSketches, distinctThresholds;
+		distinctSketches.reserve(numDistinct);
+		if (HasHIPSketches()) distinctThresholds.reserve(numDistinct);
+		sketchIds.resize(numVertices);
+		for (uint32_t u = 0; u < static_cast<uint32_t>(numVertices); ++u) {
+			if (representative[u] != u) {
+				sketchIds[u] = sketchIds[representative[u]];
+				continue;
+			}
+			sketchIds[u] = static_cast<uint32_t>(distinctSketches.size());
+			distinctSketches.push_back(move(sketches[u]));
+			if (HasHIPSketches()) distinctThresholds.push_back(move(hipThresholds[u]));
+		}
+		sketches.swap(distinctSketches);
+		if (HasHIPSketches()) hipThresholds.swap(distinctThresholds);
+		cout << "done (" << sketches.size() << " distinct of " << numVertices << " sketches, ratio " << (double(numVertices) / double(sketches.size()))
+			<< ", " << (bytes / 1024.0 / 1024.0) << " MiB -> " << (distinctBytes / 1024.0 / 1024.0) << " MiB, " << timer.LiveElapsedMilliseconds() << "ms)." << endl;
+		return sketches.size();
+	}
+
+	// Test whether identical sketches are stored once.
+	inline bool HasCompactSketches() const { return !sketchIds.empty() && !HasCandidateSketches(); }
+
+	// Returns the time spent on building (or reading) the sketches.
+	inline double PreprocessingElapsedMilliseconds() const { return preprocessingElapsedMilliseconds; }
+
+	// Test whether HIP sketches have been computed.
+	inline bool HasHIPSketches() const { return !hipThresholds.empty(); }
+
+	// The estimated influences of two seed sets A and B, of their union and of their intersection
+	// (the vertices both reach), and the Jaccard similarity of the latter two.
+	struct OverlapType {
+		double InfluenceA = 0;
+		double InfluenceB = 0;
+		double Union = 0;
+		double Intersection = 0;
+		double Jaccard = 0;
+	};
+
+	// This estimates the overlap of the influence of A and B from the sketches, without any BFS. The
+	// influences and the union are those of the estimator (on A, B, and A+B); the intersection is
+	// unbiased as well, but its relative error grows as the overlap gets small. Thread-safe.
+	OverlapType EstimateOverlap(const vector<uint32_t> &A, const vector<uint32_t> &B, const uint16_t k, const uint16_t l) const {
+		vector<pair<uint64_t, uint64_t>> a, b;
+		MergedSketch(A, k, NumRankVertices()*l, a);
+		MergedSketch(B, k, NumRankVertices()*l, b);
+		return EstimateOverlap(a, b);
+	}
+
+	// This estimates the pairwise overlaps of many seed sets in parallel. The merged sketch of each
+	// set is computed once. Returns the overlap of sets i and j in overlaps[i*sets.size()+j].
+	void EstimateOverlaps(const vector<vector<uint32_t>> &sets, const uint16_t k, const uint16_t l, const int32_t numt, vector<OverlapType> &overlaps) const {
+		const int numSets = static_cast<int>(sets.size());
+		vector<vector<pair<uint64_t, uint64_t>>> merged(numSets);
+		overlaps.assign(sets.size()*sets.size(), OverlapType());
+#pragma omp parallel num_threads(numt)
+		{
+#pragma omp for schedule(dynamic, 16)
+			for (int i = 0; i < numSets; ++i)
+				MergedSketch(sets[i], k, NumRankVertices()*l, merged[i]);
+#pragma omp for schedule(dynamic, 1)
+			for (int i = 0; i < numSets; ++i) {
+				for (int j = i; j < numSets; ++j) {
+					OverlapType &overlap = overlaps[size_t(i)*numSets + j];
+					overlap = EstimateOverlap(merged[i], merged[j]);
+					OverlapType &mirrored = overlaps[size_t(j)*numSets + i];
+					mirrored = overlap;
+					swap(mirrored.InfluenceA, mirrored.InfluenceB);
+				}
+			}
+		}
+	}
+
+
+protected:
+
+	// This merges the (rank, tau) chunks collected in sourceZ/sourceI, keeping the larger
+	// tau for ranks in multiple chunks. Returns the sum of inverse taus.
+	// The chunks are merged pairwise in rounds; sourceI.back() is the number of valid entries
+	// of sourceZ, which keeps its size (as does destZ) to avoid reinitialization.
+	static double MergeAndAccumulate(vector<pair<uint64_t, uint64_t>> &sourceZ, vector<size_t> &sourceI, vector<pair<uint64_t, uint64_t>> &destZ, vector<size_t> &destI, const uint64_t sentinelRank) {
+		MergeChunks(sourceZ, sourceI, destZ, destI);
+
+		// Accumulate estimate (without the sentinel).
+		Assert(sourceI.back() > 0);
+		Assert(sourceZ[sourceI.back() - 1].first == sentinelRank);
+		(void)sentinelRank; // only checked in debug builds.
+		double estimate = 0;
+		for (size_t i = 0; i + 1 < sourceI.back(); ++i) {
+			estimate += 1.0 / double(sourceZ[i].second);
+		}
+		return estimate;
+	}
+
+	// This merges the chunks as above, leaving the single merged chunk (ending with the sentinel)
+	// in the first sourceI.back() entries of sourceZ.
+	static void MergeChunks(vector<pair<uint64_t, uint64_t>> &sourceZ, vector<size_t> &sourceI, vector<pair<uint64_t, uint64_t>> &destZ, vector<size_t> &destI) {
 		// Merge while there are things to merge.
 		Assert(sourceI.size() >= 2);
 		while (sourceI.size() > 2) {
-			//cout << " " << sourceZ.size() << flush;
+			if (destZ.size() < sourceI.back() + 3)
+				destZ.resize(sourceI.back() + 3); // room for the vectorized merge.
 			const size_t num = sourceI.size() - 1;
+			size_t numDest = 0;
 			for (uint64_t i = 0; i < num; i += 2) {
-				destI.push_back(destZ.size());
-				const auto beginZ = sourceZ.begin();
-				auto first1 = beginZ + sourceI[i];
-				auto last1 = beginZ + sourceI[i + 1];
+				destI.push_back(numDest);
+				const size_t size1 = sourceI[i + 1] - sourceI[i];
 
 				// In case only one more chunk is left, copy it to destZ.
 				if ((i + 1) == num) {
-					destZ.insert(destZ.end(), first1, last1);
+					copy(sourceZ.begin() + sourceI[i], sourceZ.begin() + sourceI[i + 1], destZ.begin() + numDest);
+					numDest += size1;
 					continue;
 				}
 
-				// Otherwise merge the i'th with the i+1st chunk into destZ.
-				Assert((i + 2) < num);
-				auto first2 = last1;
-				auto last2 = beginZ + sourceI[i + 2];
-				while (true) {
-					if (first1->first < first2->first) { destZ.push_back(*first1); ++first1; }
-					else if (first2->first < first1->first) { destZ.push_back(*first2); ++first2; }
-					else if (first1->second > first2->second) { destZ.push_back(*first1); ++first1; ++first2; }
-					else { 
-						destZ.push_back(*first2); 
-						if (first1->first == sentinelRank)
-							break;
-						++first1; ++first2;
-					}
-				}
+				// Otherwise merge the i'th with the i+1st chunk into destZ. The sentinels merge into one.
+				const size_t size2 = sourceI[i + 2] - sourceI[i + 1];
+				numDest += Tools::MergeUniqueMaxPayload(&sourceZ[sourceI[i]], size1, &sourceZ[sourceI[i + 1]], size2, &destZ[numDest]);
 			}
-			destI.push_back(destZ.size()); // sentinel
+			destI.push_back(numDest); // sentinel
 
 			sourceI.swap(destI);
 			sourceZ.swap(destZ);
 			destI.clear();
-			destZ.clear();
 		}
+	}
 
-		// Accumulate estimate.
-		Assert(!sourceZ.empty());
-		sourceZ.pop_back();
-		double estimate = 0;
-		for (const pair<uint64_t, uint64_t> &z : sourceZ) {
-			estimate += 1.0 / double(z.second);
+	// This computes the merged sketch of S: its ranks with the largest tau of a seed vertex whose
+	// sketch contains them, in increasing order of rank and followed by the sentinel.
+	void MergedSketch(const vector<uint32_t> &S, const uint16_t k, const uint64_t sentinelRank, vector<pair<uint64_t, uint64_t>> &merged) const {
+		vector<pair<uint64_t, uint64_t>> localDestZ;
+		vector<size_t> localSourceI, localDestI;
+		merged.clear();
+		for (const uint32_t s : S) {
+			const vector<uint64_t> &sketch = Sketch(s);
+			const size_t num = sketch.size() >= k ? k - 1 : sketch.size();
+			const uint64_t tau = sketch.size() >= k ? sketch[k - 1] : sentinelRank;
+			localSourceI.push_back(merged.size());
+			for (size_t i = 0; i < num; ++i) {
+				merged.push_back(make_pair(sketch[i], tau));
+			}
+			merged.push_back(make_pair(sentinelRank, 0));
+		}
+		if (S.empty()) merged.push_back(make_pair(sentinelRank, 0));
+		localSourceI.push_back(merged.size()); // sentinel
+		if (localSourceI.size() > 2) MergeChunks(merged, localSourceI, localDestZ, localDestI);
+		merged.resize(localSourceI.back());
+	}
+
+	// This estimates the overlap of the merged sketches of two seed sets in one pass. A rank of
+	// both is seen by both sets iff it is below the smaller of the two taus, hence it contributes
+	// the inverse of that to the intersection; the union takes the larger one, like the estimator.
+	OverlapType EstimateOverlap(const vector<pair<uint64_t, uint64_t>> &a, const vector<pair<uint64_t, uint64_t>> &b) const {
+		double influenceA(0), influenceB(0), intersection(0), unionSum(0);
+		size_t i = 0, j = 0;
+		while (i + 1 < a.size() || j + 1 < b.size()) { // stop at the sentinels.
+			if (a[i].first == b[j].first) {
+				influenceA += 1.0 / double(a[i].second);
+				influenceB += 1.0 / double(b[j].second);
+				intersection += 1.0 / double(min(a[i].second, b[j].second));
+				unionSum += 1.0 / double(max(a[i].second, b[j].second));
+				++i; ++j;
+			}
+			else if (a[i].first < b[j].first) {
+				influenceA += 1.0 / double(a[i].second);
+				unionSum += 1.0 / double(a[i].second);
+				++i;
+			}
+			else {
+				influenceB += 1.0 / double(b[j].second);
+				unionSum += 1.0 / double(b[j].second);
+				++j;
+			}
 		}
-		return estimate*graph.NumVertices();
+		const double n = double(NumRankVertices());
+		OverlapType overlap;
+		overlap.InfluenceA = influenceA * n;
+		overlap.InfluenceB = influenceB * n;
+		overlap.Union = unionSum * n;
+		overlap.Intersection = intersection * n;
+		overlap.Jaccard = overlap.Union > 0 ? overlap.Intersection / overlap.Union : 0.0;
+		return overlap;
 	}
 
 
+public:
+
 	// This precomputes the sketches.
+	// If hip is set, every rank that enters a sketch is kept together with its HIP threshold.
+	// The instances are the (rank independent) insertion order: a rank of instance i enters
+	// the sketch of u iff it is among the k smallest of instances 0..i, and its threshold is
+	// then the (k+1)-smallest rank of instances 0..i (or n*l if there are at most k). For this,
+	// the local sketches keep k+1 ranks per instance.
+	// With candidates (see SetCandidates), only the candidates get (local) sketches; the other vertices
+	// count their ranks of the current instance, which is all the pruning needs.
 	template<ModelType modelType>
-	void RunPreprocessing(const uint16_t k, const uint16_t l) {
-		// Allocate data structures.
+	void RunPreprocessing(const uint16_t k, const uint16_t l, const bool hip = false) {
+		// Allocate data structures (expanding compacted sketches).
 		cout << "Allocating data structures... " << flush;
-		sketches.resize(graph.NumVertices()); // the sketches.
-		vector<vector<uint64_t>> localSketches(graph.NumVertices()); // These are the temporary sketches (per instances).
+		bool restricted = candidates != nullptr;
+		if (restricted || HasCandidateSketches()) {
+			// Sketches of candidates are not extended, but built from scratch (as are the ones after them).
+			vector<vector<uint64_t>>().swap(sketches);
+			vector<vector<uint64_t>>().swap(hipThresholds);
+			vector<uint32_t>().swap(sketchIds);
+			vector<uint32_t>().swap(sketchVertices);
+		}
+		if (HasCompactSketches()) {
+			vector<vector<uint64_t>> vertexSketches(graph.NumVertices()), vertexThresholds(HasHIPSketches() ? graph.NumVertices() : 0);
+			FORALL_VERTICES(graph, u) {
+				vertexSketches[u] = Sketch(u);
+				if (HasHIPSketches()) vertexThresholds[u] = HIPThresholds(u);
+			}
+			sketches.swap(vertexSketches);
+			hipThresholds.swap(vertexThresholds);
+			sketchIds.clear();
+		}
+		if (restricted) {
+			sketchIds.assign(graph.NumVertices(), NoSketch);
+			FORALL_VERTICES(graph, u) {
+				if (!(*candidates)[u]) continue;
+				sketchIds[u] = static_cast<uint32_t>(sketchVertices.size());
+				sketchVertices.push_back(u);
+			}
+			Assert(!sketchVertices.empty());
+			restricted = sketchVertices.size() < graph.NumVertices();
+			if (!restricted) { // all vertices are candidates.
+				vector<uint32_t>().swap(sketchIds);
+				vector<uint32_t>().swap(sketchVertices);
+			}
+		}
+		const size_t numSketches = restricted ? sketchVertices.size() : graph.NumVertices();
+		sketches.resize(numSketches); // the sketches.
+		if (hip) hipThresholds.resize(numSketches); // the HIP thresholds of the sketch entries.
+		const size_t localK = hip ? size_t(k) + 1 : size_t(k); // the size of local sketches.
+		Assert(localK <= UINT16_MAX);
+		vector<vector<uint64_t>> localSketches(numSketches); // These are the temporary sketches (per instances).
+		vector<uint16_t> localCounts(restricted ? graph.NumVertices() : 0); // the sizes of the local sketches of all vertices (with candidates).
 		vector<uint64_t> permutation;
 		DataStructures::Container::FastSet<uint32_t> &S = searchSpace; // The search space of the bfs.
-		Tools::GenerateRandomPermutation(permutation, static_cast<uint64_t>(graph.NumVertices()*l), randomSeed);
+		const BackwardTraversal backward(graph, backwardHubs);
+		const uint64_t numRankVertices = NumRankVertices(); // the vertices to draw ranks for (the targets, if any).
+		Tools::GenerateRandomPermutation(permutation, static_cast<uint64_t>(numRankVertices*l), randomSeed);
 		cout << "done." << endl;
 
 		// Group vertex/instance pairs by instance.
 		vector<vector<pair<uint64_t, uint32_t>>> instanceRanks(l);
 		cout << "Grouping ranks by instance... " << flush;
 		for (uint64_t r = 0; r < permutation.size(); ++r) {
-			const uint16_t i = uint16_t(permutation[r] / graph.NumVertices());
+			const uint16_t i = uint16_t(permutation[r] / numRankVertices);
 			Assert(i < l);
-			const uint32_t u = uint32_t(permutation[r] % graph.NumVertices());
+			const uint32_t u = targetVertices.empty() ? uint32_t(permutation[r] % numRankVertices) : targetVertices[permutation[r] % numRankVertices];
 			Assert(u < graph.NumVertices());
 			instanceRanks[i].push_back(pair<uint64_t, uint32_t>(r, u));
 		}
@@ -297,84 +751,749 @@ public:
 
 		// Compute combined bottom-k rank sketches over all l instances.
 		cout << "Attempting to compute combined bottom-k reachablility sketches... " << flush;
+		const uint16_t sketchAllocations = Tools::AllocationTracker::Phase("Oracle sketches");
+		const uint16_t mergeAllocations = Tools::AllocationTracker::Phase("Oracle merge");
+		const uint16_t previousAllocations = Tools::AllocationTracker::SetPhase(sketchAllocations);
 		Platform::Timer timer; timer.Start();
+		vector<uint64_t> Z(k + localK + 3), T; // the merge buffers, which keep their memory across the instances.
+		Platform::Timer instanceTimer;
+		Tools::ProgressCounters numSearches, numVisited;
+		Tools::RecentTimings instanceTimings;
+
+		// Writes the progress and the memory of the structures to a snapshot (see Tools::Introspection).
+		auto writeSnapshot = [&](ostream &os) {
+			os << "  Instances finished: " << numSearches.Sum() / numRankVertices << " of " << l << ", searches in the next: " << numSearches.Sum() % numRankVertices << " of " << numRankVertices
+				<< ", entries after the last merge: " << sketchSize << endl
+				<< "  Current instance: " << instanceTimer.LiveElapsedMilliseconds() << " ms" << endl;
+			instanceTimings.Write(os, "Recent instances");
+			numSearches.Write(os, "Searches");
+			numVisited.Write(os, "Vertices visited");
+			Types::SizeType sketchBytes(0), thresholdBytes(0), localBytes(0), rankBytes(0);
+			for (const vector<pair<uint64_t, uint32_t>> &ranks : instanceRanks) rankBytes += ranks.capacity() * sizeof(pair<uint64_t, uint32_t>);
+			for (size_t s = 0; s < numSketches; ++s) {
+				sketchBytes += sketches[s].capacity() * sizeof(uint64_t);
+				localBytes += localSketches[s].capacity() * sizeof(uint64_t);
+				if (hip) thresholdBytes += hipThresholds[s].capacity() * sizeof(uint64_t);
+			}
+			os << "  Memory:" << endl;
+			Tools::Introspection::WriteMemory(os, "Sketches", sketchBytes + sketches.capacity() * sizeof(vector<uint64_t>));
+			Tools::Introspection::WriteMemory(os, "HIP thresholds", thresholdBytes + hipThresholds.capacity() * sizeof(vector<uint64_t>));
+			Tools::Introspection::WriteMemory(os, "Local sketches", localBytes + localSketches.capacity() * sizeof(vector<uint64_t>));
+			if (restricted) Tools::Introspection::WriteMemory(os, "Sketch ids and counters", (sketchIds.capacity() + sketchVertices.capacity()) * sizeof(uint32_t) + localCounts.capacity() * sizeof(uint16_t));
+			Tools::Introspection::WriteMemory(os, "Ranks by instance", rankBytes);
+			Tools::Introspection::WriteMemory(os, "Search space", S.MemoryBytes());
+			Tools::Introspection::WriteMemory(os, "Merge buffers", (Z.capacity() + T.capacity()) * sizeof(uint64_t));
+		};
+
 		for (uint16_t i = 0; i < l; ++i) {
 			if (verbose) cout << " " << i << flush;
-			Assert(instanceRanks[i].size() == graph.NumVertices());
-			for (uint32_t j = 0; j < uint32_t(graph.NumVertices()); ++j) {
+			instanceTimer.Start();
+			Assert(instanceRanks[i].size() == numRankVertices);
+			for (uint32_t j = 0; j < uint32_t(numRankVertices); ++j) {
 				const uint64_t rank = instanceRanks[i][j].first;
 				const uint32_t sourceVertexId = instanceRanks[i][j].second;
 
 				// Run a BFS from source vertex in instance i.
 				S.Clear();
 				S.Insert(sourceVertexId);
-				uint32_t ind = 0;
-				while (ind < S.Size()) {
-					uint32_t u = S.KeyByIndex(ind++);
-					vector<uint64_t> &Y = localSketches[u];
+				backward.Run(S, DataStructures::Graphs::NothingBlocked(), InstanceCoin<modelType>(*this, i, l), [&](const uint32_t u) {
+					if (!restricted) {
+						vector<uint64_t> &Y = localSketches[u];
 
-					// Prune if the sketch at u exceeds size k.
-					if (Y.size() >= k)
-						continue;
-
-					// Insert rank into sketch of u.
-					Y.push_back(rank);
+						// Prune if the sketch at u exceeds size k.
+						if (Y.size() >= localK)
+							return DataStructures::Graphs::SKIP_ARCS;
 
-					// Arc expansion.
-					FORALL_INCIDENT_ARCS_BACKWARD(graph, u, a) {
-						if (!a->Backward()) break;
-						const uint32_t v = a->OtherVertexId();
-						if (Contained<modelType>(v, u, i, l) && !S.IsContained(v))
-							S.Insert(v);
+						// Insert rank into sketch of u.
+						Y.push_back(rank);
 					}
-				}
+					else {
+						// Same as above, but only candidates keep the ranks.
+						if (localCounts[u] >= localK)
+							return DataStructures::Graphs::SKIP_ARCS;
+						++localCounts[u];
+						if (sketchIds[u] != NoSketch) localSketches[sketchIds[u]].push_back(rank);
+					}
+					if (profile != nullptr) profile->Visit(0, preprocessingPhase, u);
+					return DataStructures::Graphs::SCAN_ARCS;
+				});
+				numSearches.Add(0);
+				numVisited.Add(0, S.Size());
+				if (Tools::Introspection::Requested()) Tools::Introspection::Write("oracle preprocessing", writeSnapshot);
 			}
 			if (verbose) cout << "m" << flush;
+			Tools::AllocationTracker::SetPhase(mergeAllocations);
 
-			// Merge local sketches into the global sketches.
-			vector<uint64_t> Z;
+			// Merge local sketches into the global sketches. These grow geometrically up to k entries, so
+			// the merges stop allocating once the sketches are (nearly) full.
+			// With candidates, the sketches are those of the candidates (and the counters restart).
 			sketchSize = 0;
-			FORALL_VERTICES(graph, u) {
-				vector<uint64_t> &X = sketches[u];
-				vector<uint64_t> &Y = localSketches[u];
-				Z.resize(X.size()+Y.size(), 0);
-				Z.resize(set_union(X.begin(), X.end(), Y.begin(), Y.end(), Z.begin()) - Z.begin()); // merge X and Y, erasing duplicates.
-				if (Z.size() > k) Z.resize(k); // trim.
-				sketchSize += Z.size();
-				X.swap(Z); // copy new values from Z to X.
-				Y.clear(); // erase local sketch to make room for next instance.
+			if (restricted) fill(localCounts.begin(), localCounts.end(), 0);
+			if (!hip) {
+				for (size_t u = 0; u < numSketches; ++u) {
+					vector<uint64_t> &X = sketches[u];
+					vector<uint64_t> &Y = localSketches[u];
+					if (Y.empty()) {
+						sketchSize += X.size();
+						continue;
+					}
+					Z.resize(max(Z.size(), X.size() + Y.size() + 3));
+					const size_t size = min<size_t>(Tools::MergeUnique(X.data(), X.size(), Y.data(), Y.size(), Z.data()), k); // merge X and Y, erasing duplicates, and trim.
+					if (size > X.capacity()) X.reserve(min<size_t>(k, 2 * size));
+					X.assign(Z.begin(), Z.begin() + size); // copy new values from Z to X.
+					sketchSize += size;
+					Y.clear(); // erase local sketch to make room for next instance.
+				}
+			}
+			else {
+				const uint64_t sentinelRank = NumRankVertices()*l;
+				for (size_t u = 0; u < numSketches; ++u) {
+					vector<uint64_t> &X = sketches[u];
+					vector<uint64_t> &H = hipThresholds[u];
+					vector<uint64_t> &Y = localSketches[u];
+					if (!Y.empty()) {
+						// Determine the (k+1)-smallest rank of the current sketch and the local sketch.
+						const size_t numCurrent = min(X.size(), size_t(k));
+						Z.resize(max(Z.size(), numCurrent + Y.size() + 3));
+						const size_t numMerged = Tools::MergeUnique(X.data(), numCurrent, Y.data(), Y.size(), Z.data());
+						const uint64_t threshold = numMerged > k ? Z[k] : sentinelRank;
+
+						// Ranks of Y below the threshold enter the sketch. They are smaller than all
+						// ranks that have been evicted before, so only the first k entries are merged.
+						Z.clear();
+						T.clear();
+						size_t x = 0, y = 0;
+						while (x < numCurrent || (y < Y.size() && Y[y] < threshold)) {
+							if (y == Y.size() || Y[y] >= threshold || (x < numCurrent && X[x] < Y[y])) {
+								Z.push_back(X[x]); T.push_back(H[x]); ++x;
+							}
+							else {
+								Z.push_back(Y[y]); T.push_back(threshold); ++y;
+							}
+						}
+						Z.insert(Z.end(), X.begin() + numCurrent, X.end());
+						T.insert(T.end(), H.begin() + numCurrent, H.end());
+						if (Z.size() > X.capacity()) {
+							X.reserve(2 * Z.size());
+							H.reserve(2 * Z.size());
+						}
+						X.assign(Z.begin(), Z.end());
+						H.assign(T.begin(), T.end());
+						Y.clear();
+					}
+					sketchSize += X.size();
+				}
 			}
 			if (verbose) cout << "d" << flush;
+			Tools::AllocationTracker::SetPhase(sketchAllocations);
+			instanceTimings.Add(instanceTimer.LiveElapsedMilliseconds());
+			if (Tools::Introspection::Requested()) Tools::Introspection::Write("oracle preprocessing", writeSnapshot);
+
+			// Publish a snapshot of the instances finished so far?
+			if (snapshotBatch > 0 && ((i + 1) % snapshotBatch == 0 || i + 1 == l)) {
+				const SketchSnapshot &publishedSnapshot = PublishSnapshot(i + 1, l);
+				if (verbose) cout << "s" << flush;
+				if (snapshotCallback) snapshotCallback(publishedSnapshot);
+			}
 		}
 		preprocessingElapsedMilliseconds = timer.LiveElapsedMilliseconds();
+		Tools::AllocationTracker::SetPhase(previousAllocations);
 		cout << endl << "Finished in " << Tools::MillisecondsToString(preprocessingElapsedMilliseconds) << endl;
+		if (restricted) cout << "Kept " << numSketches << " sketches of candidates (" << (IndexBytes() / 1024.0 / 1024.0) << " MiB)." << endl;
+	}
+
+
+	// This writes the sketches (and HIP thresholds, if any) to a binary index file, such that queries
+	// can be answered later without rebuilding them. Vertices without a sketch (see SetCandidates) have
+	// the size NoSketch. The targets (if any) follow the flags. Returns false if the file cannot be written.
+	template<ModelType modelType>
+	bool SaveIndex(const string filename, const uint16_t k, const uint16_t l) {
+		IO::FileStream file;
+		file.OpenNewForWriting(filename);
+		if (!file.IsOpen()) {
+			cerr << "ERROR: Could not open index file '" << filename << "' for writing." << endl;
+			return false;
+		}
+		cout << "Writing index to " << filename << "... " << flush;
+		IO::WriteEntity<uint32_t>(file, IndexFileMagic);
+		IO::WriteEntity<uint64_t>(file, graph.NumVertices());
+		IO::WriteEntity<uint16_t>(file, k);
+		IO::WriteEntity<uint16_t>(file, l);
+		IO::WriteEntity<uint32_t>(file, randomSeed);
+		IO::WriteEntity<uint8_t>(file, static_cast<uint8_t>(modelType));
+		IO::WriteEntity<uint32_t>(file, binprob);
+		IO::WriteEntity<uint8_t>(file, (HasHIPSketches() ? IndexHIPFlag : 0) | (targetVertices.empty() ? 0 : IndexTargetsFlag));
+		if (!targetVertices.empty()) {
+			IO::WriteEntity<uint64_t>(file, targetVertices.size());
+			file.Write(reinterpret_cast<const char*>(targetVertices.data()), targetVertices.size()*sizeof(uint32_t));
+		}
+		FORALL_VERTICES(graph, u) {
+			if (!HasSketch(u)) {
+				IO::WriteEntity<uint32_t>(file, NoSketch);
+				continue;
+			}
+			const vector<uint64_t> &sketch = Sketch(u);
+			IO::WriteEntity<uint32_t>(file, static_cast<uint32_t>(sketch.size()));
+			file.Write(reinterpret_cast<const char*>(sketch.data()), sketch.size()*sizeof(uint64_t));
+			if (HasHIPSketches())
+				file.Write(reinterpret_cast<const char*>(HIPThresholds(u).data()), sketch.size()*sizeof(uint64_t));
+		}
+		file.Close();
+		cout << "done (" << sketchSize << " entries)." << endl;
+		return true;
+	}
+
+
+	// This reads the sketches from an index file written by SaveIndex, and sets k and l to the
+	// values used to build them. The index must belong to the same graph, random seed, and model
+	// (and binary probability). Returns false if it does not, or if the file is truncated or corrupt.
+	template<ModelType modelType>
+	bool LoadIndex(const string filename, uint16_t &k, uint16_t &l) {
+		IO::FileStream file;
+		file.OpenForReading(filename);
+		if (!file.IsOpen()) {
+			cerr << "ERROR: Could not open index file '" << filename << "'." << endl;
+			return false;
+		}
+		cout << "Reading index from " << filename << "... " << flush;
+		Platform::Timer timer; timer.Start();
+		bool complete = true;
+		auto read = [&](void *target, const size_t numBytes) {
+			complete = complete && file.Read(reinterpret_cast<char*>(target), numBytes) && !file.Failed();
+			return complete;
+		};
+		uint32_t magic(0), seed(0), probability(0);
+		uint64_t numVertices(0);
+		uint8_t model(0), flags(0);
+		read(&magic, sizeof(magic));
+		read(&numVertices, sizeof(numVertices));
+		read(&k, sizeof(k));
+		read(&l, sizeof(l));
+		read(&seed, sizeof(seed));
+		read(&model, sizeof(model));
+		read(&probability, sizeof(probability));
+		if (!read(&flags, sizeof(flags)) || magic != IndexFileMagic) {
+			cerr << endl << "ERROR: '" << filename << "' is not an index file (of this version)." << endl;
+			return false;
+		}
+		const bool hip = (flags & IndexHIPFlag) != 0;
+		if (numVertices != graph.NumVertices() || seed != randomSeed) {
+			cerr << endl << "ERROR: The index in '" << filename << "' does not match the graph or random seed." << endl;
+			return false;
+		}
+		if (model != static_cast<uint8_t>(modelType) || (modelType == BINARY && probability != binprob)) {
+			cerr << endl << "ERROR: The index in '" << filename << "' was built with a different model or binary probability." << endl;
+			return false;
+		}
+		if (k == 0 || l == 0) {
+			cerr << endl << "ERROR: The index in '" << filename << "' has k=" << k << " and l=" << l << "." << endl;
+			return false;
+		}
+		SetTargets(nullptr);
+		if (flags & IndexTargetsFlag) {
+			uint64_t numTargets(0);
+			read(&numTargets, sizeof(numTargets));
+			if (complete && numTargets > graph.NumVertices()) {
+				cerr << endl << "ERROR: The index in '" << filename << "' has " << numTargets << " targets, but the graph has only " << graph.NumVertices() << " vertices." << endl;
+				return false;
+			}
+			vector<uint32_t> ids(complete ? numTargets : 0);
+			if (!read(ids.data(), ids.size()*sizeof(uint32_t))) {
+				cerr << endl << "ERROR: The index file '" << filename << "' is truncated." << endl;
+				return false;
+			}
+			DataStructures::Container::BitVector flagged(graph.NumVertices());
+			for (const uint32_t u : ids) {
+				if (u >= graph.NumVertices()) {
+					cerr << endl << "ERROR: The index in '" << filename << "' has the target " << u << ", but the graph has only " << graph.NumVertices() << " vertices." << endl;
+					return false;
+				}
+				flagged.Set(u);
+			}
+			SetTargets(&flagged);
+		}
+		// The sketch ids are dropped again if all vertices have a sketch. A combined sketch has at
+		// most k entries, a HIP sketch at most k per instance.
+		const uint32_t maxSize = hip ? uint32_t(k)*l : k;
+		sketchIds.assign(graph.NumVertices(), NoSketch);
+		sketchVertices.clear();
+		sketches.clear();
+		hipThresholds.clear();
+		sketchSize = 0;
+		FORALL_VERTICES(graph, u) {
+			uint32_t size(0);
+			if (!read(&size, sizeof(size))) break;
+			if (size == NoSketch) continue;
+			if (size > maxSize) {
+				cerr << endl << "ERROR: The sketch of vertex " << u << " in '" << filename << "' has " << size << " entries (at most " << maxSize << " expected)." << endl;
+				return false;
+			}
+			sketchIds[u] = static_cast<uint32_t>(sketches.size());
+			sketchVertices.push_back(u);
+			sketches.emplace_back(size);
+			vector<uint64_t> &sketch = sketches.back();
+			if (!read(sketch.data(), sketch.size()*sizeof(uint64_t))) break;
+			if (hip) {
+				hipThresholds.emplace_back(size);
+				if (!read(hipThresholds.back().data(), sketch.size()*sizeof(uint64_t))) break;
+			}
+			sketchSize += sketch.size();
+		}
+		if (!complete) {
+			cerr << endl << "ERROR: The index file '" << filename << "' is truncated." << endl;
+			return false;
+		}
+		if (sketchVertices.size() == graph.NumVertices()) {
+			vector<uint32_t>().swap(sketchIds);
+			vector<uint32_t>().swap(sketchVertices);
+		}
+		file.Close();
+		preprocessingElapsedMilliseconds = timer.LiveElapsedMilliseconds();
+		cout << "done (k=" << k << ", l=" << l << ", " << sketchSize << " entries, " << Tools::MillisecondsToString(preprocessingElapsedMilliseconds) << ")." << endl;
+		return true;
+	}
+
+
+	// This answers the queries of a file, which contains one seed set per line (vertex ids separated by commas).
+	// If estimate is set, the (precomputed) sketches are used. Otherwise, the exact influence is computed
+	// on lEval instances, which requires outgoing arcs. This way, a query server on a graph without outgoing
+	// arcs and a separate evaluation process can answer the same queries. Seed sets with vertices that have
+	// no sketch (see SetCandidates) are answered exactly if lEval is set, and rejected otherwise. Seed sets
+	// with ids that are not vertices of the graph are rejected.
+	template<ModelType modelType>
+	void RunQueryFile(const string queryFilename, const bool estimate, const uint16_t k, const uint16_t l, const uint16_t lEval, const string statsFilename) {
+		IO::FileStream file;
+		file.OpenForReading(queryFilename);
+		if (!file.IsOpen()) {
+			cerr << "ERROR: Could not open query file '" << queryFilename << "'." << endl;
+			return;
+		}
+
+		stringstream stats;
+		string line;
+		uint32_t q = 0;
+		double totalElapsedMilliseconds = 0;
+		uint32_t numExact(0), numRejected(0), lineNumber(0);
+		vector<uint32_t> S;
+		Platform::Timer timer;
+		cout << "Running queries from " << queryFilename << " (" << (estimate ? "estimated" : "exact") << ")... " << flush;
+		while (!file.Finished()) {
+			file.ExtractLine(line);
+			++lineNumber;
+			if (line.empty()) continue;
+			S.clear();
+			bool valid = true;
+			for (const string &token : Tools::Split(line, ',')) {
+				const uint32_t u = Tools::LexicalCast<uint32_t>(token);
+				if (u >= graph.NumVertices()) {
+					cerr << endl << "ERROR: Vertex " << u << " in line " << lineNumber << " of '" << queryFilename << "' is not a vertex of the graph, query " << q << " skipped." << endl;
+					valid = false;
+					break;
+				}
+				S.push_back(u);
+			}
+			if (!valid) {
+				stats << q << "_VertexIds = " << line << endl << q << "_Rejected = 1" << endl;
+				++numRejected;
+				++q;
+				continue;
+			}
+			bool sketched = estimate;
+			for (const uint32_t u : S) sketched = sketched && HasSketch(u);
+			if (estimate && !sketched) {
+				if (lEval == 0) {
+					cerr << endl << "ERROR: Query " << q << " has vertices without sketches (and exact evaluation is off), skipped." << endl;
+					stats << q << "_VertexIds = " << line << endl << q << "_Rejected = 1" << endl;
+					++numRejected;
+					++q;
+					continue;
+				}
+				++numExact;
+			}
+			timer.Start();
+			const double influence = sketched ? Estimator(S, k, l) : ComputeInfluence<modelType>(S, lEval);
+			const double elapsedMilliseconds = timer.LiveElapsedMilliseconds();
+			totalElapsedMilliseconds += elapsedMilliseconds;
+			stats << q << "_VertexIds = " << line << endl
+				<< q << (sketched ? "_EstimatedInfluence = " : "_ExactInfluence = ") << influence << endl
+				<< q << "_ElapsedMilliseconds = " << elapsedMilliseconds << endl;
+			++q;
+		}
+		cout << "done (" << q << " queries, ";
+		if (numExact + numRejected > 0) cout << numExact << " answered exactly, " << numRejected << " rejected, ";
+		cout << (q > numRejected ? totalElapsedMilliseconds / (q - numRejected) : 0.0) << "ms on average)." << endl;
+
+		if (!statsFilename.empty()) {
+			cout << "Attempting to write statistics to " << statsFilename << "... " << flush;
+			ofstream statsFile(statsFilename);
+			if (statsFile.is_open()) {
+				statsFile << "NumberOfQueries = " << q << endl << stats.str();
+				statsFile.close();
+				cout << "done." << endl;
+			}
+		}
+		else {
+			cout << stats.str();
+		}
+	}
+
+
+	// This estimates the pairwise overlaps of the seed sets of a query file (one per line, vertex ids
+	// separated by commas) from the sketches, using numt threads. If lEval is set, the exact union of
+	// each pair is computed on lEval instances as well (which requires outgoing arcs), and the
+	// errors of the estimates are reported.
+	template<ModelType modelType>
+	void RunOverlapFile(const string queryFilename, const uint16_t k, const uint16_t l, const uint16_t lEval, const int32_t numt, const string statsFilename) {
+		IO::FileStream file;
+		file.OpenForReading(queryFilename);
+		if (!file.IsOpen()) {
+			cerr << "ERROR: Could not open query file '" << queryFilename << "'." << endl;
+			return;
+		}
+		vector<vector<uint32_t>> sets;
+		string line;
+		uint32_t lineNumber = 0;
+		while (!file.Finished()) {
+			file.ExtractLine(line);
+			++lineNumber;
+			if (line.empty()) continue;
+			sets.push_back(vector<uint32_t>());
+			for (const string &token : Tools::Split(line, ',')) {
+				const uint32_t u = Tools::LexicalCast<uint32_t>(token);
+				if (u >= graph.NumVertices()) {
+					cerr << "ERROR: Vertex " << u << " in line " << lineNumber << " of '" << queryFilename << "' is not a vertex of the graph." << endl;
+					return;
+				}
+				if (!HasSketch(u)) {
+					cerr << "ERROR: Vertex " << u << " of seed set " << (sets.size() - 1) << " has no sketch." << endl;
+					return;
+				}
+				sets.back().push_back(u);
+			}
+		}
+		file.Close();
+
+		cout << "Estimating pairwise overlaps of " << sets.size() << " seed sets from " << queryFilename << "... " << flush;
+		Platform::Timer timer; timer.Start();
+		vector<OverlapType> overlaps;
+		EstimateOverlaps(sets, k, l, numt, overlaps);
+		const double elapsedMilliseconds = timer.LiveElapsedMilliseconds();
+		const size_t numPairs = sets.size()*(sets.size() - (sets.empty() ? 0 : 1)) / 2;
+		cout << "done (" << numPairs << " pairs, " << elapsedMilliseconds << "ms)." << endl;
+
+		// Compare to the exact unions and intersections.
+		double averageUnionError(0), averageIntersectionError(0), exactElapsedMilliseconds(0);
+		vector<double> exactUnions;
+		if (lEval > 0) {
+			cout << "Computing exact overlaps... " << flush;
+			timer.Start();
+			vector<double> influences(sets.size());
+			for (size_t i = 0; i < sets.size(); ++i)
+				influences[i] = ComputeInfluence<modelType>(sets[i], lEval);
+			vector<uint32_t> U;
+			uint32_t numIntersections = 0;
+			for (size_t i = 0; i < sets.size(); ++i) {
+				for (size_t j = i + 1; j < sets.size(); ++j) {
+					U = sets[i];
+					U.insert(U.end(), sets[j].begin(), sets[j].end());
+					const double exactUnion = ComputeInfluence<modelType>(U, lEval);
+					const double exactIntersection = influences[i] + influences[j] - exactUnion;
+					const OverlapType &overlap = overlaps[i*sets.size() + j];
+					exactUnions.push_back(exactUnion);
+					averageUnionError += abs(overlap.Union - exactUnion) / exactUnion;
+					if (exactIntersection > 0) {
+						averageIntersectionError += abs(overlap.Intersection - exactIntersection) / exactIntersection;
+						++numIntersections;
+					}
+				}
+			}
+			exactElapsedMilliseconds = timer.LiveElapsedMilliseconds();
+			averageUnionError /= max<double>(1, double(numPairs));
+			averageIntersectionError /= max<double>(1, double(numIntersections));
+			cout << "done (errunion=" << averageUnionError << ", errintersection=" << averageIntersectionError << ", " << exactElapsedMilliseconds << "ms)." << endl;
+		}
+
+		if (!statsFilename.empty()) {
+			cout << "Attempting to write statistics to " << statsFilename << "... " << flush;
+			ofstream statsFile(statsFilename);
+			if (statsFile.is_open()) {
+				statsFile << "NumberOfSets = " << sets.size() << endl
+					<< "ElapsedMilliseconds = " << elapsedMilliseconds << endl;
+				if (lEval > 0)
+					statsFile << "ExactElapsedMilliseconds = " << exactElapsedMilliseconds << endl
+					<< "AverageUnionError = " << averageUnionError << endl
+					<< "AverageIntersectionError = " << averageIntersectionError << endl;
+				size_t p = 0;
+				for (size_t i = 0; i < sets.size(); ++i) {
+					for (size_t j = i + 1; j < sets.size(); ++j, ++p) {
+						const OverlapType &overlap = overlaps[i*sets.size() + j];
+						statsFile << i << "_" << j << "_Union = " << overlap.Union << endl
+							<< i << "_" << j << "_Intersection = " << overlap.Intersection << endl
+							<< i << "_" << j << "_Jaccard = " << overlap.Jaccard << endl;
+						if (lEval > 0)
+							statsFile << i << "_" << j << "_ExactUnion = " << exactUnions[p] << endl;
+					}
+				}
+				statsFile.close();
+				cout << "done." << endl;
+			}
+		}
+	}
+
+
+	// This computes the greedy seed sequence of RunGreedy (without output): seeds holds up to N
+	// vertices (zero means all), and gains their estimated marginal influences.
+	void GreedySequence(uint32_t N, const uint16_t k, const uint16_t l, vector<uint32_t> &seeds, vector<double> &gains) {
+		// Set N to number of vertices, if it's zero.
+		if (N == 0 || N > graph.NumVertices()) N = static_cast<uint32_t>(graph.NumVertices());
+		Assert(!sketches.empty());
+		const uint64_t sentinelRank = NumRankVertices()*l;
+		unordered_map<uint64_t, uint64_t> merged; // the merged sketch of the seed set: rank -> tau.
+		merged.reserve(size_t(N)*k);
+		DataStructures::Container::AlignedKHeap<double, uint32_t, 3> queue(graph.NumVertices()); // the negated gains.
+		vector<uint32_t> evaluated(graph.NumVertices(), 0); // the seed set size at the last gain evaluation.
+		seeds.clear();
+		gains.clear();
+
+		// Returns the marginal gain (divided by n) of adding u to the seed set.
+		auto marginalGain = [&](const uint32_t u) -> double {
+			const vector<uint64_t> &sketch = Sketch(u);
+			const size_t num = sketch.size() >= k ? k - 1 : sketch.size();
+			const uint64_t tau = sketch.size() >= k ? sketch[k - 1] : sentinelRank;
+			double gain = 0;
+			for (size_t i = 0; i < num; ++i) {
+				const auto it = merged.find(sketch[i]);
+				if (it == merged.end()) gain += 1.0 / double(tau);
+				else if (it->second < tau) gain += 1.0 / double(tau) - 1.0 / double(it->second);
+			}
+			return gain;
+		};
+
+		{
+			vector<uint32_t> vertices;
+			vector<double> initialGains;
+			vertices.reserve(HasCandidateSketches() ? sketchVertices.size() : graph.NumVertices());
+			initialGains.reserve(vertices.capacity());
+			FORALL_VERTICES(graph, u) {
+				if (!HasSketch(u)) continue;
+				vertices.push_back(u);
+				initialGains.push_back(-marginalGain(u));
+			}
+			queue.Build(vertices.data(), initialGains.data(), vertices.size());
+		}
+		while (seeds.size() < N && !queue.Empty()) {
+			const uint32_t u = queue.MinElement();
+			if (evaluated[u] != seeds.size()) {
+				// Re-evaluate a stale gain.
+				evaluated[u] = static_cast<uint32_t>(seeds.size());
+				queue.Update(u, -marginalGain(u));
+				continue;
+			}
+			const double gain = -queue.MinKey();
+			if (gain <= 0) {
+				if (verbose) cout << "total coverage reached (|S|=" << seeds.size() << ")... " << flush;
+				break;
+			}
+			queue.DeleteMin();
+
+			// Add u to the seed set and merge its sketch.
+			const vector<uint64_t> &sketch = Sketch(u);
+			const size_t num = sketch.size() >= k ? k - 1 : sketch.size();
+			const uint64_t tau = sketch.size() >= k ? sketch[k - 1] : sentinelRank;
+			for (size_t i = 0; i < num; ++i) {
+				uint64_t &t = merged[sketch[i]];
+				t = max(t, tau);
+			}
+			seeds.push_back(u);
+			gains.push_back(gain*NumRankVertices());
+		}
 	}
 
 
-	// This computes exact influence.
+	// This computes a greedy seed sequence of size N from the (precomputed) sketches, such that a
+	// single sketch construction yields both the query index and a seed set.
+	// Each iteration picks the vertex with the largest marginal gain of the estimator, i.e., the
+	// estimate of S+v minus the estimate of S. The merged sketch of S is kept in a hash map from rank
+	// to tau, so a marginal gain is evaluated in O(k). Gains are evaluated lazily (CELF).
+	// Quality: every estimate is the one of the oracle, i.e., unbiased with a coefficient of variation
+	// of at most 1/sqrt(k-2) for the influence on the l instances. Unlike SKIM, the sketches are not
+	// rebuilt on the residual problem, so marginal gains of later seeds are estimated from the
+	// difference of two such estimates (with a larger relative error as gains decrease), and lazy
+	// evaluation relies on the estimator being close to submodular. Hence the (1-1/e-eps) guarantee of
+	// SKIM does not carry over; use lEval to measure the exact spread of the sequence.
+	template<ModelType modelType>
+	void RunGreedy(uint32_t N, const uint16_t k, const uint16_t l, const uint16_t lEval, const string statsFilename) {
+		cout << "Computing greedy seed sequence from the sketches... " << flush;
+		Platform::Timer timer; timer.Start();
+		vector<uint32_t> seeds;
+		vector<double> gains;
+		GreedySequence(N, k, l, seeds, gains);
+		const double greedyElapsedMilliseconds = timer.LiveElapsedMilliseconds();
+		cout << "done (" << seeds.size() << " seeds, " << Tools::MillisecondsToString(greedyElapsedMilliseconds) << ")." << endl;
+
+		// Compute the exact marginal influences? This is not measured in the running time.
+		vector<double> exactGains(seeds.size(), 0.0);
+		if (lEval > 0)
+			ComputeMarginalInfluences<modelType>(seeds, lEval, exactGains);
+
+		double estinf(0), exinf(0);
+		for (size_t i = 0; i < seeds.size(); ++i) {
+			estinf += gains[i];
+			exinf += exactGains[i];
+		}
+		cout << "Number of seed vertices computed: " << seeds.size() << "." << endl
+			<< "Building sketches: " << preprocessingElapsedMilliseconds / 1000.0 << " sec." << endl
+			<< "Computing greedy sequence: " << greedyElapsedMilliseconds / 1000.0 << " sec." << endl
+			<< "Total time: " << (preprocessingElapsedMilliseconds + greedyElapsedMilliseconds) / 1000.0 << " sec." << endl
+			<< "Estimated spread of solution: " << estinf << " (" << (100.0*estinf / static_cast<double>(NumRankVertices())) << " %)." << endl;
+		if (lEval > 0)
+			cout << "Exact spread of solution: " << exinf << " (" << (100.0*exinf / static_cast<double>(NumRankVertices())) << " %)." << endl
+			<< "Quality gap: " << 100.0 * (1.0 - exinf / estinf) << " %" << endl;
+
+		if (!statsFilename.empty()) {
+			cout << "Attempting to write statistics to " << statsFilename << "... " << flush;
+			ofstream file(statsFilename);
+			if (file.is_open()) {
+				file << "NumberOfVertices = " << graph.NumVertices() << endl
+					<< "NumberOfArcs = " << graph.NumArcs() << endl
+					<< "TotalEstimatedInfluence = " << estinf << endl
+					<< "TotalExactInfluence = " << exinf << endl
+					<< "TotalElapsedMilliseconds = " << preprocessingElapsedMilliseconds + greedyElapsedMilliseconds << endl
+					<< "PreprocessingElapsedMilliseconds = " << preprocessingElapsedMilliseconds << endl
+					<< "GreedyElapsedMilliseconds = " << greedyElapsedMilliseconds << endl
+					<< "TotalSketchesSize = " << sketchSize << endl
+					<< "NumberOfSeedVertices = " << seeds.size() << endl;
+				double sumEstimatedInfluence(0.0), sumExactInfluence(0.0);
+				for (Types::IndexType i = 0; i < seeds.size(); ++i) {
+					sumEstimatedInfluence += gains[i];
+					sumExactInfluence += exactGains[i];
+					file << i << "_MarginalEstimatedInfluence = " << gains[i] << endl
+						<< i << "_CumulativeEstimatedInfluence = " << sumEstimatedInfluence << endl
+						<< i << "_MarginalExactInfluence = " << exactGains[i] << endl
+						<< i << "_CumulativeExactInfluence = " << sumExactInfluence << endl
+						<< i << "_VertexId = " << seeds[i] << endl;
+				}
+				file.close();
+				cout << "done." << endl;
+			}
+		}
+	}
+
+
+	// This computes the exact marginal influence of each vertex of a seed sequence, i.e., the number
+	// of vertices (targets, if any) it reaches that no earlier seed reaches (averaged over the l instances).
+	template<ModelType modelType>
+	void ComputeMarginalInfluences(const vector<uint32_t> &seeds, const uint16_t l, vector<double> &influences) {
+		influences.assign(seeds.size(), 0.0);
+		DataStructures::Container::BitVector covered(graph.NumVertices());
+		const ForwardTraversal forward(graph, forwardHubs);
+		for (uint16_t i = 0; i < l; ++i) {
+			covered.Clear();
+			for (size_t j = 0; j < seeds.size(); ++j) {
+				if (covered[seeds[j]]) continue;
+				searchSpace.Clear();
+				searchSpace.Insert(seeds[j]);
+				uint64_t size = 0;
+				forward.Run(searchSpace, covered, InstanceCoin<modelType>(*this, i, l), [&](const uint32_t u) {
+					covered.Set(u);
+					if (IsTarget(u)) ++size;
+					if (profile != nullptr) profile->Visit(0, influencePhase, u);
+					return DataStructures::Graphs::SCAN_ARCS;
+				});
+				influences[j] += double(size);
+			}
+		}
+		for (double &influence : influences)
+			influence /= double(l);
+	}
+
+
+	// This computes exact influence (on the targets, if any).
 	template<ModelType modelType>
 	double ComputeInfluence(const vector<uint32_t> &S, const uint16_t l) {
 		uint64_t size = 0;
-		for (uint16_t i = 0; i < l; ++i) {
-			// Run a BFS from source vertex in instance i.
-			searchSpace.Clear();
-			for (const uint32_t s : S) 
-				searchSpace.Insert(s);
-			uint32_t ind = 0;
-			while (ind < searchSpace.Size()) {
-				uint32_t u = searchSpace.KeyByIndex(ind++);
-				++size;
-				// arc expansion.
-				FORALL_INCIDENT_ARCS(graph, u, a) {
-					if (!a->Forward()) break;
-					const uint32_t v = a->OtherVertexId();
-					if (Contained<modelType>(u, v, i, l) && !searchSpace.IsContained(v))
+		const ForwardTraversal forward(graph, forwardHubs);
+		for (uint16_t i = 0; i < l; ++i)
+			size += InstanceInfluence<modelType>(S, i, l, forward);
+
+		return double(size) / double(l);
+	}
+
+
+	// This computes the exact influence of many seed sets at once. Batches of up to 64 queries share
+	// a sweep over each instance: every vertex holds a bit mask of the queries that reach it, and only
+	// newly reached bits are propagated further. Returns the influence of each query in influences.
+	// The masks pay off only if the queries reach the same vertices: if a vertex reached in the first
+	// instance is reached by fewer than two queries of the batch on average, the other instances are
+	// evaluated one query at a time. (On a graph with 20k vertices and 64 random queries per batch, the
+	// sweep was 7-12% slower with a reach of 30-113 vertices per query, 35% faster with 414.)
+	template<ModelType modelType>
+	void ComputeInfluenceBatch(const vector<vector<uint32_t>> &queries, const uint16_t l, vector<double> &influences) {
+		influences.assign(queries.size(), 0.0);
+		if (reachedBy.size() != graph.NumVertices()) {
+			reachedBy.resize(graph.NumVertices(), 0);
+			pendingBy.resize(graph.NumVertices(), 0);
+		}
+		vector<uint32_t> &Q = sweepQueue;
+		vector<uint64_t> size(64, 0);
+		const ForwardTraversal forward(graph, forwardHubs);
+		for (size_t firstQuery = 0; firstQuery < queries.size(); firstQuery += 64) {
+			const size_t numBatchQueries = min<size_t>(64, queries.size() - firstQuery);
+			fill(size.begin(), size.end(), 0);
+			bool shared = true;
+			for (uint16_t i = 0; i < l && shared; ++i) {
+				// Mark the seed vertices of each query.
+				searchSpace.Clear();
+				Q.clear();
+				for (size_t q = 0; q < numBatchQueries; ++q) {
+					const uint64_t bit = uint64_t(1) << q;
+					for (const uint32_t s : queries[firstQuery + q]) {
+						if (reachedBy[s] & bit) continue;
+						searchSpace.Insert(s);
+						if (pendingBy[s] == 0) Q.push_back(s);
+						reachedBy[s] |= bit;
+						pendingBy[s] |= bit;
+					}
+				}
+
+				// Propagate the pending bits until nothing changes.
+				for (size_t ind = 0; ind < Q.size(); ++ind) {
+					const uint32_t u = Q[ind];
+					const uint64_t pending = pendingBy[u];
+					pendingBy[u] = 0;
+					if (profile != nullptr) profile->Visit(0, influencePhase, u);
+					FORALL_INCIDENT_ARCS(graph, u, a) {
+						if (!a->Forward()) break;
+						const uint32_t v = a->OtherVertexId();
+						const uint64_t newBits = pending & ~reachedBy[v];
+						if (newBits == 0 || !Contained<modelType>(u, v, i, l)) continue;
 						searchSpace.Insert(v);
+						if (pendingBy[v] == 0) Q.push_back(v);
+						reachedBy[v] |= newBits;
+						pendingBy[v] |= newBits;
+					}
+				}
+
+				// Count the reached vertices (targets, if any) per query and reset the masks.
+				uint64_t numReached = 0;
+				for (Types::IndexType j = 0; j < searchSpace.Size(); ++j) {
+					const uint32_t u = searchSpace.KeyByIndex(j);
+					if (i == 0) numReached += Tools::PopCount(reachedBy[u]);
+					if (IsTarget(u))
+						for (uint64_t bits = reachedBy[u]; bits != 0; bits &= bits - 1)
+							++size[Tools::LowestSetBit(bits)];
+					reachedBy[u] = 0;
+				}
+				if (i == 0 && numReached < 2 * static_cast<uint64_t>(searchSpace.Size())) {
+					for (size_t q = 0; q < numBatchQueries; ++q)
+						for (uint16_t j = 1; j < l; ++j)
+							size[q] += InstanceInfluence<modelType>(queries[firstQuery + q], j, l, forward);
+					shared = false;
 				}
 			}
+			for (size_t q = 0; q < numBatchQueries; ++q)
+				influences[firstQuery + q] = double(size[q]) / double(l);
 		}
-
-		return double(size) / double(l);
 	}
 
 
@@ -383,7 +1502,7 @@ public:
 	inline void GenerateSeetSet(vector<uint32_t> &S, const uint64_t N, const SeedMethodType t, distType &dist) {
 		if (t == UNIFORM) {
 			for (uint32_t i = 0; i < N; ++i)
-				S.push_back(dist(twisty));
+				S.push_back(HasCandidateSketches() ? sketchVertices[dist(twisty)] : dist(twisty));
 		}
 		if (t == NEIGHBORHOOD) {
 			while (S.size() < N) {
@@ -394,32 +1513,26 @@ public:
 				} while (!graph.Arcs()[arcId].Backward());
 				const uint32_t sourceVertexId = graph.Arcs()[arcId].OtherVertexId();
 
-				// Run a BFS.
+				// Run a BFS. When it takes the first vertex of a level, the previous level is scanned,
+				// so the search space ends with the next level.
 				searchSpace.Clear();
 				searchSpace.Insert(sourceVertexId);
-				levels[sourceVertexId] = 0;
-				uint32_t cur = 0;
+				uint32_t cur = 0, level = 0, levelEnd = 1;
 				uint32_t finalLevel = UINT32_MAX;
-				while (cur < searchSpace.Size()) {
-					const uint32_t u = searchSpace.KeyByIndex(cur++);
-					if (levels[u] > finalLevel)
-						break;
-					if (cur >= (N-S.size()))
-						finalLevel = levels[u];
-					if (levels[u] == finalLevel)
-						continue;
-					FORALL_INCIDENT_ARCS(graph, u, arc) {
-						if (!arc->Forward()) continue;
-						const uint32_t v = arc->OtherVertexId();
-						if (searchSpace.IsContained(v)) continue;
-						levels[v] = levels[u] + 1;
-						searchSpace.Insert(v);
+				const ForwardTraversal forward(graph, forwardHubs);
+				forward.Run(searchSpace, DataStructures::Graphs::NothingBlocked(), DataStructures::Graphs::AllArcs(), [&](const uint32_t) {
+					if (cur++ == levelEnd) {
+						++level;
+						levelEnd = static_cast<uint32_t>(searchSpace.Size());
 					}
-				}
-
-				// Reset level information.
-				for (size_t i = 0; i < searchSpace.Size(); ++i)
-					levels[searchSpace.KeyByIndex(i)] = UINT32_MAX;
+					if (level > finalLevel)
+						return DataStructures::Graphs::STOP_TRAVERSAL;
+					if (cur >= (N-S.size()))
+						finalLevel = level;
+					if (level == finalLevel)
+						return DataStructures::Graphs::SKIP_ARCS;
+					return DataStructures::Graphs::SCAN_ARCS;
+				});
 
 				// Remove stuff beyond the current level from the search space.
 				Assert(cur > 0);
@@ -444,6 +1557,36 @@ protected:
 		return false;
 	}
 
+	// The traversals along the forward arcs (influence) and the backward arcs (sketches).
+	typedef DataStructures::Graphs::Traversal<GraphType, Types::FORWARD_DIRECTION> ForwardTraversal;
+	typedef DataStructures::Graphs::Traversal<GraphType, Types::BACKWARD_DIRECTION> BackwardTraversal;
+
+	// The coin policy of the traversals in instance i (of l): whether the arc is in the instance.
+	template<ModelType modelType>
+	struct InstanceCoin {
+		InstanceCoin(FastRSInfluenceOracle &o, const uint16_t i, const uint16_t l) : oracle(o), Instance(i), NumInstances(l) {}
+		inline bool operator()(const uint32_t tail, const uint32_t head) const {
+			return oracle.Contained<modelType>(tail, head, Instance, NumInstances);
+		}
+		FastRSInfluenceOracle &oracle;
+		const uint16_t Instance, NumInstances;
+	};
+
+	// Returns the number of vertices (targets, if any) that S reaches in instance i (of l).
+	template<ModelType modelType>
+	uint64_t InstanceInfluence(const vector<uint32_t> &S, const uint16_t i, const uint16_t l, const ForwardTraversal &forward) {
+		uint64_t size = 0;
+		searchSpace.Clear();
+		for (const uint32_t s : S)
+			searchSpace.Insert(s);
+		forward.Run(searchSpace, DataStructures::Graphs::NothingBlocked(), InstanceCoin<modelType>(*this, i, l), [&](const uint32_t u) {
+			if (IsTarget(u)) ++size;
+			if (profile != nullptr) profile->Visit(0, influencePhase, u);
+			return DataStructures::Graphs::SCAN_ARCS;
+		});
+		return size;
+	}
+
 	// A tailored Murmur hash 3 function for pair of vertices and instance.
 	inline uint32_t Murmur3Hash(const uint32_t u, const uint32_t v, const uint16_t i, const uint16_t l) const {
 		// Seed with our seed value.
@@ -491,6 +1634,12 @@ protected:
 
 private:
 
+	// The identifier at the beginning of index files (of the version that stores the model).
+	static const uint32_t IndexFileMagic = 0x534b4959;
+
+	// The flags of index files: HIP thresholds follow the sketches, and the targets follow the flags.
+	static const uint8_t IndexHIPFlag = 1, IndexTargetsFlag = 2;
+
 	// The graph we are working on.
 	GraphType &graph;
 
@@ -512,11 +1661,41 @@ private:
 	// These are the sketches for each vertex.
 	vector<vector<uint64_t>> sketches;
 
+	// These are the HIP thresholds of the sketch entries (empty unless HIP sketches are built).
+	vector<vector<uint64_t>> hipThresholds;
+
+	// The ids of the sketches of the vertices, if identical sketches are stored once or only candidates
+	// have sketches (and empty otherwise). Then, sketches and hipThresholds are indexed by these ids.
+	vector<uint32_t> sketchIds;
+
+	// The sketch id of vertices without a sketch.
+	enum : uint32_t { NoSketch = UINT32_MAX };
+
+	// The vertices with sketches, if only candidates have sketches (and empty otherwise).
+	vector<uint32_t> sketchVertices;
+
+	// The candidates of the next preprocessing (nullptr if all vertices get sketches).
+	const DataStructures::Container::BitVector *candidates = nullptr;
+
+	// The targets (empty if influence is measured on all vertices): their ids and flags.
+	vector<uint32_t> targetVertices;
+	DataStructures::Container::BitVector targetFlags;
+
 	// This holds search spaces for BFSes.
 	DataStructures::Container::FastSet<uint32_t> searchSpace;
 
-	// These are BFS levels.
-	vector<uint32_t> levels;
+	// The bitmaps of hub neighborhoods for scanning forward and backward arcs.
+	DataStructures::Graphs::HubAdjacency<GraphType> forwardHubs, backwardHubs;
+
+	// The access profile (if any), and its phases.
+	Tools::AccessProfile *profile = nullptr;
+	uint16_t preprocessingPhase = 0, influencePhase = 0;
+
+	// These are the query bit masks of the batched exact evaluation: reached and not yet propagated.
+	vector<uint64_t> reachedBy, pendingBy;
+
+	// The queue of the batched exact evaluation.
+	vector<uint32_t> sweepQueue;
 
 	// A random number generator.
 	mt19937 twisty;
@@ -530,6 +1709,15 @@ private:
 	// Statistics.
 	uint64_t sketchSize;
 
+	// The number of instances between published snapshots (zero if off).
+	uint16_t snapshotBatch;
+
+	// This is called after each published snapshot.
+	SnapshotCallbackType snapshotCallback;
+
+	// The published snapshots.
+	DataStructures::Container::SketchStore snapshots;
+
 	// Verbosity.
 	const bool verbose;
 
@@ -30,15 +30,18 @@ using namespace std;
 #include "DimacsGraphBuilder.h"
 #include "CommandLineParser.h"
 #include "RSInfluenceOracle.h"
+#include "SKIM.h"
+#include "VertexSetFile.h"
 
 void Usage(const string name) {
 	cout << name << " -i <graph> [options]" << endl
 		<< endl
 		<< "Options:" << endl
 		<< " -type <str>  -- type of input from {metis, dimacs, bin} (default: metis)." << endl
-		<< " -undir       -- treat the input as an undirected graph." << endl
+		<< " -undir       -- treat the input as an undirected graph (symmetrizes binary inputs)." << endl
 		<< " -nopar       -- remove parallel arcs in input." << endl
 		<< " -trans       -- transpose the input (reverse graph)." << endl
+		<< " -qonly       -- query-only mode: build only incoming arcs and skip exact evaluation." << endl
 		<< endl
 		<< " -m <model>   -- IC model used (\"binary\", \"trivalency\", \"weighted\"; default: \"weighted\")." << endl
 		<< " -p <double>  -- probability with which an arc is in the graph (binary model)." << endl
@@ -50,6 +53,22 @@ void Usage(const string name) {
 		<< " -k <int>     -- the k-value from the reachability sketches (default: 64)." << endl
 		<< " -l <int>     -- number of instances in the ic model (default: 64)." << endl
 		<< " -leval <int> -- number of instances in the ic model for evaluation (default: same as -l)." << endl
+		<< " -hub <int>   -- represent neighborhoods of vertices with at least this many arcs as bitmaps (default: 0 = off)." << endl
+		<< " -profile <string> -- count vertex visits per phase, write them to this file and print a summary." << endl
+		<< " -introspect <string> -- append the snapshots requested by SIGUSR1 (progress, memory, timings) to this file (default: stderr)." << endl
+		<< " -hip         -- also build HIP sketches and report the error of the HIP estimator." << endl
+		<< " -progressive <int> -- publish a snapshot after every this many instances and run random queries on it." << endl
+		<< " -iq <string> -- answer the seed sets in this file (one per line, comma-separated ids)." << endl
+		<< " -exact       -- answer the queries from -iq exactly (no preprocessing)." << endl
+		<< " -overlap     -- estimate the pairwise influence overlaps of the seed sets from -iq (exact ones with -leval)." << endl
+		<< " -dedup       -- store identical sketches once after preprocessing (or reading the index; not with candidate sketches)." << endl
+		<< " -candidates <string> -- keep sketches only for the vertex ids in this file (comma- or line-separated); other queries are answered exactly (with -leval) or rejected." << endl
+		<< " -targets <string> -- measure influence on the vertex ids in this file only (comma- or line-separated; kept in index files)." << endl
+		<< " -t <int>     -- number of threads for -overlap and -dedup (default: 1)." << endl
+		<< " -oi <string> -- write the sketches to this index file after preprocessing." << endl
+		<< " -ii <string> -- read the sketches from this index file instead of preprocessing." << endl
+		<< " -greedy <int>-- compute a greedy seed sequence of this size from the sketches (0 = graph size)." << endl
+		<< " -cmp         -- with -greedy, also run SKIM and report the time of running both tools." << endl
 		<< " -seed <int>  -- seed for random number generator (default: 31101982)." << endl
 		<< " -os <string> -- filename to output statistics to." << endl
 		<< " -v           -- omit output to console." << endl;
@@ -62,20 +81,37 @@ inline void RunQueries(const Tools::CommandLineParser &clp) {
 	// Read first batch of parameters.
 	const string graphFilename = clp.Value<string>("i");
 	const string graphType = clp.Value<string>("type", "metis");
-	const uint16_t k = clp.Value<uint16_t>("k", 64);
-	const uint16_t l = clp.Value<uint16_t>("l", 64);
+	uint16_t k = clp.Value<uint16_t>("k", 64);
+	uint16_t l = clp.Value<uint16_t>("l", 64);
 	const uint32_t s = clp.Value<uint32_t>("seed", 31101982);
 	const string statsFilename = clp.Value<string>("os");
+	const string queryFilename = clp.Value<string>("iq");
 	const bool verbose = !clp.IsSet("v");
+	const bool queryOnly = clp.IsSet("qonly");
+	const bool exact = clp.IsSet("exact");
+	const string inIndexFilename = clp.Value<string>("ii");
+	const string outIndexFilename = clp.Value<string>("oi");
+	if (queryOnly && exact) Usage(clp.ExecutableName());
+	if (queryOnly && clp.IsSet("cmp")) Usage(clp.ExecutableName());
+	Tools::Introspection::Install(clp.Value<string>("introspect"));
 
-	// Load the graph.
+	// Load the graph. The query-only mode never scans outgoing arcs, so they are not built.
 	DataStructures::Graphs::FastUnweightedGraph graph;
-	if (graphType == "metis")
-		RawData::BuildMetisGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, clp.IsSet("nopar"), verbose);
-	else if (graphType == "dimacs")
-		RawData::BuildDimacsGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, clp.IsSet("nopar"), verbose);
-	else if (graphType == "bin")
-		graph.Read(graphFilename, true, verbose);
+	if (graphType == "metis") {
+		if (!RawData::BuildMetisGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, !queryOnly, clp.IsSet("nopar"), verbose)) exit(1);
+	}
+	else if (graphType == "dimacs") {
+		if (!RawData::BuildDimacsGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, !queryOnly, clp.IsSet("nopar"), verbose)) exit(1);
+	}
+	else if (graphType == "bin") {
+		graph.Read(graphFilename, true, !queryOnly, verbose);
+		// Binary graphs are transformed in memory.
+		if (clp.IsSet("undir") || clp.IsSet("trans")) {
+			DataStructures::Graphs::FastUnweightedGraph transformed;
+			transformed.BuildTransform(graph, clp.IsSet("undir") ? DataStructures::Graphs::FastUnweightedGraph::SYMMETRIZE : DataStructures::Graphs::FastUnweightedGraph::TRANSPOSE, verbose);
+			graph.Swap(transformed);
+		}
+	}
 	else
 		Usage(clp.ExecutableName());
 
@@ -84,20 +120,146 @@ inline void RunQueries(const Tools::CommandLineParser &clp) {
 
 	// Set the binary probability.
 	oracle.SetBinaryProbability(clp.Value<double>("p", 0.1));
+	if (clp.IsSet("hub"))
+		oracle.SetHubThreshold(clp.Value<Types::SizeType>("hub", 0));
+
+	// Measure influence on targets only? An index file brings its own targets (or none).
+	if (clp.IsSet("targets") && inIndexFilename.empty()) {
+		DataStructures::Container::BitVector targets;
+		vector<uint32_t> targetList;
+		if (!IO::ReadVertexSet(clp.Value<string>("targets"), graph.NumVertices(), targets, targetList)) exit(1);
+		cout << "Measuring influence on " << targetList.size() << " targets." << endl;
+		oracle.SetTargets(&targets);
+	}
+
+	// Count vertex visits? The profile is written once the queries are answered.
+	Tools::AccessProfile profile;
+	const string profileFilename = clp.Value<string>("profile");
+	const auto writeProfile = [&]() {
+		if (profileFilename.empty()) return;
+		profile.Write(profileFilename);
+		if (verbose) profile.DumpSummary(cout);
+	};
+	if (!profileFilename.empty()) {
+		profile = Tools::AccessProfile(graph);
+		oracle.SetProfile(&profile);
+	}
+
+	// Answer queries exactly in a separate evaluation process?
+	if (exact) {
+		if (queryFilename.empty()) Usage(clp.ExecutableName());
+		oracle.RunQueryFile<modelType>(queryFilename, false, k, l, clp.Value<uint16_t>("leval", l), statsFilename);
+		writeProfile();
+		return;
+	}
 	
-	// Run preprocessing of the oracle
-	oracle.RunPreprocessing<modelType>(k, l);
+	// Run preprocessing of the oracle, or read its result from an index file.
+	Platform::Timer timer; timer.Start();
+	if (!inIndexFilename.empty()) {
+		if (!oracle.LoadIndex<modelType>(inIndexFilename, k, l)) exit(1);
+		if (clp.IsSet("targets")) {
+			cerr << "WARNING: -targets is ignored, the index measures influence on ";
+			if (oracle.NumRankVertices() == graph.NumVertices()) cerr << "all vertices." << endl;
+			else cerr << oracle.NumRankVertices() << " targets of its own." << endl;
+		}
+		if ((clp.IsSet("k") && clp.Value<uint16_t>("k") != k) || (clp.IsSet("l") && clp.Value<uint16_t>("l") != l))
+			cout << "The index overrides -k and -l: using k=" << k << " and l=" << l << "." << endl;
+	}
+	else {
+		// Keep sketches for candidates only?
+		DataStructures::Container::BitVector candidates;
+		vector<uint32_t> candidateList;
+		if (clp.IsSet("candidates")) {
+			if (!IO::ReadVertexSet(clp.Value<string>("candidates"), graph.NumVertices(), candidates, candidateList)) exit(1);
+			cout << "Keeping sketches for " << candidateList.size() << " candidates." << endl;
+			oracle.SetCandidates(&candidates);
+		}
+
+		// Serve random queries (of the sizes from -N) from the snapshots published during preprocessing?
+		const uint16_t lEval = queryOnly ? 0 : clp.Value<uint16_t>("leval", l);
+		vector<vector<uint32_t>> queries;
+		vector<double> exactInfluences;
+		if (clp.IsSet("progressive")) {
+			const vector<Types::IndexType> seedSetSizes = Tools::ExtractRange(clp.Value<string>("N", "1-50"));
+			queries.resize(clp.Value<int32_t>("n", 100));
+			mt19937 twisty(s);
+			uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>((candidateList.empty() ? graph.NumVertices() : candidateList.size()) - 1));
+			for (size_t q = 0; q < queries.size(); ++q) {
+				queries[q].resize(seedSetSizes[q % seedSetSizes.size()]);
+				for (uint32_t &u : queries[q]) u = candidateList.empty() ? dist(twisty) : candidateList[dist(twisty)];
+			}
+			exactInfluences.assign(queries.size(), 0.0);
+			if (lEval > 0) oracle.ComputeInfluenceBatch<modelType>(queries, lEval, exactInfluences);
+			oracle.SetProgressiveSnapshots(clp.Value<uint16_t>("progressive", 1), [&](const Algorithms::InfluenceMaximization::FastRSInfluenceOracle::SketchSnapshot &snapshot) {
+				double averageEstimatedInfluence(0), averageError(0);
+				for (size_t q = 0; q < queries.size(); ++q) {
+					const double estimatedInfluence = oracle.SnapshotEstimator(snapshot, queries[q], k);
+					averageEstimatedInfluence += estimatedInfluence / double(queries.size());
+					if (lEval > 0) averageError += abs(estimatedInfluence - exactInfluences[q]) / exactInfluences[q] / double(queries.size());
+				}
+				cout << endl << "Snapshot of " << snapshot.NumInstances << "/" << snapshot.NumTotalInstances << " instances: est=" << averageEstimatedInfluence;
+				if (lEval > 0) cout << ", err=" << averageError;
+				cout << "." << endl;
+			});
+		}
+		oracle.RunPreprocessing<modelType>(k, l, clp.IsSet("hip"));
+		oracle.SetCandidates(nullptr);
+	}
+	if (!outIndexFilename.empty())
+		oracle.SaveIndex<modelType>(outIndexFilename, k, l);
+	if (clp.IsSet("dedup")) {
+		if (oracle.HasCandidateSketches())
+			cerr << "WARNING: -dedup is ignored, the sketches are kept for candidates only (with -candidates or from the index)." << endl;
+		else
+			oracle.CompactSketches(clp.Value<int32_t>("t", 1));
+	}
+
+	// Derive a greedy seed sequence from the same sketches?
+	if (clp.IsSet("greedy")) {
+		const uint16_t lEval = queryOnly ? 0 : clp.Value<uint16_t>("leval", l);
+		oracle.RunGreedy<modelType>(clp.Value<uint32_t>("greedy", 0), k, l, lEval, statsFilename);
+		const double combinedElapsedMilliseconds = timer.LiveElapsedMilliseconds();
+		cout << "Combined sketches, index and greedy sequence: " << combinedElapsedMilliseconds / 1000.0 << " sec." << endl;
+
+		// Run SKIM for comparison: running both tools pays for the sketches twice.
+		if (clp.IsSet("cmp")) {
+			Algorithms::InfluenceMaximization::SKIM skim(graph, s, verbose);
+			skim.SetBinaryProbability(clp.Value<double>("p", 0.1));
+			if (clp.IsSet("hub"))
+				skim.SetHubThreshold(clp.Value<Types::SizeType>("hub", 0));
+			timer.Start();
+			skim.Run<static_cast<Algorithms::InfluenceMaximization::SKIM::ModelType>(modelType)>(clp.Value<uint32_t>("greedy", 0), k, l, 0, 1);
+			const double skimElapsedMilliseconds = timer.LiveElapsedMilliseconds();
+			cout << "SKIM: " << skimElapsedMilliseconds / 1000.0 << " sec." << endl
+				<< "Separate tools (SKIM and oracle preprocessing): " << (skimElapsedMilliseconds + oracle.PreprocessingElapsedMilliseconds()) / 1000.0 << " sec." << endl
+				<< "Combined mode: " << combinedElapsedMilliseconds / 1000.0 << " sec." << endl;
+		}
+		writeProfile();
+		return;
+	}
+
+	// Estimate the overlaps of the seed sets in a file?
+	if (clp.IsSet("overlap")) {
+		if (queryFilename.empty()) Usage(clp.ExecutableName());
+		const uint16_t lEval = queryOnly ? 0 : clp.Value<uint16_t>("leval", 0);
+		oracle.RunOverlapFile<modelType>(queryFilename, k, l, lEval, clp.Value<int32_t>("t", 1), statsFilename);
+	}
+
+	// Answer queries from a file? Seed sets without sketches are answered exactly, unless in query-only mode.
+	else if (!queryFilename.empty()) {
+		oracle.RunQueryFile<modelType>(queryFilename, true, k, l, queryOnly ? 0 : clp.Value<uint16_t>("leval", l), statsFilename);
+	}
 
 	// Run random queries?
-	if (!clp.IsSet("a")) {
-		const uint16_t lEval = clp.Value<uint16_t>("leval", l);
+	else if (!clp.IsSet("a")) {
+		const uint16_t lEval = queryOnly ? 0 : clp.Value<uint16_t>("leval", l);
 		const int32_t n = clp.Value<int32_t>("n", 100);
 		const string N = clp.Value<string>("N", "1-50");
 		Algorithms::InfluenceMaximization::FastRSInfluenceOracle::SeedMethodType m(Algorithms::InfluenceMaximization::FastRSInfluenceOracle::UNIFORM);
 
-		// Which method to use for generating random queries?
+		// Which method to use for generating random queries? Neighborhoods require outgoing arcs.
 		const string methodString = clp.Value<string>("g", "uni");
-		if (methodString == "neigh")
+		if (methodString == "neigh" && !queryOnly)
 			m = Algorithms::InfluenceMaximization::FastRSInfluenceOracle::NEIGHBORHOOD;
 
 		// Run random queries.
@@ -111,7 +273,7 @@ inline void RunQueries(const Tools::CommandLineParser &clp) {
 		vector<double> influence(graph.NumVertices(), 0.0);
 		FORALL_VERTICES(graph, vertexId) {
 			S[0] = vertexId;
-			influence[vertexId] = oracle.RunSpecificQuery(S, k, l);
+			if (oracle.HasSketch(vertexId)) influence[vertexId] = oracle.RunSpecificQuery(S, k, l);
 			++bar;
 		}
 		if (!statsFilename.empty()) {
@@ -119,13 +281,14 @@ inline void RunQueries(const Tools::CommandLineParser &clp) {
 			if (file.is_open()) {
 				stringstream ss;
 				FORALL_VERTICES(graph, vertexId) {
-					ss << vertexId << "\t" << influence[vertexId] << endl;
+					if (oracle.HasSketch(vertexId)) ss << vertexId << "\t" << influence[vertexId] << endl;
 				}
 				file << ss.str();
 				file.close();
 			} 
 		}
 	}
+	writeProfile();
 }
 
 
@@ -29,13 +29,16 @@ using namespace std;
 #include "DimacsGraphBuilder.h"
 #include "CommandLineParser.h"
 #include "SKIM.h"
+#include "HeuristicSeeds.h"
+#include "MultilevelSKIM.h"
+#include "VertexSetFile.h"
 
 void Usage(const string name) {
 	cout << name << " -i <graph> [options]" << endl
 		<< endl
 		<< "Options:" << endl
 		<< " -type <str>  -- type of input from {metis, dimacs, bin} (default: metis)." << endl
-		<< " -undir       -- treat the input as an undirected graph." << endl
+		<< " -undir       -- treat the input as an undirected graph (symmetrizes binary inputs)." << endl
 		<< " -nopar       -- remove parallel arcs in input." << endl
 		<< " -trans       -- transpose the input (reverse graph)." << endl
 		<< endl
@@ -46,6 +49,20 @@ void Usage(const string name) {
 		<< " -k <int>     -- the k-value from the reachability sketches (default: 64)." << endl
 		<< " -l <int>     -- number of instances in the ic model (default: 64)." << endl
 		<< " -leval <int> -- the number of instances to evaluate exact influence on (0 = off; default)." << endl
+		<< " -hub <int>   -- represent neighborhoods of vertices with at least this many arcs as bitmaps (default: 0 = off)." << endl
+		<< " -pipe <int>  -- number of ranks whose searches run speculatively during influence computation (default: 0 = off)." << endl
+		<< " -ooc <string> -- keep the per vertex/instance flags in a memory mapped file in this directory." << endl
+		<< " -lowmem      -- recompute inverse sketches when their ranks are covered instead of storing them." << endl
+		<< " -targets <string> -- measure influence on the vertex ids in this file only (comma- or line-separated; skim only)." << endl
+		<< " -profile <string> -- count vertex visits per phase, write them to this file and print a summary." << endl
+		<< " -introspect <string> -- append the snapshots requested by SIGUSR1 (progress, memory, timings) to this file (default: stderr)." << endl
+		<< " -algo <string> -- seed selection (skim, multilevel, degreediscount, pagerank, singlesketch; default: skim)." << endl
+		<< "                   The heuristics are much faster, without guarantee; use -leval to measure the gap." << endl
+		<< "                   multilevel runs SKIM on a contracted graph first and only refines the selected regions." << endl
+		<< " -cluster <int> -- maximum number of vertices per cluster of multilevel (default: 64)." << endl
+		<< " -rounds <int> -- maximum number of label propagation rounds of multilevel (default: 10)." << endl
+		<< " -regions <int> -- number of clusters multilevel selects per seed (default: 4)." << endl
+		<< " -cmp         -- also run plain SKIM and compare it to multilevel." << endl
 		<< endl
 		<< " -t <int>     -- number of threads (default: 1)." << endl
 		<< " -numa <int>  -- pinned NUMA node to run on (default: any and all)." << endl
@@ -74,6 +91,7 @@ int main(int argc, char **argv) {
 	const string modelStr = clp.Value<string>("m", "weighted");
 
 	if (graphFilename.empty()) Usage(clp.ExecutableName());
+	Tools::Introspection::Install(clp.Value<string>("introspect"));
 
 	if (clp.IsSet("numa")) {
 		cout << "Setting affinity mask of this process to " << Platform::GetAffinityMaskForNumaNode(clp.Value<uint32_t>("numa")) << "... " << flush;
@@ -84,29 +102,97 @@ int main(int argc, char **argv) {
 	// Load the graph.
 	DataStructures::Graphs::FastUnweightedGraph graph;
 
-	if (graphType == "metis")
-		RawData::BuildMetisGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, clp.IsSet("nopar"), verbose);
-	else if (graphType == "dimacs")
-		RawData::BuildDimacsGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, clp.IsSet("nopar"), verbose);
-	else if (graphType == "bin")
-		graph.Read(graphFilename, true, verbose);
+	if (graphType == "metis") {
+		if (!RawData::BuildMetisGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, true, clp.IsSet("nopar"), verbose)) return 1;
+	}
+	else if (graphType == "dimacs") {
+		if (!RawData::BuildDimacsGraph(graphFilename, graph, true, clp.IsSet("trans"), !clp.IsSet("undir"), true, true, clp.IsSet("nopar"), verbose)) return 1;
+	}
+	else if (graphType == "bin") {
+		graph.Read(graphFilename, true, true, verbose);
+		// Binary graphs are transformed in memory.
+		if (clp.IsSet("undir") || clp.IsSet("trans")) {
+			DataStructures::Graphs::FastUnweightedGraph transformed;
+			transformed.BuildTransform(graph, clp.IsSet("undir") ? DataStructures::Graphs::FastUnweightedGraph::SYMMETRIZE : DataStructures::Graphs::FastUnweightedGraph::TRANSPOSE, verbose, numt);
+			graph.Swap(transformed);
+		}
+	}
 	else
 		Usage(clp.ExecutableName());
 
 	const uint32_t N = clp.Value<uint32_t>("N", 0);
 
+	// Run a heuristic instead?
+	const string algoStr = clp.Value<string>("algo", "skim");
+	if (clp.IsSet("targets") && algoStr != "skim") Usage(clp.ExecutableName());
+	if (algoStr == "multilevel") {
+		Algorithms::InfluenceMaximization::MultilevelSKIM multilevel(graph, s, verbose);
+		multilevel.SetCoarsening(clp.Value<uint32_t>("cluster", 64), clp.Value<uint32_t>("rounds", 10), clp.Value<uint32_t>("regions", 4));
+		if (modelStr == "binary") {
+			multilevel.SetBinaryProbability(clp.Value<double>("p", 0.1));
+			multilevel.Run<Algorithms::InfluenceMaximization::SKIM::BINARY>(N, k, l, lEval, numt, clp.IsSet("cmp"), statsFilename, coverageFilename);
+		}
+		if (modelStr == "trivalency")
+			multilevel.Run<Algorithms::InfluenceMaximization::SKIM::TRIVALENCY>(N, k, l, lEval, numt, clp.IsSet("cmp"), statsFilename, coverageFilename);
+		if (modelStr == "weighted")
+			multilevel.Run<Algorithms::InfluenceMaximization::SKIM::WEIGHTED>(N, k, l, lEval, numt, clp.IsSet("cmp"), statsFilename, coverageFilename);
+		return 0;
+	}
+	if (algoStr != "skim") {
+		typedef Algorithms::InfluenceMaximization::HeuristicSeeds HeuristicSeeds;
+		HeuristicSeeds::MethodType method;
+		if (!HeuristicSeeds::ParseMethod(algoStr, method)) Usage(clp.ExecutableName());
+		HeuristicSeeds heuristic(graph, s, verbose);
+		if (modelStr == "binary") {
+			heuristic.SetBinaryProbability(clp.Value<double>("p", 0.1));
+			heuristic.Run<Algorithms::InfluenceMaximization::SKIM::BINARY>(method, N, k, l, lEval, numt, statsFilename);
+		}
+		if (modelStr == "trivalency")
+			heuristic.Run<Algorithms::InfluenceMaximization::SKIM::TRIVALENCY>(method, N, k, l, lEval, numt, statsFilename);
+		if (modelStr == "weighted")
+			heuristic.Run<Algorithms::InfluenceMaximization::SKIM::WEIGHTED>(method, N, k, l, lEval, numt, statsFilename);
+		return 0;
+	}
+
 	// Create the algorithm.
 	Algorithms::InfluenceMaximization::SKIM skim(graph, s, verbose);
+	if (clp.IsSet("hub"))
+		skim.SetHubThreshold(clp.Value<Types::SizeType>("hub", 0));
+	if (clp.IsSet("pipe"))
+		skim.SetPipelining(clp.Value<uint32_t>("pipe", 0));
+	if (clp.IsSet("ooc"))
+		skim.SetOutOfCore(clp.Value<string>("ooc", "."));
+	skim.SetLowMemory(clp.IsSet("lowmem"));
+	DataStructures::Container::BitVector targets;
+	vector<uint32_t> targetList;
+	if (clp.IsSet("targets")) {
+		if (!IO::ReadVertexSet(clp.Value<string>("targets"), graph.NumVertices(), targets, targetList)) return 1;
+		cout << "Measuring influence on " << targetList.size() << " targets." << endl;
+		skim.SetTargets(&targets);
+	}
+	Tools::AccessProfile profile;
+	if (clp.IsSet("profile")) {
+		profile = Tools::AccessProfile(graph, numt);
+		skim.SetProfile(&profile);
+	}
 
-	// Determine IC model and run algorithm.
+	// Determine IC model and run algorithm (no seeds means it failed).
+	vector<Algorithms::InfluenceMaximization::SKIM::SeedType> seedSet;
 	if (modelStr == "binary")  {
 		skim.SetBinaryProbability(clp.Value<double>("p", 0.1));
-		skim.Run<Algorithms::InfluenceMaximization::SKIM::BINARY>(N, k, l, lEval, numt, statsFilename, coverageFilename);
+		seedSet = skim.Run<Algorithms::InfluenceMaximization::SKIM::BINARY>(N, k, l, lEval, numt, statsFilename, coverageFilename);
 	}
 	if (modelStr == "trivalency")
-		skim.Run<Algorithms::InfluenceMaximization::SKIM::TRIVALENCY>(N, k, l, lEval, numt, statsFilename, coverageFilename);
+		seedSet = skim.Run<Algorithms::InfluenceMaximization::SKIM::TRIVALENCY>(N, k, l, lEval, numt, statsFilename, coverageFilename);
 	if (modelStr == "weighted")
-		skim.Run<Algorithms::InfluenceMaximization::SKIM::WEIGHTED>(N, k, l, lEval, numt, statsFilename, coverageFilename);
+		seedSet = skim.Run<Algorithms::InfluenceMaximization::SKIM::WEIGHTED>(N, k, l, lEval, numt, statsFilename, coverageFilename);
+	if (seedSet.empty() && graph.NumVertices() > 0) return 1;
+
+	// Write the access profile.
+	if (clp.IsSet("profile")) {
+		profile.Write(clp.Value<string>("profile"));
+		if (verbose) profile.DumpSummary(cout);
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1076 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <functional>
+
+using namespace std;
+
+#ifdef __CYGWIN__
+#define WINVER 0x0602
+#define _WIN32_WINNT 0x0602
+#endif
+
+#include "FastStaticGraphs.h"
+#include "CommandLineParser.h"
+#include "RangeExtraction.h"
+#include "Timer.h"
+#include "SKIM.h"
+#include "RSInfluenceOracle.h"
+#include "SortedMerge.h"
+#include "KHeap.h"
+#include "AlignedKHeap.h"
+#include "Traversal.h"
+#include "HeuristicSeeds.h"
+
+typedef Algorithms::InfluenceMaximization::SKIM SKIM;
+typedef Algorithms::InfluenceMaximization::FastRSInfluenceOracle Oracle;
+
+void Usage(const string name) {
+	cout << name << " [options]" << endl
+		<< endl
+		<< "Runs the reference implementations next to their variants on generated graphs" << endl
+		<< "and checks that the results are identical (or statistically equivalent)." << endl
+		<< endl
+		<< "Options:" << endl
+		<< " -g <str>     -- graph generators from {gnm, pa} (default: gnm,pa)." << endl
+		<< " -n <int>     -- numbers of vertices of the generated graphs (default: 2000,10000)." << endl
+		<< " -d <int>     -- average out-degree of the generated graphs (default: 8)." << endl
+		<< endl
+		<< " -m <model>   -- IC model used (\"binary\", \"trivalency\", \"weighted\"; default: \"weighted\")." << endl
+		<< " -p <double>  -- probability with which an arc is in the graph (binary model)." << endl
+		<< " -k <int>     -- the k-value from the reachability sketches (default: 64)." << endl
+		<< " -l <int>     -- number of instances in the ic model (default: 16)." << endl
+		<< " -N <int>     -- number of seed vertices computed by SKIM (default: 50)." << endl
+		<< " -q <int>     -- number of random queries for the oracle (default: 100)." << endl
+		<< " -t <int>     -- thread counts of the SKIM variants (default: 1,2,4)." << endl
+		<< " -hub <int>   -- hub threshold of the hub bitmap variants (default: 32)." << endl
+		<< " -pipe <int>  -- lookahead of the pipelined SKIM variant (default: 256)." << endl
+		<< " -ooc <string>-- directory of the mapped state of the out-of-core SKIM variant (default: \".\")." << endl
+		<< " -tol <double>-- tolerance for statistically equivalent results (default: 0.05)." << endl
+		<< " -seed <int>  -- seed for random number generator (default: 31101982)." << endl;
+	exit(0);
+}
+
+
+// This collects the outcome of comparing variants against their reference implementations.
+// A variant passes if its result is identical to the reference, or (where exact equality is
+// not expected) statistically equivalent within a tolerance.
+class VerificationReport {
+public:
+	VerificationReport() : numFailures(0) {}
+
+	// Adds the outcome of a check. The speed ratio is the reference time over the variant time.
+	void Add(const string name, const bool passed, const string detail, const double referenceMilliseconds, const double variantMilliseconds) {
+		if (!passed) ++numFailures;
+		cout << (passed ? "[PASS] " : "[FAIL] ") << name << ": " << detail
+			<< " (ref: " << fixed << setprecision(2) << referenceMilliseconds << "ms, var: " << variantMilliseconds << "ms, speedup: "
+			<< (variantMilliseconds > 0 ? referenceMilliseconds / variantMilliseconds : 0.0) << "x)." << endl;
+	}
+
+	// Returns the number of failed checks.
+	inline int NumFailures() const { return numFailures; }
+
+private:
+	int numFailures;
+};
+
+
+// Generates a random directed graph. The "gnm" generator draws n*d arcs uniformly at random,
+// the "pa" generator attaches every vertex to d earlier vertices by preferential attachment
+// (in random direction), which yields skewed degrees.
+void GenerateGraph(DataStructures::Graphs::FastUnweightedGraph &graph, const string generator, const uint32_t n, const uint32_t d, const uint32_t seed) {
+	mt19937 twisty(seed);
+	vector<pair<uint32_t, uint32_t>> arcs;
+	if (generator == "gnm") {
+		uniform_int_distribution<uint32_t> dist(0, n - 1);
+		while (arcs.size() < uint64_t(n)*d) {
+			const uint32_t u = dist(twisty), v = dist(twisty);
+			if (u != v) arcs.push_back(make_pair(u, v));
+		}
+	}
+	else {
+		vector<uint32_t> endpoints;
+		for (uint32_t u = 1; u < n; ++u) {
+			for (uint32_t j = 0; j < d; ++j) {
+				const uint32_t v = endpoints.empty() ? 0 : endpoints[twisty() % endpoints.size()];
+				if (v == u) continue;
+				arcs.push_back(twisty() % 2 ? make_pair(u, v) : make_pair(v, u));
+				endpoints.push_back(v);
+			}
+			endpoints.push_back(u);
+		}
+	}
+	sort(arcs.begin(), arcs.end());
+	arcs.erase(unique(arcs.begin(), arcs.end()), arcs.end());
+	graph.BuildFromArcList("verification/" + generator + "/" + to_string(n) + "/" + to_string(d) + "/" + to_string(seed), n, arcs, true, true, true, false);
+}
+
+
+// Runs SKIM with one thread as the reference, and with the other thread counts as variants.
+// The number of threads must not change the result, so the seeds must be identical (the
+// spread deviation is only reported to diagnose a failure).
+template<Oracle::ModelType modelType>
+void VerifySKIM(DataStructures::Graphs::FastUnweightedGraph &graph, const Tools::CommandLineParser &clp, VerificationReport &report) {
+	const SKIM::ModelType skimModelType = static_cast<SKIM::ModelType>(modelType);
+	const uint32_t s = clp.Value<uint32_t>("seed", 31101982);
+	const uint16_t k = clp.Value<uint16_t>("k", 64);
+	const uint16_t l = clp.Value<uint16_t>("l", 16);
+	const uint32_t N = clp.Value<uint32_t>("N", 50);
+	Platform::Timer timer;
+
+	SKIM reference(graph, s, false);
+	reference.SetBinaryProbability(clp.Value<double>("p", 0.1));
+	timer.Start();
+	const vector<SKIM::SeedType> referenceSeeds = reference.Run<skimModelType>(N, k, l, 0, 1);
+	const double referenceMilliseconds = timer.LiveElapsedMilliseconds();
+	double referenceSpread(0);
+	for (const SKIM::SeedType &seed : referenceSeeds) referenceSpread += seed.ExactInfluence;
+
+	for (const Types::IndexType numThreads : Tools::ExtractRange(clp.Value<string>("t", "1,2,4"))) {
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, static_cast<int32_t>(numThreads));
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		double variantSpread(0);
+		size_t numEqual = 0;
+		for (const SKIM::SeedType &seed : variantSeeds) variantSpread += seed.ExactInfluence;
+		while (numEqual < min(referenceSeeds.size(), variantSeeds.size()) && referenceSeeds[numEqual].VertexId == variantSeeds[numEqual].VertexId)
+			++numEqual;
+		const bool identical = numEqual == referenceSeeds.size() && numEqual == variantSeeds.size();
+		const double deviation = referenceSpread > 0 ? abs(variantSpread - referenceSpread) / referenceSpread : 0.0;
+		report.Add("SKIM::Run -t " + to_string(numThreads), identical,
+			identical ? "identical seeds" : to_string(numEqual) + " equal leading seeds, spread deviation " + to_string(deviation),
+			referenceMilliseconds, variantMilliseconds);
+	}
+
+	// Hub bitmaps must not change the seeds.
+	{
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetHubThreshold(clp.Value<Types::SizeType>("hub", 32));
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 1);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		bool identical = referenceSeeds.size() == variantSeeds.size();
+		for (size_t i = 0; identical && i < referenceSeeds.size(); ++i)
+			identical = referenceSeeds[i].VertexId == variantSeeds[i].VertexId && referenceSeeds[i].ExactInfluence == variantSeeds[i].ExactInfluence;
+		report.Add("SKIM::Run -hub", identical, identical ? "identical seeds" : "different seeds", referenceMilliseconds, variantMilliseconds);
+	}
+
+	// Keeping the state in a mapped file must not change the seeds.
+	{
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetOutOfCore(clp.Value<string>("ooc", "."));
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 1);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		bool identical = referenceSeeds.size() == variantSeeds.size();
+		for (size_t i = 0; identical && i < referenceSeeds.size(); ++i)
+			identical = referenceSeeds[i].VertexId == variantSeeds[i].VertexId && referenceSeeds[i].ExactInfluence == variantSeeds[i].ExactInfluence;
+		report.Add("SKIM::Run -ooc", identical, identical ? "identical seeds" : "different seeds", referenceMilliseconds, variantMilliseconds);
+	}
+
+	// Replaying the inverse sketches instead of storing them must not change the seeds.
+	{
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetLowMemory(true);
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 1);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		bool identical = referenceSeeds.size() == variantSeeds.size();
+		for (size_t i = 0; identical && i < referenceSeeds.size(); ++i)
+			identical = referenceSeeds[i].VertexId == variantSeeds[i].VertexId && referenceSeeds[i].ExactInfluence == variantSeeds[i].ExactInfluence;
+		report.Add("SKIM::Run -lowmem", identical, identical ? "identical seeds" : "different seeds", referenceMilliseconds, variantMilliseconds);
+	}
+
+	// Restricting the seeds to all vertices must not change them.
+	{
+		DataStructures::Container::BitVector candidates(graph.NumVertices());
+		FORALL_VERTICES(graph, u) candidates.Set(u);
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetCandidates(&candidates);
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 1);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		bool identical = referenceSeeds.size() == variantSeeds.size();
+		for (size_t i = 0; identical && i < referenceSeeds.size(); ++i)
+			identical = referenceSeeds[i].VertexId == variantSeeds[i].VertexId && referenceSeeds[i].ExactInfluence == variantSeeds[i].ExactInfluence;
+		report.Add("SKIM::Run candidates", identical, identical ? "identical seeds" : "different seeds", referenceMilliseconds, variantMilliseconds);
+	}
+
+	// Measuring influence on all vertices as targets must not change the seeds.
+	{
+		DataStructures::Container::BitVector targets(graph.NumVertices());
+		FORALL_VERTICES(graph, u) targets.Set(u);
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetTargets(&targets);
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 1);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		bool identical = referenceSeeds.size() == variantSeeds.size();
+		for (size_t i = 0; identical && i < referenceSeeds.size(); ++i)
+			identical = referenceSeeds[i].VertexId == variantSeeds[i].VertexId && referenceSeeds[i].ExactInfluence == variantSeeds[i].ExactInfluence;
+		report.Add("SKIM::Run targets", identical, identical ? "identical seeds" : "different seeds", referenceMilliseconds, variantMilliseconds);
+	}
+
+	// On every 10th vertex as targets, the estimated spread tracks the exact spread on the targets.
+	{
+		DataStructures::Container::BitVector targets(graph.NumVertices());
+		uint32_t numTargets = 0;
+		for (uint32_t u = 0; u < graph.NumVertices(); u += 10, ++numTargets) targets.Set(u);
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetTargets(&targets);
+		timer.Start();
+		vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 1);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		double estimatedSpread(0);
+		for (const SKIM::SeedType &seed : variantSeeds) estimatedSpread += seed.EstimatedInfluence;
+		const double exactSpread = variant.EvaluateSeeds<skimModelType>(variantSeeds, l);
+		const double error = abs(estimatedSpread - exactSpread) / max(1.0, exactSpread);
+		report.Add("SKIM::Run targets " + to_string(numTargets), error <= 0.25 && exactSpread <= numTargets,
+			"estimated " + to_string(estimatedSpread) + ", exact " + to_string(exactSpread) + " targets", referenceMilliseconds, variantMilliseconds);
+	}
+
+	// Speculative searches must not change the seeds either; the small size limit exercises resuming them.
+	{
+		SKIM parallel(graph, s, false);
+		parallel.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		timer.Start();
+		const vector<SKIM::SeedType> parallelSeeds = parallel.Run<skimModelType>(N, k, l, 0, 2);
+		const double parallelMilliseconds = timer.LiveElapsedMilliseconds();
+		SKIM variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetPipelining(clp.Value<uint32_t>("pipe", 256), 64);
+		timer.Start();
+		const vector<SKIM::SeedType> variantSeeds = variant.Run<skimModelType>(N, k, l, 0, 2);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		bool identical = parallelSeeds.size() == variantSeeds.size();
+		for (size_t i = 0; identical && i < parallelSeeds.size(); ++i)
+			identical = parallelSeeds[i].VertexId == variantSeeds[i].VertexId && parallelSeeds[i].ExactInfluence == variantSeeds[i].ExactInfluence;
+		report.Add("SKIM::Run -t 2 -pipe", identical, identical ? "identical seeds" : "different seeds", parallelMilliseconds, variantMilliseconds);
+
+		// The same with the inverse sketches replayed by the threads.
+		SKIM lowMemory(graph, s, false);
+		lowMemory.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		lowMemory.SetPipelining(clp.Value<uint32_t>("pipe", 256), 64);
+		lowMemory.SetLowMemory(true);
+		timer.Start();
+		const vector<SKIM::SeedType> lowMemorySeeds = lowMemory.Run<skimModelType>(N, k, l, 0, 2);
+		const double lowMemoryMilliseconds = timer.LiveElapsedMilliseconds();
+		identical = parallelSeeds.size() == lowMemorySeeds.size();
+		for (size_t i = 0; identical && i < parallelSeeds.size(); ++i)
+			identical = parallelSeeds[i].VertexId == lowMemorySeeds[i].VertexId && parallelSeeds[i].ExactInfluence == lowMemorySeeds[i].ExactInfluence;
+		report.Add("SKIM::Run -t 2 -pipe -lowmem", identical, identical ? "identical seeds" : "different seeds", parallelMilliseconds, lowMemoryMilliseconds);
+	}
+}
+
+
+// Runs the oracle preprocessing as the reference, and compares the sketches and estimates of the
+// variants (HIP sketches, an index file round trip), as well as the exact evaluations.
+template<Oracle::ModelType modelType>
+void VerifyOracle(DataStructures::Graphs::FastUnweightedGraph &graph, const Tools::CommandLineParser &clp, VerificationReport &report) {
+	const uint32_t s = clp.Value<uint32_t>("seed", 31101982);
+	const uint16_t k = clp.Value<uint16_t>("k", 64);
+	const uint16_t l = clp.Value<uint16_t>("l", 16);
+	const uint32_t numQueries = clp.Value<uint32_t>("q", 100);
+	const double tolerance = clp.Value<double>("tol", 0.05);
+	Platform::Timer timer;
+
+	// Generate random queries of varying sizes.
+	mt19937 twisty(s);
+	uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(graph.NumVertices() - 1));
+	vector<vector<uint32_t>> queries(numQueries);
+	for (uint32_t q = 0; q < numQueries; ++q) {
+		queries[q].resize(1 + q % 50);
+		for (uint32_t &u : queries[q]) u = dist(twisty);
+	}
+
+	// Returns true if the first k entries of all sketches of both oracles are identical.
+	auto sameSketches = [&](const Oracle &a, const Oracle &b) {
+		FORALL_VERTICES(graph, u) {
+			const vector<uint64_t> &x = a.Sketch(u), &y = b.Sketch(u);
+			if (min<size_t>(x.size(), k) != min<size_t>(y.size(), k) || !equal(x.begin(), x.begin() + min<size_t>(x.size(), k), y.begin()))
+				return false;
+		}
+		return true;
+	};
+
+	// Returns the number of queries on which the estimates of both oracles differ, and the time of b.
+	auto sameEstimates = [&](Oracle &a, Oracle &b, double &milliseconds) {
+		uint32_t numDifferent = 0;
+		milliseconds = 0;
+		for (const vector<uint32_t> &S : queries) {
+			const double x = a.Estimator(S, k, l);
+			timer.Start();
+			const double y = b.Estimator(S, k, l);
+			milliseconds += timer.LiveElapsedMilliseconds();
+			if (x != y) ++numDifferent;
+		}
+		return numDifferent;
+	};
+
+	Oracle reference(graph, s, false);
+	reference.SetBinaryProbability(clp.Value<double>("p", 0.1));
+	reference.RunPreprocessing<modelType>(k, l);
+	const double referenceMilliseconds = reference.PreprocessingElapsedMilliseconds();
+	double referenceEstimatorMilliseconds(0), variantEstimatorMilliseconds(0);
+	sameEstimates(reference, reference, referenceEstimatorMilliseconds);
+
+	// HIP sketches keep the bottom-k sketches as their first k entries.
+	{
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.RunPreprocessing<modelType>(k, l, true);
+		report.Add("RunPreprocessing -hip", sameSketches(reference, variant), "bottom-k sketches compared", referenceMilliseconds, variant.PreprocessingElapsedMilliseconds());
+		const uint32_t numDifferent = sameEstimates(reference, variant, variantEstimatorMilliseconds);
+		report.Add("Estimator -hip", numDifferent == 0, to_string(numDifferent) + " differing estimates", referenceEstimatorMilliseconds, variantEstimatorMilliseconds);
+	}
+
+	// The last progressive snapshot includes all instances, and its estimates are those of the reference.
+	{
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		const uint16_t batch = max<uint16_t>(1, l / 4);
+		const uint32_t expectedSnapshots = (uint32_t(l) + batch - 1) / batch;
+		uint32_t numSnapshots = 0;
+		variant.SetProgressiveSnapshots(batch, [&](const Oracle::SketchSnapshot&) { ++numSnapshots; });
+		variant.RunPreprocessing<modelType>(k, l);
+		const DataStructures::Container::SketchStore::ReadGuard snapshot = variant.Snapshots().Pin(0);
+		uint32_t numDifferent = 0;
+		timer.Start();
+		for (const vector<uint32_t> &S : queries)
+			if (snapshot->NumInstances != l || variant.SnapshotEstimator(*snapshot, S, k) != reference.Estimator(S, k, l)) ++numDifferent;
+		const double snapshotMilliseconds = timer.LiveElapsedMilliseconds();
+		report.Add("SnapshotEstimator", numDifferent == 0 && numSnapshots == expectedSnapshots, to_string(numSnapshots) + " snapshots, " + to_string(numDifferent) + " differing estimates", referenceEstimatorMilliseconds, snapshotMilliseconds);
+	}
+
+	// Queries on pinned snapshots during preprocessing see exactly the published versions (no torn
+	// sketches); their latency is compared to queries after preprocessing. A copy-on-write update
+	// leaves a pinned version intact, and its parts are reclaimed once it is unpinned.
+	{
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		vector<vector<double>> published(1); // the estimates of each version, by number.
+		variant.SetProgressiveSnapshots(1, [&](const Oracle::SketchSnapshot &snapshot) {
+			published.resize(snapshot.Number + 1);
+			for (const vector<uint32_t> &S : queries)
+				published[snapshot.Number].push_back(variant.SnapshotEstimator(snapshot, S, k));
+		});
+		atomic<bool> finished(false);
+		vector<pair<uint64_t, vector<double>>> observed;
+		double concurrentMilliseconds(0), quiescentMilliseconds(0);
+		uint64_t numConcurrentQueries(0);
+		thread reader([&]() {
+			Platform::Timer readerTimer;
+			while (!finished.load()) {
+				readerTimer.Start();
+				const DataStructures::Container::SketchStore::ReadGuard snapshot = variant.Snapshots().Pin(1);
+				if (!snapshot) {
+					this_thread::yield();
+					continue;
+				}
+				observed.push_back(make_pair(snapshot->Number, vector<double>()));
+				for (const vector<uint32_t> &S : queries)
+					observed.back().second.push_back(variant.SnapshotEstimator(*snapshot, S, k));
+				concurrentMilliseconds += readerTimer.LiveElapsedMilliseconds();
+				numConcurrentQueries += queries.size();
+			}
+		});
+		variant.RunPreprocessing<modelType>(k, l);
+		finished = true;
+		reader.join();
+		uint32_t numTorn = 0;
+		for (const pair<uint64_t, vector<double>> &o : observed)
+			if (o.first >= published.size() || o.second != published[o.first]) ++numTorn;
+		{
+			const DataStructures::Container::SketchStore::ReadGuard snapshot = variant.Snapshots().Pin(1);
+			timer.Start();
+			for (const vector<uint32_t> &S : queries) variant.SnapshotEstimator(*snapshot, S, k);
+			quiescentMilliseconds = timer.LiveElapsedMilliseconds() / double(queries.size());
+		}
+		report.Add("SketchStore concurrent queries", numTorn == 0, to_string(observed.size()) + " query rounds on " + to_string(published.size() - 1) + " versions, " + to_string(numTorn) + " torn (ms per query)", quiescentMilliseconds, numConcurrentQueries > 0 ? concurrentMilliseconds / double(numConcurrentQueries) : 0.0);
+
+		DataStructures::Container::SketchStore &store = variant.Snapshots();
+		bool intact = true;
+		{
+			const DataStructures::Container::SketchStore::ReadGuard pinned = store.Pin(0);
+			const vector<uint64_t> before = pinned->Sketch(queries[0][0]);
+			const uint64_t numCopied = store.NumCopiedSketches();
+			const DataStructures::Container::SketchStore::Version &updated = store.Update(vector<uint32_t>(1, queries[0][0]), vector<vector<uint64_t>>(1, vector<uint64_t>(1, 0)), vector<vector<uint64_t>>(), l, l);
+			intact = pinned->Sketch(queries[0][0]) == before && updated.Sketch(queries[0][0]) == vector<uint64_t>(1, 0) && store.NumCopiedSketches() == numCopied + 1 && store.NumRetired() > 0;
+		}
+		store.Reclaim();
+		intact = intact && store.NumRetired() == 0;
+		report.Add("SketchStore::Update", intact, intact ? "pinned version intact, reclaimed after unpinning" : "pinned version changed or not reclaimed", 0, 0);
+	}
+
+	// The index file round trip restores the sketches. An index of another model, or a truncated
+	// one, is rejected.
+	{
+		const string indexFilename = "verification-" + to_string(s) + ".idx";
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		uint16_t indexK(0), indexL(0);
+		reference.SaveIndex<modelType>(indexFilename, k, l);
+		const bool loaded = variant.LoadIndex<modelType>(indexFilename, indexK, indexL);
+		report.Add("LoadIndex", loaded && indexK == k && indexL == l && sameSketches(reference, variant), "sketches compared", referenceMilliseconds, variant.PreprocessingElapsedMilliseconds());
+		Oracle rejecting(graph, s, false);
+		rejecting.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		const bool otherModel = rejecting.LoadIndex<modelType == Oracle::WEIGHTED ? Oracle::BINARY : Oracle::WEIGHTED>(indexFilename, indexK, indexL);
+		string contents;
+		{
+			ifstream in(indexFilename, ios::binary);
+			contents.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+		}
+		{
+			ofstream out(indexFilename, ios::binary | ios::trunc);
+			out.write(contents.data(), contents.size() / 2);
+		}
+		const bool truncated = rejecting.LoadIndex<modelType>(indexFilename, indexK, indexL);
+		remove(indexFilename.c_str());
+		report.Add("LoadIndex rejects mismatches", !otherModel && !truncated, string(otherModel ? "other model accepted" : "other model rejected") + (truncated ? ", truncated index accepted" : ", truncated index rejected"), 0, 0);
+	}
+
+	// Keeping sketches for candidates only (all vertices, or every 100th) changes none of their sketches
+	// or HIP thresholds, and survives the index file round trip.
+	{
+		Oracle hipReference(graph, s, false);
+		hipReference.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		hipReference.RunPreprocessing<modelType>(k, l, true);
+		for (const uint32_t step : { 1u, 100u }) {
+			DataStructures::Container::BitVector candidates(graph.NumVertices());
+			for (uint32_t u = 0; u < graph.NumVertices(); u += step) candidates.Set(u);
+			Oracle variant(graph, s, false), loaded(graph, s, false);
+			variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+			loaded.SetBinaryProbability(clp.Value<double>("p", 0.1));
+			variant.SetCandidates(&candidates);
+			variant.RunPreprocessing<modelType>(k, l, true);
+			variant.SetCandidates(nullptr);
+			const string indexFilename = "verification-" + to_string(s) + ".idx";
+			uint16_t indexK(0), indexL(0);
+			variant.SaveIndex<modelType>(indexFilename, k, l);
+			const bool read = loaded.LoadIndex<modelType>(indexFilename, indexK, indexL);
+			remove(indexFilename.c_str());
+			bool same = read && variant.HasCandidateSketches() == (step > 1) && loaded.HasCandidateSketches() == (step > 1);
+			FORALL_VERTICES(graph, u) {
+				if (!same) break;
+				same = variant.HasSketch(u) == candidates[u] && loaded.HasSketch(u) == candidates[u];
+				if (same && candidates[u])
+					same = variant.Sketch(u) == hipReference.Sketch(u) && variant.HIPThresholds(u) == hipReference.HIPThresholds(u)
+						&& loaded.Sketch(u) == hipReference.Sketch(u) && loaded.HIPThresholds(u) == hipReference.HIPThresholds(u);
+			}
+
+			// A snapshot (which holds the sketches by id) has the same sketches.
+			const Oracle::SketchSnapshot &snapshot = loaded.PublishSnapshot(l, l);
+			FORALL_VERTICES(graph, u) {
+				if (!same) break;
+				same = loaded.HasSketch(u) ? snapshot.Sketch(u) == loaded.Sketch(u) && snapshot.HIPThresholds(u) == loaded.HIPThresholds(u) : snapshot.Sketch(u).empty();
+			}
+			report.Add("RunPreprocessing -candidates " + to_string(step > 1 ? graph.NumVertices() / step : graph.NumVertices()), same,
+				"index " + to_string(variant.IndexBytes() / 1024) + " KiB of " + to_string(hipReference.IndexBytes() / 1024) + " KiB", hipReference.PreprocessingElapsedMilliseconds(), variant.PreprocessingElapsedMilliseconds());
+		}
+	}
+
+	// Measuring influence on all vertices as targets keeps the sketches. On every 10th vertex, the
+	// estimates track the exact influence on the targets, which survive the index file round trip.
+	{
+		DataStructures::Container::BitVector targets(graph.NumVertices());
+		FORALL_VERTICES(graph, u) targets.Set(u);
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetTargets(&targets);
+		variant.RunPreprocessing<modelType>(k, l);
+		report.Add("RunPreprocessing targets", sameSketches(reference, variant), "sketches compared", referenceMilliseconds, variant.PreprocessingElapsedMilliseconds());
+	}
+	{
+		DataStructures::Container::BitVector targets(graph.NumVertices());
+		uint32_t numTargets = 0;
+		for (uint32_t u = 0; u < graph.NumVertices(); u += 10, ++numTargets) targets.Set(u);
+		Oracle variant(graph, s, false), loaded(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		loaded.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetTargets(&targets);
+		variant.RunPreprocessing<modelType>(k, l);
+		const string indexFilename = "verification-" + to_string(s) + ".idx";
+		uint16_t indexK(0), indexL(0);
+		variant.SaveIndex<modelType>(indexFilename, k, l);
+		bool consistent = loaded.LoadIndex<modelType>(indexFilename, indexK, indexL) && loaded.NumRankVertices() == numTargets;
+		{
+			// A target id out of range (the first one, after the header and the count) is rejected.
+			fstream patch(indexFilename, ios::in | ios::out | ios::binary);
+			const uint32_t outOfRange = static_cast<uint32_t>(graph.NumVertices());
+			patch.seekp(26 + sizeof(uint64_t));
+			patch.write(reinterpret_cast<const char*>(&outOfRange), sizeof(outOfRange));
+		}
+		Oracle rejecting(graph, s, false);
+		rejecting.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		consistent = consistent && !rejecting.LoadIndex<modelType>(indexFilename, indexK, indexL);
+		remove(indexFilename.c_str());
+		vector<double> exactInfluences;
+		variant.ComputeInfluenceBatch<modelType>(queries, l, exactInfluences);
+		consistent = consistent && variant.ComputeInfluence<modelType>(queries[0], l) == exactInfluences[0] && loaded.ComputeInfluence<modelType>(queries[0], l) == exactInfluences[0];
+		double error = 0;
+		for (size_t q = 0; q < queries.size(); ++q) {
+			const double estimate = variant.Estimator(queries[q], k, l);
+			consistent = consistent && estimate == loaded.Estimator(queries[q], k, l) && exactInfluences[q] <= numTargets;
+			error += abs(estimate - exactInfluences[q]) / max(1.0, exactInfluences[q]) / double(queries.size());
+		}
+		report.Add("RunPreprocessing targets " + to_string(numTargets), consistent && error <= 0.25, "average error " + to_string(error), referenceMilliseconds, variant.PreprocessingElapsedMilliseconds());
+	}
+
+	// Storing identical sketches once changes neither the sketches nor the estimates (and without
+	// duplicates, the direct layout is kept).
+	{
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.RunPreprocessing<modelType>(k, l, true);
+		vector<double> hipEstimates;
+		for (const vector<uint32_t> &S : queries)
+			hipEstimates.push_back(variant.HIPEstimator(S, l));
+		timer.Start();
+		const size_t numDistinct = variant.CompactSketches(2);
+		const double compactMilliseconds = timer.LiveElapsedMilliseconds();
+		const uint32_t numDifferent = sameEstimates(reference, variant, variantEstimatorMilliseconds);
+		uint32_t numHIPDifferent = 0;
+		for (size_t q = 0; q < queries.size(); ++q)
+			if (variant.HIPEstimator(queries[q], l) != hipEstimates[q]) ++numHIPDifferent;
+		const bool layoutKept = numDistinct < graph.NumVertices() || !variant.HasCompactSketches();
+		report.Add("CompactSketches", sameSketches(reference, variant) && numDifferent == 0 && numHIPDifferent == 0 && layoutKept, to_string(numDistinct) + " distinct sketches, " + to_string(numDifferent + numHIPDifferent) + " differing estimates (ms to compact)", referenceEstimatorMilliseconds, compactMilliseconds);
+	}
+
+	// With all arcs live (the binary model with p = 1), the vertices of a strongly connected component
+	// reach the same vertices in every instance, so their sketches (and HIP thresholds) are identical,
+	// and must be stored once.
+	{
+		Oracle live(graph, s, false), compacted(graph, s, false);
+		live.SetBinaryProbability(1.0);
+		compacted.SetBinaryProbability(1.0);
+		live.RunPreprocessing<Oracle::BINARY>(k, l, true);
+		compacted.RunPreprocessing<Oracle::BINARY>(k, l, true);
+		timer.Start();
+		const size_t numDistinct = compacted.CompactSketches(2);
+		const double compactMilliseconds = timer.LiveElapsedMilliseconds();
+		double liveMilliseconds(0);
+		uint32_t numDifferent = sameEstimates(live, compacted, liveMilliseconds);
+		for (const vector<uint32_t> &S : queries)
+			if (live.HIPEstimator(S, l) != compacted.HIPEstimator(S, l)) ++numDifferent;
+		const Oracle::SketchSnapshot &snapshot = compacted.PublishSnapshot(l, l);
+		for (const vector<uint32_t> &S : queries)
+			if (compacted.SnapshotEstimator(snapshot, S, k) != live.Estimator(S, k, l)) ++numDifferent;
+		bool same = sameSketches(live, compacted);
+		FORALL_VERTICES(graph, u) same = same && live.HIPThresholds(u) == compacted.HIPThresholds(u);
+		report.Add("CompactSketches -p 1", same && numDifferent == 0 && numDistinct < graph.NumVertices() && compacted.HasCompactSketches(), to_string(numDistinct) + " distinct sketches of " + to_string(graph.NumVertices()) + ", "
+			+ to_string(numDifferent) + " differing estimates (ms to compact)", liveMilliseconds, compactMilliseconds);
+	}
+
+	// Hub bitmaps must not change the sketches, nor the exact influence.
+	{
+		Oracle variant(graph, s, false);
+		variant.SetBinaryProbability(clp.Value<double>("p", 0.1));
+		variant.SetHubThreshold(clp.Value<Types::SizeType>("hub", 32));
+		variant.RunPreprocessing<modelType>(k, l);
+		report.Add("RunPreprocessing -hub", sameSketches(reference, variant), "sketches compared", referenceMilliseconds, variant.PreprocessingElapsedMilliseconds());
+		double exactMilliseconds(0), variantExactMilliseconds(0);
+		uint32_t numDifferent = 0;
+		for (const vector<uint32_t> &S : queries) {
+			timer.Start();
+			const double x = reference.ComputeInfluence<modelType>(S, l);
+			exactMilliseconds += timer.LiveElapsedMilliseconds();
+			timer.Start();
+			const double y = variant.ComputeInfluence<modelType>(S, l);
+			variantExactMilliseconds += timer.LiveElapsedMilliseconds();
+			if (x != y) ++numDifferent;
+		}
+		report.Add("ComputeInfluence -hub", numDifferent == 0, to_string(numDifferent) + " differing influences", exactMilliseconds, variantExactMilliseconds);
+	}
+
+	// The batched exact evaluation is identical to the one query at a time evaluation, and the
+	// estimates are within the expected error (the coefficient of variation is at most 1/sqrt(k-2)).
+	vector<double> exact(numQueries, 0.0), batch;
+	timer.Start();
+	for (uint32_t q = 0; q < numQueries; ++q)
+		exact[q] = reference.ComputeInfluence<modelType>(queries[q], l);
+	const double exactMilliseconds = timer.LiveElapsedMilliseconds();
+	timer.Start();
+	reference.ComputeInfluenceBatch<modelType>(queries, l, batch);
+	const double batchMilliseconds = timer.LiveElapsedMilliseconds();
+	uint32_t numDifferent = 0;
+	double averageError = 0;
+	for (uint32_t q = 0; q < numQueries; ++q) {
+		if (exact[q] != batch[q]) ++numDifferent;
+		averageError += abs(reference.Estimator(queries[q], k, l) - exact[q]) / exact[q] / double(numQueries);
+	}
+	report.Add("ComputeInfluenceBatch", numDifferent == 0, to_string(numDifferent) + " differing influences", exactMilliseconds, batchMilliseconds);
+	report.Add("Estimator", averageError <= 1.0 / sqrt(double(k) - 2.0) + tolerance, "average error " + to_string(averageError), exactMilliseconds, referenceEstimatorMilliseconds);
+
+	// The overlaps of consecutive queries: influences and unions are those of the estimator, the batch
+	// agrees with single pairs, and a set overlaps itself completely. The intersections are compared to
+	// the exact ones, also for nested pairs (a query and its union with the next one), whose exact
+	// intersection is the influence of the query; their average error (of the union) must be below
+	// the bound of the estimator.
+	{
+		vector<vector<uint32_t>> sets(queries.begin(), queries.begin() + min<size_t>(queries.size(), 20));
+		timer.Start();
+		vector<Oracle::OverlapType> overlaps;
+		reference.EstimateOverlaps(sets, k, l, 2, overlaps);
+		const double overlapMilliseconds = timer.LiveElapsedMilliseconds();
+		uint32_t numInconsistent = 0;
+		double unionMilliseconds(0), intersectionError(0), nestedError(0);
+		for (size_t i = 0; i + 1 < sets.size(); ++i) {
+			vector<uint32_t> U = sets[i];
+			U.insert(U.end(), sets[i + 1].begin(), sets[i + 1].end());
+			const Oracle::OverlapType overlap = reference.EstimateOverlap(sets[i], sets[i + 1], k, l);
+			const Oracle::OverlapType &batchOverlap = overlaps[i*sets.size() + i + 1];
+			if (overlap.InfluenceA != reference.Estimator(sets[i], k, l) || overlap.InfluenceB != reference.Estimator(sets[i + 1], k, l)
+				|| abs(overlap.Union - reference.Estimator(U, k, l)) > 1e-9 * overlap.Union || overlaps[i*sets.size() + i].Intersection != overlap.InfluenceA
+				|| overlaps[i*sets.size() + i].Union != overlap.InfluenceA || overlap.Union != batchOverlap.Union || overlap.Intersection != batchOverlap.Intersection || overlaps[(i + 1)*sets.size() + i].InfluenceA != overlap.InfluenceB)
+				++numInconsistent;
+			timer.Start();
+			const double exactUnion = reference.ComputeInfluence<modelType>(U, l);
+			unionMilliseconds += timer.LiveElapsedMilliseconds();
+			intersectionError += abs(overlap.Intersection - (exact[i] + exact[i + 1] - exactUnion)) / max(1.0, exactUnion) / double(sets.size() - 1);
+			nestedError += abs(reference.EstimateOverlap(sets[i], U, k, l).Intersection - exact[i]) / max(1.0, exactUnion) / double(sets.size() - 1);
+		}
+		const double bound = 1.0 / sqrt(double(k) - 2.0) + tolerance;
+		report.Add("EstimateOverlaps", numInconsistent == 0 && intersectionError <= bound && nestedError <= bound, to_string(numInconsistent) + " inconsistent pairs, intersection error " + to_string(intersectionError)
+			+ " (nested " + to_string(nestedError) + ") of the union", unionMilliseconds * sets.size() / 2, overlapMilliseconds);
+	}
+}
+
+
+// Compares the policy-based traversals to the hand-written BFS loops they replaced, both forward
+// with covered vertices and backward with pruning, for a hash coin that keeps 30% of the arcs.
+void VerifyTraversal(DataStructures::Graphs::FastUnweightedGraph &graph, const Tools::CommandLineParser &clp, VerificationReport &report) {
+	typedef DataStructures::Graphs::FastUnweightedGraph GraphType;
+	const uint32_t numSources = 500;
+	const uint64_t seed = clp.Value<uint32_t>("seed", 31101982);
+	const auto coin = [seed](const uint32_t tail, const uint32_t head) {
+		return ((((uint64_t(tail) << 32) | head) ^ seed) * 0x9E3779B97F4A7C15ULL) >> 32 < uint64_t(UINT32_MAX) * 3 / 10;
+	};
+	mt19937 twisty(static_cast<uint32_t>(seed));
+	vector<uint32_t> sources(numSources);
+	for (uint32_t &s : sources) s = twisty() % graph.NumVertices();
+	DataStructures::Container::BitVector covered(graph.NumVertices());
+	FORALL_VERTICES(graph, u)
+		if (twisty() % 5 == 0) covered.Set(u);
+	DataStructures::Container::FastSet<uint32_t> S(graph.NumVertices());
+	const DataStructures::Graphs::HubAdjacency<GraphType> noHubs;
+	const DataStructures::Graphs::Traversal<GraphType, Types::FORWARD_DIRECTION> forward(graph, noHubs);
+	const DataStructures::Graphs::Traversal<GraphType, Types::BACKWARD_DIRECTION> backward(graph, noHubs);
+	Platform::Timer timer;
+
+	// The checksums weigh each vertex with its position in the search space, such that they also
+	// depend on the order of the visits.
+	uint64_t referenceChecksum(0), variantChecksum(0);
+	timer.Start();
+	for (const uint32_t s : sources) {
+		if (covered[s]) continue;
+		S.Clear();
+		S.Insert(s);
+		uint32_t ind = 0;
+		while (ind < S.Size()) {
+			const uint32_t u = S.KeyByIndex(ind++);
+			referenceChecksum += uint64_t(u) * ind;
+			FORALL_INCIDENT_ARCS(graph, u, a) {
+				if (!a->Forward()) break;
+				const uint32_t v = a->OtherVertexId();
+				if (coin(u, v) && !S.IsContained(v) && !covered[v])
+					S.Insert(v);
+			}
+		}
+	}
+	double referenceMilliseconds = timer.LiveElapsedMilliseconds();
+	timer.Start();
+	for (const uint32_t s : sources) {
+		if (covered[s]) continue;
+		S.Clear();
+		S.Insert(s);
+		uint32_t ind = 0;
+		forward.Run(S, covered, coin, [&](const uint32_t u) {
+			variantChecksum += uint64_t(u) * ++ind;
+			return DataStructures::Graphs::SCAN_ARCS;
+		});
+	}
+	double variantMilliseconds = timer.LiveElapsedMilliseconds();
+	report.Add("Traversal forward", referenceChecksum == variantChecksum, referenceChecksum == variantChecksum ? "identical search spaces" : "different search spaces", referenceMilliseconds, variantMilliseconds);
+
+	// Backward, the vertices with ids divisible by 4 are pruned.
+	referenceChecksum = variantChecksum = 0;
+	timer.Start();
+	for (const uint32_t s : sources) {
+		S.Clear();
+		S.Insert(s);
+		uint32_t ind = 0;
+		while (ind < S.Size()) {
+			const uint32_t u = S.KeyByIndex(ind++);
+			referenceChecksum += uint64_t(u) * ind;
+			if (u % 4 == 0) continue;
+			FORALL_INCIDENT_ARCS_BACKWARD(graph, u, a) {
+				if (!a->Backward()) break;
+				const uint32_t v = a->OtherVertexId();
+				if (coin(v, u) && !S.IsContained(v))
+					S.Insert(v);
+			}
+		}
+	}
+	referenceMilliseconds = timer.LiveElapsedMilliseconds();
+	timer.Start();
+	for (const uint32_t s : sources) {
+		S.Clear();
+		S.Insert(s);
+		uint32_t ind = 0;
+		backward.Run(S, DataStructures::Graphs::NothingBlocked(), coin, [&](const uint32_t u) {
+			variantChecksum += uint64_t(u) * ++ind;
+			return u % 4 == 0 ? DataStructures::Graphs::SKIP_ARCS : DataStructures::Graphs::SCAN_ARCS;
+		});
+	}
+	variantMilliseconds = timer.LiveElapsedMilliseconds();
+	report.Add("Traversal backward", referenceChecksum == variantChecksum, referenceChecksum == variantChecksum ? "identical search spaces" : "different search spaces", referenceMilliseconds, variantMilliseconds);
+}
+
+
+// Compares the parallel graph transforms to graphs built from the transformed arc lists.
+void VerifyTransforms(DataStructures::Graphs::FastUnweightedGraph &graph, const Tools::CommandLineParser &clp, VerificationReport &report) {
+	typedef DataStructures::Graphs::FastUnweightedGraph GraphType;
+	const int32_t numt = static_cast<int32_t>(Tools::ExtractRange(clp.Value<string>("t", "1,2,4")).back());
+	Platform::Timer timer;
+
+	// Compares two graphs arc by arc.
+	const auto Identical = [](GraphType &a, GraphType &b) -> bool {
+		if (a.NumVertices() != b.NumVertices() || a.NumArcs() != b.NumArcs() || a.IsDirected() != b.IsDirected()) return false;
+		for (uint32_t u = 0; u <= a.NumVertices(); ++u)
+			if (a.Vertices()[u].FirstArcId() != b.Vertices()[u].FirstArcId()) return false;
+		for (uint32_t i = 0; i < a.NumArcs(); ++i) {
+			const DataStructures::Graphs::FastArc &x = a.Arcs()[i], &y = b.Arcs()[i];
+			if (x.OtherVertexId() != y.OtherVertexId() || x.Forward() != y.Forward() || x.Backward() != y.Backward()) return false;
+		}
+		return true;
+	};
+
+	// The references are built from the transformed arc lists, with sorted arcs.
+	const GraphType::TransformType transforms[] = { GraphType::TRANSPOSE, GraphType::SYMMETRIZE, GraphType::DROP_BACKWARD };
+	const string names[] = { "transpose", "symmetrize", "dropbackward" };
+	GraphType forwardOnly;
+	for (int t = 0; t < 3; ++t) {
+		timer.Start();
+		vector<pair<uint32_t, uint32_t>> arcs;
+		FORALL_ARCS(graph, u, a) {
+			if (!a->Forward()) continue;
+			const uint32_t v = a->OtherVertexId();
+			if (transforms[t] == GraphType::TRANSPOSE) arcs.push_back(make_pair(v, u));
+			else if (transforms[t] == GraphType::SYMMETRIZE) arcs.push_back(make_pair(min(u, v), max(u, v)));
+			else arcs.push_back(make_pair(u, v));
+		}
+		if (transforms[t] == GraphType::SYMMETRIZE) {
+			sort(arcs.begin(), arcs.end());
+			arcs.erase(unique(arcs.begin(), arcs.end()), arcs.end());
+		}
+		GraphType reference;
+		reference.BuildFromArcList(graph.GetIdentifier() + "/reference/" + names[t], static_cast<uint32_t>(graph.NumVertices()), arcs, transforms[t] != GraphType::SYMMETRIZE, transforms[t] != GraphType::DROP_BACKWARD, true, false);
+		FORALL_VERTICES(reference, u)
+			reference.SortArcs(u);
+		const double referenceMilliseconds = timer.LiveElapsedMilliseconds();
+		GraphType variant;
+		timer.Start();
+		variant.BuildTransform(graph, transforms[t], false, numt);
+		const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+		const bool identical = Identical(reference, variant);
+		report.Add("BuildTransform " + names[t], identical, identical ? "identical graphs" : "different graphs", referenceMilliseconds, variantMilliseconds);
+		if (transforms[t] == GraphType::DROP_BACKWARD)
+			forwardOnly.Swap(variant);
+	}
+
+	// Adding the backward arcs back must restore the graph.
+	GraphType variant;
+	timer.Start();
+	variant.BuildTransform(forwardOnly, GraphType::ADD_BACKWARD, false, numt);
+	const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+	const bool identical = Identical(graph, variant);
+	report.Add("BuildTransform addbackward", identical, identical ? "identical graphs" : "different graphs", 0, variantMilliseconds);
+}
+
+
+// Compares the (vectorized, if built with AVX2) merge kernels to their scalar reference on random
+// sorted rank lists of size k, with and without (rank, tau) payloads.
+void VerifyMerge(const Tools::CommandLineParser &clp, VerificationReport &report) {
+	const uint16_t k = clp.Value<uint16_t>("k", 64);
+	const uint32_t numLists = 2000, numRepetitions = 50;
+	mt19937_64 twisty(clp.Value<uint32_t>("seed", 31101982));
+	vector<vector<uint64_t>> lists(numLists);
+	vector<vector<pair<uint64_t, uint64_t>>> pairLists(numLists);
+	for (uint32_t i = 0; i < numLists; ++i) {
+		// Draw from a small range, such that lists share ranks.
+		for (uint64_t r = 0; lists[i].size() < k; r += 1 + twisty() % 4)
+			if (twisty() % 2) lists[i].push_back(r);
+		for (const uint64_t r : lists[i])
+			pairLists[i].push_back(make_pair(r, 1 + twisty() % 1000));
+	}
+	vector<uint64_t> referenceOut(2 * k + 3), out(2 * k + 3);
+	vector<pair<uint64_t, uint64_t>> referencePairOut(2 * k + 3), pairOut(2 * k + 3);
+	Platform::Timer timer;
+
+	uint32_t numDifferent = 0;
+	double referenceMilliseconds(0), variantMilliseconds(0);
+	size_t checksum(0);
+	for (uint32_t i = 0; i + 1 < numLists; ++i) {
+		const size_t num = Tools::MergeUniqueScalar(lists[i].data(), k, lists[i + 1].data(), k, referenceOut.data());
+		if (num != Tools::MergeUnique(lists[i].data(), k, lists[i + 1].data(), k, out.data()) || !equal(out.begin(), out.begin() + num, referenceOut.begin()))
+			++numDifferent;
+	}
+	timer.Start();
+	for (uint32_t j = 0; j < numRepetitions; ++j)
+		for (uint32_t i = 0; i + 1 < numLists; ++i)
+			checksum += Tools::MergeUniqueScalar(lists[i].data(), k, lists[i + 1].data(), k, referenceOut.data());
+	referenceMilliseconds = timer.LiveElapsedMilliseconds();
+	timer.Start();
+	for (uint32_t j = 0; j < numRepetitions; ++j)
+		for (uint32_t i = 0; i + 1 < numLists; ++i)
+			checksum -= Tools::MergeUnique(lists[i].data(), k, lists[i + 1].data(), k, out.data());
+	variantMilliseconds = timer.LiveElapsedMilliseconds();
+	report.Add("MergeUnique", numDifferent == 0 && checksum == 0, to_string(numDifferent) + " differing merges", referenceMilliseconds, variantMilliseconds);
+
+	numDifferent = 0;
+	for (uint32_t i = 0; i + 1 < numLists; ++i) {
+		const size_t num = Tools::MergeUniqueMaxPayloadScalar(pairLists[i].data(), k, pairLists[i + 1].data(), k, referencePairOut.data());
+		if (num != Tools::MergeUniqueMaxPayload(pairLists[i].data(), k, pairLists[i + 1].data(), k, pairOut.data()) || !equal(pairOut.begin(), pairOut.begin() + num, referencePairOut.begin()))
+			++numDifferent;
+	}
+	timer.Start();
+	for (uint32_t j = 0; j < numRepetitions; ++j)
+		for (uint32_t i = 0; i + 1 < numLists; ++i)
+			checksum += Tools::MergeUniqueMaxPayloadScalar(pairLists[i].data(), k, pairLists[i + 1].data(), k, referencePairOut.data());
+	referenceMilliseconds = timer.LiveElapsedMilliseconds();
+	timer.Start();
+	for (uint32_t j = 0; j < numRepetitions; ++j)
+		for (uint32_t i = 0; i + 1 < numLists; ++i)
+			checksum -= Tools::MergeUniqueMaxPayload(pairLists[i].data(), k, pairLists[i + 1].data(), k, pairOut.data());
+	variantMilliseconds = timer.LiveElapsedMilliseconds();
+	report.Add("MergeUniqueMaxPayload", numDifferent == 0 && checksum == 0, to_string(numDifferent) + " differing merges", referenceMilliseconds, variantMilliseconds);
+}
+
+
+// Drains the heap like lazy greedy does: the key of the minimum is either increased (a stale gain
+// that is re-evaluated) or it is deleted, as decided by the coins. Appends the deleted elements to order.
+template<typename heapType>
+void DrainLazily(heapType &heap, const vector<uint32_t> &coins, vector<uint32_t> &order) {
+	size_t c = 0;
+	while (!heap.Empty()) {
+		if (c + 1 < coins.size() && coins[c++] % 2 == 0)
+			heap.Update(heap.MinElement(), heap.MinKey() + 1 + coins[c++] % 50);
+		else
+			order.push_back(heap.DeleteMin());
+	}
+}
+
+// Compares the cache aligned heap to KHeap (and the drain to std::priority_queue) on random keys:
+// draining a heap built from an array, lazy greedy updates with many equal keys (whose order must
+// match KHeap), and batches of updates, some large enough to rebuild the heap.
+void VerifyHeaps(const Tools::CommandLineParser &clp, VerificationReport &report) {
+	typedef DataStructures::Container::KHeap<double, uint32_t, 3> ScalarHeap;
+	typedef DataStructures::Container::AlignedKHeap<double, uint32_t, 3> AlignedHeap;
+	const uint32_t n = 1000000, numBatched = 100000;
+	mt19937_64 twisty(clp.Value<uint32_t>("seed", 31101982));
+	uniform_real_distribution<double> uniform(0.0, 1.0);
+	vector<uint32_t> elements(n);
+	vector<double> keys(n);
+	for (uint32_t i = 0; i < n; ++i) {
+		elements[i] = i;
+		keys[i] = uniform(twisty);
+	}
+	Platform::Timer timer;
+
+	// Build and drain.
+	vector<uint32_t> referenceOrder, order, queueOrder;
+	referenceOrder.reserve(n);
+	order.reserve(n);
+	queueOrder.reserve(n);
+	{
+		ScalarHeap scalar(n);
+		timer.Start();
+		for (uint32_t i = 0; i < n; ++i) scalar.Update(elements[i], keys[i]);
+		while (!scalar.Empty()) referenceOrder.push_back(scalar.DeleteMin());
+	}
+	const double referenceMilliseconds = timer.LiveElapsedMilliseconds();
+	{
+		AlignedHeap aligned(n);
+		timer.Start();
+		aligned.Build(elements.data(), keys.data(), n);
+		while (!aligned.Empty()) order.push_back(aligned.DeleteMin());
+	}
+	const double variantMilliseconds = timer.LiveElapsedMilliseconds();
+	report.Add("AlignedKHeap build and drain", order == referenceOrder, order == referenceOrder ? "identical order" : "different order", referenceMilliseconds, variantMilliseconds);
+	{
+		vector<pair<double, uint32_t>> entries(n);
+		for (uint32_t i = 0; i < n; ++i) entries[i] = make_pair(keys[i], elements[i]);
+		timer.Start();
+		priority_queue<pair<double, uint32_t>, vector<pair<double, uint32_t>>, greater<pair<double, uint32_t>>> queue(entries.begin(), entries.end());
+		while (!queue.empty()) {
+			queueOrder.push_back(queue.top().second);
+			queue.pop();
+		}
+	}
+	const double queueMilliseconds = timer.LiveElapsedMilliseconds();
+	report.Add("AlignedKHeap vs priority_queue", order == queueOrder, order == queueOrder ? "identical order" : "different order", queueMilliseconds, variantMilliseconds);
+
+	// Lazy greedy updates on integral keys.
+	vector<uint32_t> coins(4 * size_t(n));
+	for (uint32_t &coin : coins) coin = static_cast<uint32_t>(twisty());
+	referenceOrder.clear();
+	order.clear();
+	double lazyReferenceMilliseconds(0), lazyVariantMilliseconds(0);
+	{
+		ScalarHeap scalar(n);
+		timer.Start();
+		for (uint32_t i = 0; i < n; ++i) scalar.Update(elements[i], double(coins[i] % 1000));
+		DrainLazily(scalar, coins, referenceOrder);
+		lazyReferenceMilliseconds = timer.LiveElapsedMilliseconds();
+	}
+	{
+		AlignedHeap aligned(n);
+		timer.Start();
+		for (uint32_t i = 0; i < n; ++i) aligned.Update(elements[i], double(coins[i] % 1000));
+		DrainLazily(aligned, coins, order);
+		lazyVariantMilliseconds = timer.LiveElapsedMilliseconds();
+	}
+	report.Add("AlignedKHeap lazy updates", order == referenceOrder, order == referenceOrder ? "identical order" : "different order", lazyReferenceMilliseconds, lazyVariantMilliseconds);
+
+	// Batches of updates (every 64th batch updates half of the heap), applied one by one to KHeap.
+	vector<vector<pair<uint32_t, double>>> batches;
+	{
+		// Draw the batches against a set of the contained elements.
+		ScalarHeap scalar(numBatched);
+		for (uint32_t i = 0; i < numBatched; ++i) scalar.Update(elements[i], keys[i]);
+		while (!scalar.Empty()) {
+			scalar.DeleteMin();
+			vector<pair<uint32_t, double>> batch;
+			const size_t batchSize = batches.size() % 64 == 0 ? scalar.Size() / 2 : 1 + twisty() % 64;
+			for (size_t j = 0; j < batchSize && !scalar.Empty(); ++j) {
+				const uint32_t v = static_cast<uint32_t>(twisty() % numBatched);
+				if (!scalar.Contains(v)) continue;
+				batch.push_back(make_pair(v, uniform(twisty)));
+				scalar.Update(v, batch.back().second);
+			}
+			batches.push_back(batch);
+		}
+	}
+	vector<double> referenceKeys, batchedKeys;
+	double batchReferenceMilliseconds(0), batchVariantMilliseconds(0);
+	{
+		ScalarHeap scalar(numBatched);
+		timer.Start();
+		for (uint32_t i = 0; i < numBatched; ++i) scalar.Update(elements[i], keys[i]);
+		for (const vector<pair<uint32_t, double>> &batch : batches) {
+			double key;
+			scalar.DeleteMin(key);
+			referenceKeys.push_back(key);
+			for (const pair<uint32_t, double> &update : batch) scalar.Update(update.first, update.second);
+		}
+		batchReferenceMilliseconds = timer.LiveElapsedMilliseconds();
+	}
+	{
+		AlignedHeap aligned(numBatched);
+		timer.Start();
+		aligned.Build(elements.data(), keys.data(), numBatched);
+		for (const vector<pair<uint32_t, double>> &batch : batches) {
+			double key;
+			aligned.DeleteMin(key);
+			batchedKeys.push_back(key);
+			aligned.UpdateBatch(batch);
+		}
+		batchVariantMilliseconds = timer.LiveElapsedMilliseconds();
+	}
+	report.Add("AlignedKHeap batched updates", batchedKeys == referenceKeys, batchedKeys == referenceKeys ? "identical keys" : "different keys", batchReferenceMilliseconds, batchVariantMilliseconds);
+}
+
+
+// Runs the pagerank heuristic with the binary model on a dense graph (3000 vertices of average
+// out-degree 80, p = 0.1), on which the undamped sums of the arc probabilities exceed one. The
+// scores must stay finite and bounded (by 1 / 0.15), and the iteration must converge.
+void VerifyHeuristics(const Tools::CommandLineParser &clp, VerificationReport &report) {
+	typedef Algorithms::InfluenceMaximization::HeuristicSeeds HeuristicSeeds;
+	const uint32_t s = clp.Value<uint32_t>("seed", 31101982);
+	DataStructures::Graphs::FastUnweightedGraph graph;
+	GenerateGraph(graph, "gnm", 3000, 80, s);
+	HeuristicSeeds heuristic(graph, s, false);
+	heuristic.SetBinaryProbability(0.1);
+	Platform::Timer timer;
+	timer.Start();
+	const vector<SKIM::SeedType> seeds = heuristic.Run<SKIM::BINARY>(HeuristicSeeds::PAGERANK, 50, 0, 0, 0, 1);
+	const double milliseconds = timer.LiveElapsedMilliseconds();
+	bool bounded = !seeds.empty();
+	for (const SKIM::SeedType &seed : seeds)
+		bounded = bounded && std::isfinite(seed.EstimatedInfluence) && seed.EstimatedInfluence >= 1.0 && seed.EstimatedInfluence <= 1.0 / 0.15;
+	const bool converged = heuristic.PageRankRounds() < 50;
+	report.Add("HeuristicSeeds pagerank on a dense graph", bounded && converged, (bounded ? "bounded scores, " : "unbounded scores, ") + to_string(heuristic.PageRankRounds()) + " rounds", milliseconds, milliseconds);
+}
+
+
+template<Oracle::ModelType modelType>
+int RunVerification(const Tools::CommandLineParser &clp) {
+	VerificationReport report;
+	VerifyMerge(clp, report);
+	VerifyHeaps(clp, report);
+	VerifyHeuristics(clp, report);
+	const uint32_t d = clp.Value<uint32_t>("d", 8);
+	const uint32_t s = clp.Value<uint32_t>("seed", 31101982);
+	for (const string &generator : Tools::Split(clp.Value<string>("g", "gnm,pa"), ',')) {
+		if (generator != "gnm" && generator != "pa") Usage(clp.ExecutableName());
+		for (const Types::IndexType n : Tools::ExtractRange(clp.Value<string>("n", "2000,10000"))) {
+			cout << endl << "Graph " << generator << " with " << n << " vertices:" << endl;
+			DataStructures::Graphs::FastUnweightedGraph graph;
+			GenerateGraph(graph, generator, static_cast<uint32_t>(n), d, s);
+			VerifyTransforms(graph, clp, report);
+			VerifyTraversal(graph, clp, report);
+			VerifySKIM<modelType>(graph, clp, report);
+			VerifyOracle<modelType>(graph, clp, report);
+		}
+	}
+	cout << endl << (report.NumFailures() == 0 ? "All checks passed." : to_string(report.NumFailures()) + " checks FAILED.") << endl;
+	return report.NumFailures() == 0 ? 0 : 1;
+}
+
+
+int main(int argc, char **argv) {
+
+	Tools::CommandLineParser clp(argc, argv);
+	if (clp.IsSet("h")) Usage(argv[0]);
+	const string modelStr = clp.Value<string>("m", "weighted");
+
+	// Determine IC model and run the checks.
+	if (modelStr == "binary")
+		return RunVerification<Oracle::BINARY>(clp);
+	if (modelStr == "trivalency")
+		return RunVerification<Oracle::TRIVALENCY>(clp);
+	if (modelStr == "weighted")
+		return RunVerification<Oracle::WEIGHTED>(clp);
+	Usage(argv[0]);
+	return 1;
+}
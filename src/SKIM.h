@@ -17,9 +17,9 @@ THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <array>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <unordered_map>
 #include <random>
 #include <climits>
 #include <omp.h>
@@ -28,9 +28,17 @@ using namespace std;
 #include "FastStaticGraphs.h"
 #include "Macros.h"
 #include "FastSet.h"
-#include "HashPair.h"
+#include "ListArena.h"
 #include "Timer.h"
 #include "KHeap.h"
+#include "BitVector.h"
+#include "BitOperations.h"
+#include "HubAdjacency.h"
+#include "Traversal.h"
+#include "AccessProfile.h"
+#include "MappedFile.h"
+#include "AllocationTracker.h"
+#include "Introspection.h"
 
 namespace Algorithms{
 namespace InfluenceMaximization {
@@ -81,45 +89,283 @@ public:
 		binprob = uint32_t(prob * double(resolution));
 	}
 
-	// Run.
+	// Represent the neighborhoods of vertices with at least threshold arcs (in either direction)
+	// additionally as bitmaps (zero turns this off). This does not change the results.
+	inline void SetHubThreshold(const Types::SizeType threshold) {
+		if (verbose) cout << "Building hub bitmaps (threshold " << threshold << ")... " << flush;
+		forwardHubs.Build(graph, Types::FORWARD_DIRECTION, threshold);
+		backwardHubs.Build(graph, Types::BACKWARD_DIRECTION, threshold);
+		if (verbose) cout << "done." << endl;
+		if (verbose) forwardHubs.DumpStatistics(cout);
+		if (verbose) backwardHubs.DumpStatistics(cout);
+	}
+
+	// Draw up to lookahead ranks in advance and, when running in parallel, build the search spaces of
+	// the upcoming ranks of each instance right after its influence BFS (at most maxVertices each).
+	// These are validated against the coverage before use, so the seeds do not change (zero turns this off).
+	inline void SetPipelining(const uint32_t lookahead, const uint32_t maxVertices = 4096) {
+		pipelineLookahead = lookahead;
+		maxSpeculativeVertices = max<uint32_t>(maxVertices, 1);
+	}
+
+	// Place the coverage and processed flags of all vertex/instance pairs (2*n*l bits) in a memory
+	// mapped temporary file in this directory (empty turns this off), so runs complete with less memory.
+	// The coverage flags of an instance are contiguous (the influence BFSes walk the instances in order
+	// and write the flags they set back right away), as are the processed flags of a vertex (a rank
+	// picks an instance of a vertex). Only these flags move out of core: the graph and the inverse
+	// sketches (or the flags of SetLowMemory) stay in memory, and the instances are still visited in the
+	// order the ranks are drawn (which determines the seeds), not reordered for locality. While the flags
+	// fit into the page cache, this costs a few percent; beyond, every rank drawn and every vertex reached
+	// may fault a page in, so the slowdown grows with the fraction of the flags that does not fit. With
+	// l = 512 on a graph with 1M vertices (128 MiB of flags, 500 MiB peak), memory limits of 448, 400,
+	// 368 and 336 MiB took 1.0, 1.7, 3.2 and 5.5 times as long; in memory, the run failed at 448 MiB.
+	inline void SetOutOfCore(const string directory) {
+		stateDirectory = directory;
+	}
+
+	// Do not store the inverse sketches (the vertices each rank's reverse BFS reached), which take most
+	// of the memory before saturation, but only flag the ranks that have one (n*l bits). When the source
+	// of such a rank gets covered, its BFS is replayed to find them: as the coverage of an instance is
+	// closed under reachability, nothing that reaches an uncovered source is covered, so the replay
+	// (which ignores the coverage) reaches the same vertices in the same order. Only the BFS that found a
+	// seed stopped early; its length is kept. The seeds do not change; the replays cost up to another
+	// reverse BFS per rank that gets covered.
+	inline void SetLowMemory(const bool replay) {
+		lowMemory = replay;
+	}
+
+	// Weigh the vertices (nullptr turns this off), e.g., by the sizes of the clusters they stand for in a
+	// contracted graph. Influence then sums the weights of the reached vertices, and each round of rank
+	// draws orders the vertices by exponential keys of rate weight, so heavy vertices come first. As
+	// about rank/(total weight) of the key space is drawn, the estimates scale by the total weight
+	// instead of the number of vertices (approximately, since the rounds are not independent keys).
+	// The weights must outlive the runs.
+	inline void SetVertexWeights(const vector<uint32_t> *weights) {
+		vertexWeights = weights;
+	}
+
+	// Restrict the seeds to the candidates (nullptr turns this off). The sketches are built on the
+	// subgraph induced by the candidates: ranks are drawn from them, and the reverse BFSes do not leave
+	// them. Hence the estimates count reachable candidates only, while the exact influence of each
+	// seed (and the coverage) is still computed on the whole graph. The candidates must outlive the runs.
+	inline void SetCandidates(const DataStructures::Container::BitVector *c) {
+		candidates = c;
+	}
+
+	// Measure influence on the targets only (nullptr turns this off), e.g., a region or an audience.
+	// Ranks are drawn from the target/instance pairs only, so the reverse BFSes start at targets (but
+	// traverse the whole graph), and there are |T|*l instead of n*l of them. The estimates, the exact
+	// influence and the coverage count targets (or their weights). The targets must outlive the runs.
+	inline void SetTargets(const DataStructures::Container::BitVector *t) {
+		targets = t;
+	}
+
+	// Count the vertex visits of the sketch and influence BFSes in a profile (nullptr turns this off).
+	// The profile needs counters for as many threads as the algorithm runs with.
+	inline void SetProfile(Tools::AccessProfile *p) {
+		profile = p;
+		if (profile == nullptr) return;
+		sketchPhase = profile->Phase("SKIM sketches", Types::BACKWARD_DIRECTION);
+		influencePhase = profile->Phase("SKIM influence", Types::FORWARD_DIRECTION);
+	}
+
+	// Run. Returns the computed seed vertices, or none (after an error message) if the out-of-core
+	// state cannot be created.
 	template<ModelType modelType>
-	inline void Run(uint32_t N, const uint16_t k, const uint16_t l, const uint16_t lEval, const int32_t numt, const string statsFilename = "", const string coverageFilename = "") {
+	inline vector<SeedType> Run(uint32_t N, const uint16_t k, const uint16_t l, const uint16_t lEval, const int32_t numt, const string statsFilename = "", const string coverageFilename = "") {
 		// Set N to number of vertices, if it's zero.
 		if (N == 0) N = static_cast<uint32_t>(graph.NumVertices());
 		/*
 		Initialize the algorithm.
 		*/
 		if (verbose) cout << "Setting up data structures... " << flush;
+		const uint16_t setupAllocations = Tools::AllocationTracker::Phase("SKIM setup");
+		const uint16_t sketchAllocations = Tools::AllocationTracker::Phase("SKIM sketches");
+		const uint16_t influenceAllocations = Tools::AllocationTracker::Phase("SKIM influence");
+		Tools::AllocationTracker::Scope allocationScope(setupAllocations);
 		// Some datastructures that are necessary for the algorithm.
-		const uint64_t nl = graph.NumVertices()*l;
+		uint64_t numRankVertices(0); // the number of vertices to draw ranks from (the candidates and targets, if any).
+		double totalWeight(0); // the weight of these vertices (their number, without weights).
+		FORALL_VERTICES(graph, u) {
+			if (!IsRankVertex(u)) continue;
+			++numRankVertices;
+			totalWeight += Weight(u);
+		}
+		const uint64_t nl = numRankVertices*l; // the number of ranks.
+		const uint64_t numPairs = graph.NumVertices()*uint64_t(l); // the number of vertex/instance pairs.
 		vector<SeedType> seedSet; // this will hold the seed vertices.
 		vector<uint32_t> permutation; // this is a permutation of the vertices to draw ranks from.
-		unordered_map< pair<uint32_t, uint16_t>, vector<uint32_t> > invSketches; // these are the "inverse sketches" (search spaces).
+		DataStructures::Container::ListArena invSketches; // these are the "inverse sketches" (search spaces) of the ranks.
+		DataStructures::Container::BitVector sketched; // low memory: this indicates whether a vertex/instance pair has an inverse sketch to replay.
+		DataStructures::Container::FlatMap<uint32_t> truncated; // low memory: these are the lengths of the inverse sketches whose BFS found a seed.
+		DataStructures::Container::FastSet<uint32_t> replaySpace; // low memory: this is the search space of replays in the sequential influence BFSes.
+		vector<vector<uint32_t>> replayed(numt); // low memory: these are the vertices of the inverse sketches each thread replayed.
+		uint64_t numReplays(0);
+		Types::SizeType peakInvSketchBytes(0);
 		vector<uint16_t> sketchSizes(graph.NumVertices(), 0); // these are the sizes of the real sketches.
-		vector<vector<bool>> covered(l); // this indicates whether a vertex/instance pair has been covered (influenced).
-		vector<vector<bool>> processed(l); // this indicates whether a vertex/instance pair has been processed (sketches built from it).
+		vector<DataStructures::Container::BitVector> covered(l); // this indicates whether a vertex/instance pair has been covered (influenced).
+		DataStructures::Container::BitVector processed; // this indicates whether a vertex/instance pair has been processed (sketches built from it), with the instances of a vertex together.
+		Platform::MappedFile stateFile; // this holds covered and processed out of core.
 		vector<DataStructures::Container::FastSet<uint32_t>> searchSpaces(numt); // this is for maintaining search spaces of BFSes; one per thread.
 		DataStructures::Container::FastSet<uint32_t> &S0 = searchSpaces[0];
-		vector<vector<pair<uint32_t, uint16_t>>> updateQueues(numt);
+		vector<vector<uint64_t>> updateQueues(numt);
 		vector<vector<uint32_t>> buck;
 		vector<uint32_t> buckind;
 		uint16_t buckp(0);
 		mt19937_64 rnd(randomSeed); // Random number generator.
 		uniform_int_distribution<uint16_t> distr(0, l - 1);
+		exponential_distribution<double> expo(1.0);
+		vector<double> keys;
 		uint64_t rank(0); // this is the current rank value.
-		Platform::Timer timer, globalTimer;
-		double estinf(0), exinf(0), exinfloc(0), sketchms(0), infms(0);
+		uint64_t nextRank(0); // this is the number of ranks drawn (runs ahead of rank when pipelining).
+		vector<UpcomingRank> upcoming; // these are ranks drawn in advance, with speculative search spaces.
+		vector<vector<uint32_t>> upcomingByInstance(l);
+		size_t upcomingHead(0), numUpcoming(0); // the next and the number of upcoming ranks (the rest are spare).
+		uint64_t numSpeculated(0), numSpeculationsUsed(0);
+		Platform::Timer timer, globalTimer, iterationTimer;
+		Tools::ProgressCounters numSearches(numt), numVisited(numt); // the BFSes and their visited vertices, per thread.
+		Tools::RecentTimings iterationTimings;
+		double estinf(0), exinf(0), exinfloc(0), sketchms(0), infms(0), replayms(0);
 		bool runParallel(numt > 1), saturated(false);
 		uint32_t numperm(0), permthresh(l - (l / 10 + 1));
 
+		// Draws the next vertex/instance pair of the rank sequence.
+		auto drawRank = [&](uint32_t &sourceVertexId, uint16_t &i) {
+			const Types::SizeType vi = nextRank % numRankVertices;
+			if (vi == 0)	{
+				if (permutation.size() != numRankVertices) {
+					permutation.resize(numRankVertices, 0);
+					uint32_t j(0);
+					FORALL_VERTICES(graph, u)
+						if (IsRankVertex(u)) permutation[j++] = u;
+				}
+				if (vertexWeights == nullptr)
+					shuffle(permutation.begin(), permutation.end(), rnd);
+				else {
+					keys.resize(graph.NumVertices());
+					for (const uint32_t u : permutation) keys[u] = expo(rnd) / Weight(u);
+					sort(permutation.begin(), permutation.end(), [&](const uint32_t a, const uint32_t b) { return keys[a] < keys[b]; });
+				}
+				++numperm;
+			}
+			sourceVertexId = permutation[vi];
+			i = 0;
+			if (numperm < permthresh) {
+				do {
+					i = distr(rnd);
+				} while (processed[sourceVertexId * uint64_t(l) + i]);
+			}
+			else {
+				i = distr(rnd) % (l - numperm + 1);
+				for (uint16_t j = 0; j < l; ++j) {
+					if (!processed[sourceVertexId * uint64_t(l) + j]) {
+						if (i == 0) {
+							i = j;
+							break;
+						}
+						--i;
+					}
+				}
+			}
+			processed.Set(sourceVertexId * uint64_t(l) + i);
+
+			++nextRank;
+		};
+
 		for (int32_t t = 0; t < numt; ++t)
 			searchSpaces[t].Resize(graph.NumVertices());
-		for (uint16_t i(0); i < l; ++i) {
-			processed[i].resize(graph.NumVertices(), false);
-			covered[i].resize(graph.NumVertices(), false);
+		const Types::SizeType wordsPerInstance = (graph.NumVertices() + 63) / 64;
+		if (stateDirectory.empty()) {
+			processed.Resize(numPairs);
+			for (uint16_t i(0); i < l; ++i)
+				covered[i].Resize(graph.NumVertices());
+		}
+		else {
+			// The covered flags of each instance, followed by the processed flags.
+			if (!stateFile.Create(stateDirectory, (l * wordsPerInstance + (numPairs + 63) / 64) * sizeof(uint64_t))) {
+				cerr << endl << "ERROR: Could not map the out-of-core state into '" << stateDirectory << "', no seeds computed." << endl;
+				return seedSet;
+			}
+			uint64_t *words = reinterpret_cast<uint64_t*>(stateFile.Data());
+			for (uint16_t i(0); i < l; ++i)
+				covered[i].Attach(words + i * wordsPerInstance, graph.NumVertices());
+			processed.Attach(words + l * wordsPerInstance, numPairs);
+			stateFile.Advise(0, stateFile.NumBytes(), Platform::MappedFile::RANDOM_ACCESS);
+			if (verbose) cout << "(" << stateFile.NumBytes() / 1024.0 / 1024.0 << " MiB mapped from " << stateFile.Filename() << ") " << flush;
+		}
+		const ForwardTraversal forward(graph, forwardHubs);
+		const BackwardTraversal backward(graph, backwardHubs);
+		if (lowMemory) {
+			sketched.Resize(numPairs);
+			if (!runParallel) replaySpace.Resize(graph.NumVertices());
 		}
 		if (verbose) cout << "done." << endl;
 
+		// Whether vertex u has the inverse sketch of a rank in instance i, and erasing the sketch of a key.
+		auto hasSketch = [&](const uint32_t u, const uint16_t i) {
+			return lowMemory ? sketched[u * uint64_t(l) + i] : invSketches.Contains(InverseSketchKey(u, i));
+		};
+		auto eraseSketch = [&](const uint64_t key) {
+			if (!lowMemory) {
+				invSketches.Erase(key);
+				return;
+			}
+			sketched.Reset((key >> 16) * l + (key & 0xFFFF));
+			truncated.Erase(key);
+		};
+
+		// Takes a vertex of the inverse sketch of a covered rank out of the sketch sizes (and buckets).
+		auto uncount = [&](const uint32_t v) {
+			if (saturated) {
+				const uint16_t s = sketchSizes[v];
+				// Erase from bucket.
+				buckind[buck[s].back()] = buckind[v];
+				swap(buck[s][buckind[v]], buck[s].back());
+				buck[s].pop_back();
+				if (s > 1) {
+					buckind[v] = uint32_t(buck[s - 1].size());
+					buck[s - 1].push_back(v);
+				}
+			}
+			--sketchSizes[v];
+		};
+
+		// Out of core, starts writing back the words of covered[i] set by the BFS with search space S,
+		// such that their pages can be evicted without waiting for the write.
+		auto writeBack = [&](const uint16_t i, const DataStructures::Container::FastSet<uint32_t> &S) {
+			if (!stateFile.IsOpen() || S.Size() == 0) return;
+			uint32_t first(UINT32_MAX), last(0);
+			for (Types::IndexType j = 0; j < S.Size(); ++j) {
+				first = min(first, S.KeyByIndex(j));
+				last = max(last, S.KeyByIndex(j));
+			}
+			stateFile.Flush((i * wordsPerInstance + first / 64) * sizeof(uint64_t), (last / 64 - first / 64 + 1) * sizeof(uint64_t));
+		};
+
+		// Writes the progress and the memory of the structures to a snapshot (see Tools::Introspection).
+		auto writeSnapshot = [&](ostream &os) {
+			os << "  Seeds: " << seedSet.size() << " of " << N << ", rank: " << rank << " of " << nl << " (drawn: " << nextRank << ", permutations: " << numperm << ")"
+				<< (saturated ? ", saturated" : "") << endl
+				<< "  Current iteration: " << iterationTimer.LiveElapsedMilliseconds() << " ms (sketches: " << sketchms << " ms, influence: " << infms << " ms in total)" << endl;
+			iterationTimings.Write(os, "Recent iterations");
+			numSearches.Write(os, "Searches");
+			numVisited.Write(os, "Vertices visited");
+			Types::SizeType coveredBytes(processed.MemoryBytes()), searchSpaceBytes(replaySpace.MemoryBytes()), bucketBytes(buckind.capacity() * sizeof(uint32_t)), upcomingBytes(upcoming.capacity() * sizeof(UpcomingRank));
+			for (const DataStructures::Container::BitVector &cov : covered) coveredBytes += cov.MemoryBytes();
+			for (const DataStructures::Container::FastSet<uint32_t> &S : searchSpaces) searchSpaceBytes += S.MemoryBytes();
+			for (const vector<uint32_t> &b : buck) bucketBytes += b.capacity() * sizeof(uint32_t);
+			for (const UpcomingRank &upcomingRank : upcoming) upcomingBytes += upcomingRank.Visited.capacity() * sizeof(uint32_t);
+			os << "  Memory:" << endl;
+			Tools::Introspection::WriteMemory(os, "Sketch sizes", sketchSizes.capacity() * sizeof(uint16_t));
+			Tools::Introspection::WriteMemory(os, "Covered and processed flags", coveredBytes);
+			if (stateFile.IsOpen()) Tools::Introspection::WriteMemory(os, "Mapped state file", stateFile.NumBytes());
+			Tools::Introspection::WriteMemory(os, "Inverse sketches", lowMemory ? sketched.MemoryBytes() + truncated.MemoryBytes() : invSketches.MemoryBytes());
+			Tools::Introspection::WriteMemory(os, "Search spaces", searchSpaceBytes);
+			Tools::Introspection::WriteMemory(os, "Permutation", permutation.capacity() * sizeof(uint32_t));
+			Tools::Introspection::WriteMemory(os, "Buckets", bucketBytes);
+			Tools::Introspection::WriteMemory(os, "Upcoming ranks", upcomingBytes);
+		};
+
 		/*
 		Main iterations loop. Each iteration computes one seed vertex.
 		*/
@@ -127,84 +373,80 @@ public:
 		while (seedSet.size() < N) {
 			SeedType newSeed;
 			exinfloc = 0.0;
+			iterationTimer.Start();
 
 			/*
 			BFS computation to build sketches.
 			*/
 			if (!saturated) {
 				if (verbose) cout << "[" << seedSet.size() + 1 << "] Computing sketches from rank " << rank << "... " << flush;
+				Tools::AllocationTracker::SetPhase(sketchAllocations);
 				timer.Start();
+				invSketches.Compact();
 				while (rank < nl) {
-					// Select next vertex/instance pair.
-					const Types::SizeType vi = rank % graph.NumVertices();
-					if (vi == 0)	{
-						if (permutation.size() != graph.NumVertices()) {
-							permutation.resize(graph.NumVertices(), 0);
-							for (uint32_t u(0); u < graph.NumVertices(); ++u) permutation[u] = u;
-						}
-						shuffle(permutation.begin(), permutation.end(), rnd);
-						++numperm;
-					}
-					const uint32_t sourceVertexId = permutation[vi];
-					uint16_t i = 0;
-					if (numperm < permthresh) {
-						do {
-							i = distr(rnd);
-						} while (processed[i][sourceVertexId]);
-					}
-					else {
-						i = distr(rnd) % (l - numperm + 1);
-						for (uint16_t j = 0; j < l; ++j) {
-							if (!processed[j][sourceVertexId]) {
-								if (i == 0) {
-									i = j;
-									break;
-								}
-								--i;
-							}
-						}
+					if (Tools::Introspection::Requested()) Tools::Introspection::Write("SKIM", writeSnapshot);
+
+					// Select next vertex/instance pair, preferring one drawn in advance.
+					uint32_t sourceVertexId;
+					uint16_t i;
+					UpcomingRank *upcomingRank = nullptr;
+					if (upcomingHead < numUpcoming) {
+						upcomingRank = &upcoming[upcomingHead++];
+						sourceVertexId = upcomingRank->VertexId;
+						i = upcomingRank->Instance;
 					}
-					processed[i][sourceVertexId] = true;
+					else drawRank(sourceVertexId, i);
 
 					++rank; // Increase value for rank.
 
 					// Shortcut to some variables.
-					vector<bool> &cov = covered[i];
-					vector<uint32_t> &invSketch = invSketches[make_pair(sourceVertexId, i)];
+					DataStructures::Container::BitVector &cov = covered[i];
 
 					// Only process such ranks that are not yet covered.
 					if (cov[sourceVertexId]) continue;
+					if (!lowMemory) invSketches.Open(InverseSketchKey(sourceVertexId, i));
+					else sketched.Set(sourceVertexId * uint64_t(l) + i);
 
-					// Perform the BFS.
+					// Perform the BFS, resuming from the speculative search space if it is still uncovered.
 					S0.Clear();
-					S0.Insert(sourceVertexId);
+					uint32_t numExpanded = 0;
+					if (upcomingRank != nullptr && upcomingRank->Speculated && IsUncovered(upcomingRank->Visited, cov)) {
+						for (const uint32_t v : upcomingRank->Visited)
+							S0.Insert(v);
+						numExpanded = upcomingRank->NumExpanded;
+						++numSpeculationsUsed;
+					}
+					else S0.Insert(sourceVertexId);
 					uint32_t ind = 0;
-					while (ind < S0.Size()) {
-						uint32_t u = S0.KeyByIndex(ind++);
+					auto visit = [&](const uint32_t u) {
 						++sketchSizes[u];
-						invSketch.push_back(u);
+						if (!lowMemory) invSketches.Append(u);
 
 						// pruning.
 						if (sketchSizes[u] == k) {
 							// Set the vertex and compute marginal influence.
 							newSeed.VertexId = u;
-							newSeed.EstimatedInfluence = static_cast<double>(k - 1) * static_cast<double>(graph.NumVertices()) / static_cast<double>(rank);
-							break;
+							newSeed.EstimatedInfluence = static_cast<double>(k - 1) * totalWeight / static_cast<double>(rank);
+							return DataStructures::Graphs::STOP_TRAVERSAL;
 						}
 
-						// arc expansion.
-						FORALL_INCIDENT_ARCS_BACKWARD(graph, u, a) {
-							if (!a->Backward()) break;
-							const uint32_t v = a->OtherVertexId();
-							if (Contained<modelType>(v, u, i, l) && !cov[v] && !S0.IsContained(v))
-							//if (ContainedRandom<modelType>(v, u) && !cov[v] && !S0.IsContained(v))
-								S0.Insert(v);
-						}
-					}
+						// arc expansion (unless the speculative search already did it).
+						if (ind++ >= numExpanded && profile != nullptr) profile->Visit(0, sketchPhase, u);
+						return DataStructures::Graphs::SCAN_ARCS;
+					};
+					if (candidates == nullptr)
+						backward.Run(S0, cov, InstanceCoin<modelType>(*this, i, l), visit, numExpanded);
+					else
+						backward.Run(S0, CoveredOrExcluded(cov, *candidates), InstanceCoin<modelType>(*this, i, l), visit, numExpanded);
+					numSearches.Add(0);
+					numVisited.Add(0, S0.Size());
+					if (!lowMemory) invSketches.Close();
+					else if (newSeed.VertexId != NullVertex) truncated.Insert(InverseSketchKey(sourceVertexId, i), ind + 1);
 					if (newSeed.VertexId != NullVertex)
 						break;
 				} // end sketch building.
 				sketchms += timer.LiveElapsedMilliseconds();
+				peakInvSketchBytes = max(peakInvSketchBytes, lowMemory ? sketched.NumWords() * sizeof(uint64_t) + truncated.MemoryBytes() : invSketches.MemoryBytes());
 				newSeed.BuildSketchesElapsedMilliseconds = sketchms;
 				if (verbose) cout << " done (u: " << newSeed.VertexId << ", est: " << newSeed.EstimatedInfluence << " r: " << rank << ", ms: " << newSeed.BuildSketchesElapsedMilliseconds << ")" << endl;
 
@@ -237,7 +479,7 @@ public:
 				if (verbose) cout << "[" << seedSet.size() + 1 << "] Determining the vertex that has highest marginal influence... " << flush;
 				Assert(!buck[buckp].empty());
 				newSeed.VertexId = buck[buckp].back();
-				newSeed.EstimatedInfluence = double(sketchSizes[newSeed.VertexId]) / l;
+				newSeed.EstimatedInfluence = double(sketchSizes[newSeed.VertexId]) / l * (totalWeight / double(numRankVertices));
 				newSeed.BuildSketchesElapsedMilliseconds = sketchms;
 				if (verbose) cout << " done (u: " << newSeed.VertexId << ", est: " << newSeed.EstimatedInfluence << ")" << endl;
 			}
@@ -248,11 +490,32 @@ public:
 			Also updates the sketch sizes.
 			*/
 			if (verbose) cout << "[" << seedSet.size() + 1 << "] Computing influence... " << flush;
+			Tools::AllocationTracker::SetPhase(influenceAllocations);
 			timer.Start();
 
 			// Call sequential or parallel BFS to compute influences.
 			if (runParallel) {
-#pragma omp parallel num_threads(numt) reduction(+ : exinfloc)
+				// Draw the upcoming ranks, whose search spaces are computed speculatively per instance.
+				if (pipelineLookahead > 0 && !saturated) {
+					// The used ranks move to the back, where they keep their memory for the next ones.
+					rotate(upcoming.begin(), upcoming.begin() + upcomingHead, upcoming.begin() + numUpcoming);
+					numUpcoming -= upcomingHead;
+					upcomingHead = 0;
+					while (numUpcoming < pipelineLookahead && nextRank < nl) {
+						if (numUpcoming == upcoming.size()) upcoming.emplace_back();
+						UpcomingRank &upcomingRank = upcoming[numUpcoming++];
+						upcomingRank.Speculated = false;
+						upcomingRank.NumExpanded = 0;
+						upcomingRank.Visited.clear();
+						drawRank(upcomingRank.VertexId, upcomingRank.Instance);
+					}
+					for (uint16_t i(0); i < l; ++i)
+						upcomingByInstance[i].clear();
+					for (uint32_t r(0); r < numUpcoming; ++r)
+						upcomingByInstance[upcoming[r].Instance].push_back(r);
+				}
+
+#pragma omp parallel num_threads(numt) reduction(+ : exinfloc, numSpeculated, numReplays, replayms)
 				{
 					// Get thread id.
 					const int32_t t = omp_get_thread_num();
@@ -260,33 +523,50 @@ public:
 					auto &S = searchSpaces[t];
 					auto &Q = updateQueues[t];
 					Q.clear();
+					replayed[t].clear();
 
 #pragma omp for
 					for (int32_t i = 0; i < l; ++i) {
 						// Shortcut to some variables.
-						vector<bool> &cov = covered[i];
+						DataStructures::Container::BitVector &cov = covered[i];
 
 						// Run a BFS.
 						S.Clear();
 						if (!cov[newSeed.VertexId])
 							S.Insert(newSeed.VertexId);
-						uint32_t ind = 0;
-						while (ind < S.Size()) {
-							uint32_t u = S.KeyByIndex(ind++);
-							cov[u] = true;
-							++exinfloc;
+						const size_t firstKey = Q.size();
+						forward.Run(S, cov, InstanceCoin<modelType>(*this, static_cast<uint16_t>(i), l), [&](const uint32_t u) {
+							cov.Set(u);
+							exinfloc += Weight(u);
+							if (profile != nullptr) profile->Visit(t, influencePhase, u);
 
 							// Update counters and sketches.
-							const pair<uint32_t, uint16_t> key(u, i);
-							if (invSketches.count(key)) {
-								Q.push_back(key);
-							}
+							if (hasSketch(u, static_cast<uint16_t>(i)))
+								Q.push_back(InverseSketchKey(u, static_cast<uint16_t>(i)));
+							return DataStructures::Graphs::SCAN_ARCS;
+						});
+
+						writeBack(static_cast<uint16_t>(i), S);
+						numSearches.Add(t);
+						numVisited.Add(t, S.Size());
+
+						// Without stored inverse sketches, recompute those of the covered ranks.
+						if (lowMemory && firstKey < Q.size()) {
+							Platform::Timer replayTimer;
+							replayTimer.Start();
+							for (size_t q = firstKey; q < Q.size(); ++q)
+								ReplaySketch<modelType>(Q[q], l, truncated, S, [&](const uint32_t v) { replayed[t].push_back(v); });
+							numReplays += Q.size() - firstKey;
+							replayms += replayTimer.LiveElapsedMilliseconds();
+						}
 
-							FORALL_INCIDENT_ARCS(graph, u, a) {
-								if (!a->Forward()) break;
-								const uint32_t v = a->OtherVertexId();
-								if (Contained<modelType>(u, v, i, l) && !S.IsContained(v) && !cov[v])
-									S.Insert(v);
+						// Speculate on the upcoming ranks of this instance while other instances are still running.
+						for (const uint32_t r : upcomingByInstance[i]) {
+							UpcomingRank &upcomingRank = upcoming[r];
+							if (!upcomingRank.Speculated || !IsUncovered(upcomingRank.Visited, cov)) {
+								if (candidates == nullptr) Speculate<modelType>(t, upcomingRank, l, cov, S);
+								else Speculate<modelType>(t, upcomingRank, l, CoveredOrExcluded(cov, *candidates), S);
+								++numSpeculated;
 							}
 						}
 					} // end exact influence computation.
@@ -294,78 +574,56 @@ public:
 
 				// Update the counters.
 				for (int32_t t = 0; t < numt; ++t) {
-					vector<pair<uint32_t, uint16_t>> &Q = updateQueues[t];
-					for (const pair<uint32_t, uint16_t> &key : Q) {
-						const vector<uint32_t> &invSketch = invSketches[key];
-						if (!saturated) {
-							for (const uint32_t &v : invSketch)
-								--sketchSizes[v];
-						}
-						else {
-							for (const uint32_t &v : invSketch) {
-								uint16_t s = sketchSizes[v];
-								// Erase from bucket.
-								buckind[buck[s].back()] = buckind[v];
-								swap(buck[s][buckind[v]], buck[s].back());
-								buck[s].pop_back();
-								if (sketchSizes[v] > 1) {
-									buckind[v] = uint32_t(buck[sketchSizes[v] - 1].size());
-									buck[sketchSizes[v] - 1].push_back(v);
-								}
-								--sketchSizes[v];
-							}
+					vector<uint64_t> &Q = updateQueues[t];
+					if (lowMemory) {
+						for (const uint32_t v : replayed[t])
+							uncount(v);
+					}
+					for (const uint64_t key : Q) {
+						if (!lowMemory) {
+							for (const uint32_t &v : invSketches.List(key))
+								uncount(v);
 						}
-						invSketches.erase(key);
+						eraseSketch(key);
 					}
 				}
 			} // end parallel branch.
 			else { // begin sequential branch.
 				for (int32_t i = 0; i < l; ++i) {
 					// Shortcut to some variables.
-					vector<bool> &cov = covered[i];
+					DataStructures::Container::BitVector &cov = covered[i];
 
 					// Run a BFS.
 					S0.Clear();
 					if (!cov[newSeed.VertexId])
 						S0.Insert(newSeed.VertexId);
-					uint32_t ind = 0;
-					while (ind < S0.Size()) {
-						uint32_t u = S0.KeyByIndex(ind++);
-						cov[u] = true;
-						++exinfloc;
+					forward.Run(S0, cov, InstanceCoin<modelType>(*this, static_cast<uint16_t>(i), l), [&](const uint32_t u) {
+						cov.Set(u);
+						exinfloc += Weight(u);
+						if (profile != nullptr) profile->Visit(0, influencePhase, u);
 
 						// Update counters and sketches.
-						const pair<uint32_t, uint16_t> key(u, i);
-						if (invSketches.count(key)) {
-							const vector<uint32_t> &invSketch = invSketches[key];
-							if (!saturated) {
-								for (const uint32_t &v : invSketch)
-									--sketchSizes[v];
+						if (hasSketch(u, static_cast<uint16_t>(i))) {
+							const uint64_t key = InverseSketchKey(u, static_cast<uint16_t>(i));
+							if (lowMemory) {
+								// Without stored inverse sketches, recompute the one of the covered rank.
+								Platform::Timer replayTimer;
+								replayTimer.Start();
+								ReplaySketch<modelType>(key, l, truncated, replaySpace, uncount);
+								++numReplays;
+								replayms += replayTimer.LiveElapsedMilliseconds();
 							}
 							else {
-								for (const uint32_t &v : invSketch) {
-									uint16_t s = sketchSizes[v];
-									// Erase from bucket.
-									buckind[buck[s].back()] = buckind[v];
-									swap(buck[s][buckind[v]], buck[s].back());
-									buck[s].pop_back();
-									if (sketchSizes[v] > 1) {
-										buckind[v] = uint32_t(buck[sketchSizes[v] - 1].size());
-										buck[sketchSizes[v] - 1].push_back(v);
-									}
-									--sketchSizes[v];
-								}
+								for (const uint32_t &v : invSketches.List(key))
+									uncount(v);
 							}
-							invSketches.erase(key);
+							eraseSketch(key);
 						}
-
-						FORALL_INCIDENT_ARCS(graph, u, a) {
-							if (!a->Forward()) break;
-							const uint32_t v = a->OtherVertexId();
-							if (Contained<modelType>(u, v, i, l) && !S0.IsContained(v) && !cov[v])
-								S0.Insert(v);
-						}
-					}
+						return DataStructures::Graphs::SCAN_ARCS;
+					});
+					writeBack(static_cast<uint16_t>(i), S0);
+					numSearches.Add(0);
+					numVisited.Add(0, S0.Size());
 				} // end exact influence computation.
 			} // end sequential branch.
 
@@ -377,9 +635,12 @@ public:
 			seedSet.push_back(newSeed);
 			if (verbose) cout << " done (inf: " << newSeed.ExactInfluence << ", ms: " << newSeed.ComputeInfluenceElapsedMilliseconds << ")." << endl;
 			if (verbose) cout << endl;
+			iterationTimings.Add(iterationTimer.LiveElapsedMilliseconds());
+			if (Tools::Introspection::Requested()) Tools::Introspection::Write("SKIM", writeSnapshot);
 
 		} // end greedy iteration.
 		const double totalms = globalTimer.LiveElapsedMilliseconds();
+		Tools::AllocationTracker::SetPhase(setupAllocations);
 
 		// Compute the exact influence? This is not measured in the running time.
 		if (lEval != 0)
@@ -390,16 +651,25 @@ public:
 		*/
 		if (verbose) cout << endl;
 		graph.DumpStatistics(cout);
+		if (vertexWeights != nullptr || targets != nullptr) totalWeight = 0;
+		if (vertexWeights != nullptr || targets != nullptr) FORALL_VERTICES(graph, u) totalWeight += Weight(u);
+		const double spreadBase = vertexWeights == nullptr && targets == nullptr ? static_cast<double>(graph.NumVertices()) : totalWeight;
 		cout << "Random seed: " << randomSeed << "." << endl
 			<< "Number of seed vertices computed: " << seedSet.size() << "." << endl
-			<< "Number of ranks used: " << rank << "." << endl
+			<< "Number of ranks used: " << rank << " (of " << nl << ")." << endl
 			<< "Permutations computed: " << numperm << " (each of size: " << permutation.size() << ")." << endl
 			<< "Building sketches: " << sketchms / 1000.0 << " sec." << endl
 			<< "Computing influence: " << infms / 1000.0 << " sec." << endl
 			<< "Total time: " << totalms / 1000.0 << " sec." << endl
-			<< "Estimated spread of solution: " << estinf << " (" << (100.0*estinf / static_cast<double>(graph.NumVertices())) <<  " %)." << endl
-			<< "Exact spread of solution: " << exinf << " (" << (100.0*exinf / static_cast<double>(graph.NumVertices())) << " %)." << endl
+			<< "Estimated spread of solution: " << estinf << " (" << (100.0*estinf / spreadBase) <<  " %)." << endl
+			<< "Exact spread of solution: " << exinf << " (" << (100.0*exinf / spreadBase) << " %)." << endl
 			<< "Quality gap: " << 100.0 * (1.0 - exinf / estinf) << " %" << endl;
+		if (pipelineLookahead > 0)
+			cout << "Speculative searches: " << numSpeculated << " (" << numSpeculationsUsed << " used)." << endl;
+		cout << "Inverse sketches: " << peakInvSketchBytes / 1024.0 / 1024.0 << " MiB peak." << endl;
+		if (lowMemory)
+			cout << "Replayed inverse sketches: " << numReplays << " (" << replayms / 1000.0 << " sec)." << endl;
+		if (verbose) Tools::AllocationTracker::DumpStatistics(cout);
 
 
 		/*
@@ -418,9 +688,14 @@ public:
 					<< "SketchBuildingElapsedMilliseconds = " << sketchms << endl
 					<< "InfluenceComputationElapsedMilliseconds = " << infms << endl
 					<< "NumberOfRanksUsed = " << rank << endl
+					<< "NumberOfRankVertices = " << numRankVertices << endl
 					<< "NumberOfSeedVertices = " << seedSet.size() << endl
 					<< "RankComputationMethod = " << "shuffle" << endl
-					<< "NumberOfPermutationsComputed = " << numperm << endl;
+					<< "NumberOfPermutationsComputed = " << numperm << endl
+					<< "InverseSketchPeakBytes = " << peakInvSketchBytes << endl
+					<< "NumberOfReplays = " << numReplays << endl
+					<< "ReplayElapsedMilliseconds = " << replayms << endl;
+				Tools::AllocationTracker::WriteStatistics(ss);
 				double sumEstimatedInfluence(0.0), sumExactInfluence(0.0);
 				for (Types::IndexType i = 0; i < seedSet.size(); ++i) {
 					sumEstimatedInfluence += seedSet[i].EstimatedInfluence;
@@ -456,9 +731,18 @@ public:
 				file.WriteString(ss.str());
 			}
 		}
+
+		return seedSet;
 	}
 
 
+	// Evaluates the exact marginal influence of each vertex of a seed sequence (e.g., of a heuristic)
+	// on l instances, the same as the evaluation of Run with lEval = l. Returns the total influence.
+	template<ModelType modelType>
+	inline double EvaluateSeeds(vector<SeedType> &seedSet, const uint16_t l) {
+		return ComputeExactInfluence<modelType>(seedSet, l);
+	}
+
 
 protected:
 
@@ -470,9 +754,10 @@ protected:
 		// seed.
 		if (verbose) cout << "Allocating data structures... " << flush;
 		DataStructures::Container::FastSet<uint32_t> searchSpace(graph.NumVertices());
-		vector<vector<bool>> marked(l);
+		vector<DataStructures::Container::BitVector> marked(l);
 		for (uint16_t i = 0; i < l; ++i)
-			marked[i].resize(graph.NumVertices(), false);
+			marked[i].Resize(graph.NumVertices());
+		const ForwardTraversal forward(graph, forwardHubs);
 		if (verbose) cout << "done." << endl;
 
 		// For each seed vertex, perform a BFS in every instance, and count the sarch space sizes.
@@ -481,22 +766,15 @@ protected:
 		for (SeedType &s : seedSet) {
 			uint64_t size = 0;
 			for (uint16_t i = 0; i < l; ++i) {
-				vector<bool> &m = marked[i];
+				DataStructures::Container::BitVector &m = marked[i];
 				if (m[s.VertexId]) continue;
 				searchSpace.Clear();
 				searchSpace.Insert(s.VertexId);
-				uint64_t cur = 0;
-				while (cur < searchSpace.Size()) {
-					const uint32_t u = searchSpace.KeyByIndex(cur++);
-					m[u] = true;
-					++size;
-					FORALL_INCIDENT_ARCS(graph, u, arc) {
-						if (!arc->Forward()) continue;
-						const uint32_t v = arc->OtherVertexId();
-						if (Contained<modelType>(u, v, i, l) && !m[v] && !searchSpace.IsContained(v))
-							searchSpace.Insert(v);
-					}
-				}
+				forward.Run(searchSpace, m, InstanceCoin<modelType>(*this, i, l), [&](const uint32_t u) {
+					m.Set(u);
+					size += Weight(u);
+					return DataStructures::Graphs::SCAN_ARCS;
+				});
 			}
 			s.ExactInfluence = double(size) / double(l);
 			exinf += s.ExactInfluence;
@@ -571,6 +849,108 @@ protected:
 
 private:
 
+	// A rank drawn in advance, with the (possibly truncated) search space of its reverse BFS.
+	struct UpcomingRank {
+		uint32_t VertexId = NullVertex;
+		uint16_t Instance = 0;
+		bool Speculated = false;
+		uint32_t NumExpanded = 0; // the first this many visited vertices had their arcs scanned.
+		vector<uint32_t> Visited; // in BFS order.
+	};
+
+	// The traversals along the forward arcs (influence) and the backward arcs (sketches).
+	typedef DataStructures::Graphs::Traversal<GraphType, Types::FORWARD_DIRECTION> ForwardTraversal;
+	typedef DataStructures::Graphs::Traversal<GraphType, Types::BACKWARD_DIRECTION> BackwardTraversal;
+
+	// The coin policy of the traversals in instance i (of l): whether the arc is in the instance.
+	template<ModelType modelType>
+	struct InstanceCoin {
+		InstanceCoin(SKIM &s, const uint16_t i, const uint16_t l) : skim(s), Instance(i), NumInstances(l) {}
+		inline bool operator()(const uint32_t tail, const uint32_t head) const {
+			return skim.Contained<modelType>(tail, head, Instance, NumInstances);
+		}
+		SKIM &skim;
+		const uint16_t Instance, NumInstances;
+	};
+
+	// Runs the reverse BFS of an upcoming rank on thread t without pruning, up to the speculation limit.
+	// The search does not enter blocked vertices (the covered ones, and possibly non-candidates).
+	template<ModelType modelType, typename blockedType>
+	inline void Speculate(const int32_t t, UpcomingRank &upcomingRank, const uint16_t l, const blockedType &blocked, DataStructures::Container::FastSet<uint32_t> &S) {
+		S.Clear();
+		if (!blocked[upcomingRank.VertexId])
+			S.Insert(upcomingRank.VertexId);
+		const BackwardTraversal backward(graph, backwardHubs);
+		upcomingRank.NumExpanded = static_cast<uint32_t>(backward.Run(S, blocked, InstanceCoin<modelType>(*this, upcomingRank.Instance, l), [&](const uint32_t u) {
+			if (S.Size() >= maxSpeculativeVertices) return DataStructures::Graphs::STOP_TRAVERSAL;
+			if (profile != nullptr) profile->Visit(t, sketchPhase, u);
+			return DataStructures::Graphs::SCAN_ARCS;
+		}));
+		upcomingRank.Visited = S.ContainedKeys();
+		upcomingRank.Speculated = true;
+	}
+
+	// Replays the reverse BFS of the rank with the inverse sketch key in search space S, passing the vertices
+	// of its inverse sketch to visit in the order they were added (see SetLowMemory).
+	template<ModelType modelType, typename visitType>
+	inline void ReplaySketch(const uint64_t key, const uint16_t l, const DataStructures::Container::FlatMap<uint32_t> &truncated, DataStructures::Container::FastSet<uint32_t> &S, visitType &&visit) {
+		const uint32_t *length = truncated.Find(key);
+		const uint32_t maxVisited = length == nullptr ? UINT32_MAX : *length;
+		uint32_t numVisited = 0;
+		auto replay = [&](const uint32_t u) {
+			visit(u);
+			return ++numVisited == maxVisited ? DataStructures::Graphs::STOP_TRAVERSAL : DataStructures::Graphs::SCAN_ARCS;
+		};
+		S.Clear();
+		S.Insert(static_cast<uint32_t>(key >> 16));
+		const BackwardTraversal backward(graph, backwardHubs);
+		const uint16_t i = static_cast<uint16_t>(key & 0xFFFF);
+		if (candidates == nullptr)
+			backward.Run(S, DataStructures::Graphs::NothingBlocked(), InstanceCoin<modelType>(*this, i, l), replay);
+		else
+			backward.Run(S, Excluded(*candidates), InstanceCoin<modelType>(*this, i, l), replay);
+	}
+
+	// The blocking policy of replayed sketch searches restricted to candidates: not a candidate.
+	struct Excluded {
+		Excluded(const DataStructures::Container::BitVector &cand) : candidates(cand) {}
+		inline bool operator[](const Types::IndexType v) const { return !candidates[v]; }
+		inline uint64_t Word(const Types::IndexType index) const { return ~candidates.Word(index); }
+		const DataStructures::Container::BitVector &candidates;
+	};
+
+	// The blocking policy of the sketch searches restricted to candidates: covered or not a candidate.
+	struct CoveredOrExcluded {
+		CoveredOrExcluded(const DataStructures::Container::BitVector &cov, const DataStructures::Container::BitVector &cand) : covered(cov), candidates(cand) {}
+		inline bool operator[](const Types::IndexType v) const { return covered[v] || !candidates[v]; }
+		inline uint64_t Word(const Types::IndexType index) const { return covered.Word(index) | ~candidates.Word(index); }
+		const DataStructures::Container::BitVector &covered, &candidates;
+	};
+
+	// The weight of vertex u (zero if it is not a target).
+	inline uint32_t Weight(const uint32_t u) const {
+		if (targets != nullptr && !(*targets)[u]) return 0;
+		return vertexWeights == nullptr ? 1 : (*vertexWeights)[u];
+	}
+
+	// Test whether ranks are drawn for vertex u.
+	inline bool IsRankVertex(const uint32_t u) const {
+		return (candidates == nullptr || (*candidates)[u]) && (targets == nullptr || (*targets)[u]);
+	}
+
+	// A speculative search space remains valid as long as none of its vertices got covered, since
+	// coverage only grows and the BFS only depends on the coverage of the vertices it inserts.
+	static inline bool IsUncovered(const vector<uint32_t> &vertices, const DataStructures::Container::BitVector &cov) {
+		for (const uint32_t v : vertices)
+			if (cov[v]) return false;
+		return true;
+	}
+
+	// The key of the inverse sketch of vertex u in instance i.
+	static inline uint64_t InverseSketchKey(const uint32_t u, const uint16_t i) {
+		return (static_cast<uint64_t>(u) << 16) | i;
+	}
+
 	// Indicates whether the algorithm procuces output.
 	bool verbose = true;
 
@@ -592,6 +972,28 @@ private:
 	// The trivalency probabilities.
 	const array<uint32_t, 3> triprob;
 
+	// The bitmaps of hub neighborhoods for scanning forward and backward arcs.
+	DataStructures::Graphs::HubAdjacency<GraphType> forwardHubs, backwardHubs;
+
+	// The number of ranks drawn in advance and the size limit of their speculative search spaces.
+	uint32_t pipelineLookahead = 0;
+	uint32_t maxSpeculativeVertices = 4096;
+
+	// The vertex weights, the candidate seeds and the targets (if any).
+	const vector<uint32_t> *vertexWeights = nullptr;
+	const DataStructures::Container::BitVector *candidates = nullptr;
+	const DataStructures::Container::BitVector *targets = nullptr;
+
+	// The directory of the out-of-core state (empty if it is kept in memory).
+	string stateDirectory;
+
+	// Whether inverse sketches are replayed rather than stored.
+	bool lowMemory = false;
+
+	// The access profile (if any), and its phases.
+	Tools::AccessProfile *profile = nullptr;
+	uint16_t sketchPhase = 0, influencePhase = 0;
+
 	// Random distribution.
 	//uniform_int_distribution<uint32_t> dis;
 
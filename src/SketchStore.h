@@ -0,0 +1,330 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+
+using namespace std;
+
+#include "Assert.h"
+
+namespace DataStructures {
+namespace Container {
+
+// Immutable versions of the per-vertex sketches (ranks and HIP thresholds) for concurrent readers.
+// A reader pins the latest version and may use it until it unpins; it never locks and never touches
+// a reference count. A writer publishes a new version with a single atomic pointer swap. Versions
+// share the sketches (and chunks of 1024 sketch pointers) that did not change, so a small update
+// copies only the changed sketches and their chunks. Replaced parts are reclaimed by the writer
+// once no reader pinned in an epoch before the replacement is left (epoch-based reclamation).
+// A version may map the vertices to slots, so that vertices without a sketch take no space and
+// vertices with identical sketches share one; the sketches are then stored per slot.
+class SketchStore {
+
+public:
+
+	// The number of vertices per chunk of sketch pointers.
+	static const uint32_t ChunkSize = 1024;
+
+	// The sketch of a vertex (its HIP thresholds are empty unless HIP sketches are stored).
+	struct VertexSketch {
+		vector<uint64_t> Ranks;
+		vector<uint64_t> HIPThresholds;
+	};
+
+	// An immutable version of the sketches of the first NumInstances of NumTotalInstances instances.
+	class Version {
+	public:
+		uint64_t Number = 0;
+		uint16_t NumInstances = 0;
+		uint16_t NumTotalInstances = 0;
+
+		inline size_t NumVertices() const { return slots ? slots->size() : numSlots; }
+		inline bool HasHIPThresholds() const { return hasHIPThresholds; }
+		inline const vector<uint64_t> &Sketch(const uint32_t u) const {
+			const VertexSketch *sketch = Get(Slot(u));
+			return sketch == nullptr ? emptyRanks : sketch->Ranks;
+		}
+		inline const vector<uint64_t> &HIPThresholds(const uint32_t u) const {
+			const VertexSketch *sketch = Get(Slot(u));
+			return sketch == nullptr ? emptyRanks : sketch->HIPThresholds;
+		}
+
+	private:
+		friend class SketchStore;
+		struct Chunk {
+			const VertexSketch *Sketches[ChunkSize];
+		};
+
+		// The slot of vertex u (slots beyond the last one are empty).
+		inline uint32_t Slot(const uint32_t u) const {
+			Assert(u < NumVertices());
+			return slots ? (*slots)[u] : u;
+		}
+
+		inline const VertexSketch *Get(const uint32_t slot) const {
+			if (slot >= numSlots) return nullptr;
+			const Chunk *chunk = chunks[slot / ChunkSize];
+			return chunk == nullptr ? nullptr : chunk->Sketches[slot % ChunkSize];
+		}
+
+		size_t numSlots = 0;
+		bool hasHIPThresholds = false;
+		shared_ptr<const vector<uint32_t>> slots; // the slot of each vertex (null: its own id).
+		vector<const Chunk*> chunks; // null chunks and sketches are empty.
+		vector<uint64_t> emptyRanks;
+	};
+
+	// Keeps a version pinned until it goes out of scope.
+	class ReadGuard {
+	public:
+		ReadGuard(ReadGuard &&other) : store(other.store), reader(other.reader), version(other.version) {
+			other.store = nullptr;
+		}
+		~ReadGuard() {
+			if (store != nullptr) store->Unpin(reader);
+		}
+		ReadGuard(const ReadGuard&) = delete;
+		ReadGuard &operator=(const ReadGuard&) = delete;
+
+		// Is a version published at all?
+		inline explicit operator bool() const { return version != nullptr; }
+		inline const Version &operator*() const { return *version; }
+		inline const Version *operator->() const { return version; }
+
+	private:
+		friend class SketchStore;
+		ReadGuard(SketchStore *s, const uint32_t r, const Version *v) : store(s), reader(r), version(v) {}
+
+		SketchStore *store;
+		uint32_t reader;
+		const Version *version;
+	};
+
+	// Construct an empty store for up to the given number of concurrent readers.
+	SketchStore(const uint32_t maxReaders = 64) : readers(new ReaderSlot[maxReaders]), numReaders(maxReaders), current(nullptr), globalEpoch(1), numVersions(0), numCopied(0), numShared(0) {
+		for (uint32_t r = 0; r < numReaders; ++r) readers[r].Epoch = 0;
+	}
+
+	// Frees all versions. No reader may still be pinned.
+	~SketchStore() {
+		for (const Retired &r : retired) Free(r);
+		const Version *v = current.load();
+		if (v == nullptr) return;
+		Retired r;
+		r.OldVersion = v;
+		for (const Version::Chunk *chunk : v->chunks) {
+			if (chunk == nullptr) continue;
+			r.Chunks.push_back(chunk);
+			for (uint32_t j = 0; j < ChunkSize; ++j)
+				if (chunk->Sketches[j] != nullptr) r.Sketches.push_back(chunk->Sketches[j]);
+		}
+		Free(r);
+	}
+
+	// Pins the latest version for reader r (each concurrent reader uses its own id, and pins one
+	// version at a time). The version is null if none has been published yet.
+	inline ReadGuard Pin(const uint32_t r) {
+		Assert(r < numReaders);
+		Assert(readers[r].Epoch.load() == 0);
+		readers[r].Epoch.store(globalEpoch.load());
+		return ReadGuard(this, r, current.load());
+	}
+
+	// Publishes the given sketches (HIP thresholds may be empty) as a new version. Sketches equal to
+	// those of the current version are shared. If slots are given, the sketches are those of the slots,
+	// and vertex u has the sketch of slots[u] (none if it is out of range); otherwise, they are the
+	// sketches of the vertices. Returns the new version, which the writer may use until its next
+	// publication. Writers are serialized.
+	const Version &Publish(const vector<vector<uint64_t>> &ranks, const vector<vector<uint64_t>> &hipThresholds, const uint16_t numInstances, const uint16_t numTotalInstances, const vector<uint32_t> &slots = vector<uint32_t>()) {
+		Assert(hipThresholds.empty() || hipThresholds.size() == ranks.size());
+		lock_guard<mutex> lock(writeMutex);
+		const Version *old = current.load();
+		const bool hip = !hipThresholds.empty();
+		if (old != nullptr && (old->numSlots != ranks.size() || old->hasHIPThresholds != hip)) old = nullptr;
+		Version *v = NewVersion(old, ranks.size(), hip, numInstances, numTotalInstances);
+		if (slots.empty()) v->slots.reset();
+		else if (!v->slots || *v->slots != slots) v->slots = make_shared<const vector<uint32_t>>(slots);
+		Retired r;
+		for (uint32_t u = 0; u < ranks.size(); ++u) {
+			const vector<uint64_t> &thresholds = hip ? hipThresholds[u] : emptyThresholds;
+			const VertexSketch *sketch = v->Get(u);
+			if (sketch == nullptr ? ranks[u].empty() && thresholds.empty() : sketch->Ranks == ranks[u] && sketch->HIPThresholds == thresholds) {
+				if (sketch != nullptr) ++numShared;
+				continue;
+			}
+			Replace(*v, old, u, ranks[u], thresholds, r);
+		}
+		return Commit(v, r, old != nullptr);
+	}
+
+	// Publishes a new version in which only the given vertices have new sketches (copy-on-write).
+	// The sizes must match the current version, which must exist (and have no slots).
+	const Version &Update(const vector<uint32_t> &vertices, const vector<vector<uint64_t>> &ranks, const vector<vector<uint64_t>> &hipThresholds, const uint16_t numInstances, const uint16_t numTotalInstances) {
+		Assert(vertices.size() == ranks.size());
+		Assert(hipThresholds.empty() || hipThresholds.size() == ranks.size());
+		lock_guard<mutex> lock(writeMutex);
+		const Version *old = current.load();
+		Assert(old != nullptr);
+		Assert(!old->slots);
+		Assert(old->hasHIPThresholds == !hipThresholds.empty());
+		Version *v = NewVersion(old, old->numSlots, old->hasHIPThresholds, numInstances, numTotalInstances);
+		Retired r;
+		for (size_t j = 0; j < vertices.size(); ++j)
+			Replace(*v, old, vertices[j], ranks[j], hipThresholds.empty() ? emptyThresholds : hipThresholds[j], r);
+		return Commit(v, r, true);
+	}
+
+	// Frees all replaced parts that no pinned reader can see anymore. Publishing does this as well.
+	inline void Reclaim() {
+		lock_guard<mutex> lock(writeMutex);
+		ReclaimUnlocked();
+	}
+
+	// Statistics: published versions, copied and shared sketches, and parts waiting for reclamation.
+	inline uint64_t NumVersions() const { return numVersions; }
+	inline uint64_t NumCopiedSketches() const { return numCopied; }
+	inline uint64_t NumSharedSketches() const { return numShared; }
+	inline size_t NumRetired() const { return retired.size(); }
+
+private:
+
+	// The epoch a reader is pinned in (zero if it is not), padded to a cache line of its own.
+	struct ReaderSlot {
+		atomic<uint64_t> Epoch;
+		char Padding[64 - sizeof(atomic<uint64_t>)];
+	};
+
+	// The parts replaced by a publication in an epoch.
+	struct Retired {
+		uint64_t Epoch = 0;
+		const Version *OldVersion = nullptr;
+		vector<const Version::Chunk*> Chunks;
+		vector<const VertexSketch*> Sketches;
+	};
+
+	inline void Unpin(const uint32_t r) {
+		readers[r].Epoch.store(0);
+	}
+
+	// Creates a version that shares all chunks (and the slots) of old (if any).
+	inline Version *NewVersion(const Version *old, const size_t n, const bool hip, const uint16_t numInstances, const uint16_t numTotalInstances) {
+		Version *v = new Version();
+		v->Number = ++numVersions;
+		v->NumInstances = numInstances;
+		v->NumTotalInstances = numTotalInstances;
+		v->numSlots = n;
+		v->hasHIPThresholds = hip;
+		if (old != nullptr) v->slots = old->slots;
+		if (old != nullptr) v->chunks = old->chunks;
+		else v->chunks.assign((n + ChunkSize - 1) / ChunkSize, nullptr);
+		return v;
+	}
+
+	// Sets the sketch of u in v, copying its chunk if it is still shared with old.
+	inline void Replace(Version &v, const Version *old, const uint32_t u, const vector<uint64_t> &ranks, const vector<uint64_t> &thresholds, Retired &r) {
+		Assert(u < v.numSlots);
+		const Version::Chunk *&chunk = v.chunks[u / ChunkSize];
+		if (chunk == nullptr || (old != nullptr && chunk == old->chunks[u / ChunkSize])) {
+			Version::Chunk *copy = new Version::Chunk();
+			for (uint32_t j = 0; j < ChunkSize; ++j) copy->Sketches[j] = chunk == nullptr ? nullptr : chunk->Sketches[j];
+			if (chunk != nullptr) r.Chunks.push_back(chunk);
+			chunk = copy;
+		}
+		Version::Chunk *writable = const_cast<Version::Chunk*>(chunk);
+		const VertexSketch *&sketch = writable->Sketches[u % ChunkSize];
+		if (sketch != nullptr && old != nullptr && old->Get(u) == sketch) r.Sketches.push_back(sketch);
+		else delete sketch; // created by this publication.
+		VertexSketch *copy = nullptr;
+		if (!ranks.empty() || !thresholds.empty()) {
+			copy = new VertexSketch();
+			copy->Ranks = ranks;
+			copy->HIPThresholds = thresholds;
+			++numCopied;
+		}
+		sketch = copy;
+	}
+
+	// Swaps in the new version, retires the replaced parts in the current epoch and opens the next.
+	// Unless v was derived from the current version, all parts of the current version are replaced.
+	inline const Version &Commit(Version *v, Retired &r, const bool derived) {
+		r.OldVersion = current.exchange(v);
+		if (r.OldVersion != nullptr && !derived) {
+			r.Chunks.clear();
+			r.Sketches.clear();
+			for (const Version::Chunk *chunk : r.OldVersion->chunks) {
+				if (chunk == nullptr) continue;
+				r.Chunks.push_back(chunk);
+				for (uint32_t j = 0; j < ChunkSize; ++j)
+					if (chunk->Sketches[j] != nullptr) r.Sketches.push_back(chunk->Sketches[j]);
+			}
+		}
+		r.Epoch = globalEpoch.fetch_add(1);
+		retired.push_back(move(r));
+		ReclaimUnlocked();
+		return *v;
+	}
+
+	// Frees the parts retired in an epoch before the oldest epoch a reader is pinned in.
+	inline void ReclaimUnlocked() {
+		uint64_t oldestEpoch = UINT64_MAX;
+		for (uint32_t r = 0; r < numReaders; ++r) {
+			const uint64_t epoch = readers[r].Epoch.load();
+			if (epoch != 0 && epoch < oldestEpoch) oldestEpoch = epoch;
+		}
+		size_t kept = 0;
+		for (size_t j = 0; j < retired.size(); ++j) {
+			if (retired[j].Epoch < oldestEpoch) Free(retired[j]);
+			else retired[kept++] = move(retired[j]);
+		}
+		retired.resize(kept);
+	}
+
+	static inline void Free(const Retired &r) {
+		for (const VertexSketch *sketch : r.Sketches) delete sketch;
+		for (const Version::Chunk *chunk : r.Chunks) delete chunk;
+		delete r.OldVersion;
+	}
+
+	// The reader slots.
+	unique_ptr<ReaderSlot[]> readers;
+	uint32_t numReaders;
+
+	// The latest version.
+	atomic<const Version*> current;
+
+	// The current epoch (starting at one, zero marks readers that are not pinned).
+	atomic<uint64_t> globalEpoch;
+
+	// Serializes writers; readers never take it.
+	mutex writeMutex;
+
+	// The replaced parts waiting for reclamation.
+	vector<Retired> retired;
+
+	// Statistics.
+	uint64_t numVersions, numCopied, numShared;
+
+	// Stands in for missing HIP thresholds.
+	const vector<uint64_t> emptyThresholds;
+};
+
+}
+}
@@ -0,0 +1,279 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+// Merging of sorted lists of 64-bit keys (such as ranks), erasing duplicates.
+// With AVX2, blocks of four keys are merged by a bitonic merge network, and
+// duplicates are removed by compressing the output vectors. Keys (and payloads)
+// must be smaller than 2^63, since AVX2 only compares signed 64-bit integers.
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+#include "BitOperations.h"
+
+namespace Tools {
+
+// This merges the strictly increasing lists a and b into out, keeping one copy of keys in both.
+// Returns the number of keys written. This is the reference implementation.
+inline size_t MergeUniqueScalar(const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb, uint64_t *out) {
+	size_t i(0), j(0), num(0);
+	while (i < na && j < nb) {
+		if (a[i] < b[j]) out[num++] = a[i++];
+		else if (b[j] < a[i]) out[num++] = b[j++];
+		else { out[num++] = a[i++]; ++j; }
+	}
+	while (i < na) out[num++] = a[i++];
+	while (j < nb) out[num++] = b[j++];
+	return num;
+}
+
+// This merges the lists a and b of (key, payload) pairs, which are strictly increasing by key, into out.
+// For keys in both lists, the pair with the larger payload is kept.
+// Returns the number of pairs written. This is the reference implementation.
+inline size_t MergeUniqueMaxPayloadScalar(const pair<uint64_t, uint64_t> *a, const size_t na, const pair<uint64_t, uint64_t> *b, const size_t nb, pair<uint64_t, uint64_t> *out) {
+	size_t i(0), j(0), num(0);
+	while (i < na && j < nb) {
+		if (a[i].first < b[j].first) out[num++] = a[i++];
+		else if (b[j].first < a[i].first) out[num++] = b[j++];
+		else { out[num++] = a[i].second > b[j].second ? a[i] : b[j]; ++i; ++j; }
+	}
+	while (i < na) out[num++] = a[i++];
+	while (j < nb) out[num++] = b[j++];
+	return num;
+}
+
+
+#if defined(__AVX2__)
+namespace SortedMergeDetail {
+
+// The permutations (of 32-bit lanes) moving the kept 64-bit lanes of a 4-bit mask to the front.
+struct CompressTable {
+	CompressTable() {
+		for (uint32_t mask = 0; mask < 16; ++mask) {
+			uint32_t num = 0;
+			for (uint32_t j = 0; j < 4; ++j) {
+				if (!(mask & (1 << j))) continue;
+				lanes[mask][2 * num] = 2 * j;
+				lanes[mask][2 * num + 1] = 2 * j + 1;
+				++num;
+			}
+			for (; num < 4; ++num)
+				lanes[mask][2 * num] = lanes[mask][2 * num + 1] = 0;
+		}
+	}
+	alignas(32) uint32_t lanes[16][8];
+};
+static const CompressTable compressTable;
+
+// Exchanges keys (and payloads) of a and b, such that a holds the lane-wise minima.
+// Of two equal keys, a keeps its own.
+template<bool withPayload>
+inline void MinMax(__m256i &a, __m256i &b, __m256i &pa, __m256i &pb) {
+	const __m256i swap = _mm256_cmpgt_epi64(a, b);
+	const __m256i minimum = _mm256_blendv_epi8(a, b, swap);
+	b = _mm256_blendv_epi8(b, a, swap);
+	a = minimum;
+	if (withPayload) {
+		const __m256i minimumPayload = _mm256_blendv_epi8(pa, pb, swap);
+		pb = _mm256_blendv_epi8(pb, pa, swap);
+		pa = minimumPayload;
+	}
+}
+
+// Sorts the bitonic sequence in a (and carries payloads along), by comparing lanes at distance two, then one.
+template<bool withPayload>
+inline void BitonicSort(__m256i &a, __m256i &pa) {
+	// Distance two: lanes 0,1 take the minima.
+	__m256i t = _mm256_permute4x64_epi64(a, 0x4E);
+	__m256i lower = _mm256_cmpgt_epi64(a, t);
+	__m256i upper = _mm256_cmpgt_epi64(t, a);
+	__m256i take = _mm256_blend_epi32(lower, upper, 0xF0);
+	if (withPayload) pa = _mm256_blendv_epi8(pa, _mm256_permute4x64_epi64(pa, 0x4E), take);
+	a = _mm256_blendv_epi8(a, t, take);
+
+	// Distance one: lanes 0,2 take the minima.
+	t = _mm256_permute4x64_epi64(a, 0xB1);
+	lower = _mm256_cmpgt_epi64(a, t);
+	upper = _mm256_cmpgt_epi64(t, a);
+	take = _mm256_blend_epi32(lower, upper, 0xCC);
+	if (withPayload) pa = _mm256_blendv_epi8(pa, _mm256_permute4x64_epi64(pa, 0xB1), take);
+	a = _mm256_blendv_epi8(a, t, take);
+}
+
+// Merges the sorted vectors a and b, such that a holds the four smallest and b the four largest keys.
+template<bool withPayload>
+inline void BitonicMerge(__m256i &a, __m256i &b, __m256i &pa, __m256i &pb) {
+	b = _mm256_permute4x64_epi64(b, 0x1B);
+	if (withPayload) pb = _mm256_permute4x64_epi64(pb, 0x1B);
+	MinMax<withPayload>(a, b, pa, pb);
+	BitonicSort<withPayload>(a, pa);
+	BitonicSort<withPayload>(b, pb);
+}
+
+// Loads four keys (and payloads) of a list.
+template<bool withPayload>
+inline void Load(const uint64_t *keys, __m256i &k, __m256i &p);
+
+template<>
+inline void Load<false>(const uint64_t *keys, __m256i &k, __m256i &) {
+	k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+}
+
+template<>
+inline void Load<true>(const uint64_t *pairs, __m256i &k, __m256i &p) {
+	const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pairs));
+	const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pairs + 4));
+	k = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(first, second), 0xD8);
+	p = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(first, second), 0xD8);
+}
+
+// Appends the sorted keys (and payloads) in k to out, which already holds num elements, and returns
+// the new number of elements. Since each key occurs at most twice, the earlier copy of a duplicate is
+// dropped and the later one keeps the larger payload. The last element written so far is broadcast in
+// lastK (and lastP), which avoids reading it back. This writes four elements.
+template<bool withPayload>
+inline size_t Emit(__m256i k, __m256i p, __m256i &lastK, __m256i &lastP, uint64_t *out, size_t num) {
+	const __m256i previous = _mm256_blend_epi32(_mm256_permute4x64_epi64(k, 0x93), lastK, 0x03);
+	const __m256i duplicate = _mm256_cmpeq_epi64(k, previous);
+	const uint32_t equal = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(duplicate)));
+	if (withPayload && equal != 0) {
+		const __m256i previousPayload = _mm256_blend_epi32(_mm256_permute4x64_epi64(p, 0x93), lastP, 0x03);
+		p = _mm256_blendv_epi8(p, previousPayload, _mm256_and_si256(duplicate, _mm256_cmpgt_epi64(previousPayload, p)));
+	}
+
+	// The last element is always kept.
+	lastK = _mm256_permute4x64_epi64(k, 0xFF);
+	if (withPayload) lastP = _mm256_permute4x64_epi64(p, 0xFF);
+
+	// Drop the element before each duplicate, possibly the last one written so far.
+	if (equal & 1) --num;
+	const uint32_t keep = ~(equal >> 1) & 0xF;
+	const __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(compressTable.lanes[keep]));
+	k = _mm256_permutevar8x32_epi32(k, lanes);
+	if (withPayload) {
+		p = _mm256_permutevar8x32_epi32(p, lanes);
+		k = _mm256_permute4x64_epi64(k, 0xD8);
+		p = _mm256_permute4x64_epi64(p, 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + num * 2), _mm256_unpacklo_epi64(k, p));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + num * 2 + 4), _mm256_unpackhi_epi64(k, p));
+	}
+	else {
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + num), k);
+	}
+	return num + PopCount(keep);
+}
+
+// Appends a key (and payload) to out, which already holds num elements, erasing duplicates.
+template<bool withPayload>
+inline size_t EmitScalar(const uint64_t *element, uint64_t *out, size_t num) {
+	const size_t stride = withPayload ? 2 : 1;
+	if (num > 0 && out[(num - 1) * stride] == element[0]) {
+		if (withPayload) out[(num - 1) * stride + 1] = max(out[(num - 1) * stride + 1], element[1]);
+		return num;
+	}
+	out[num * stride] = element[0];
+	if (withPayload) out[num * stride + 1] = element[1];
+	return num + 1;
+}
+
+// Merges the lists a and b (of keys, or of interleaved keys and payloads) into out. Blocks of four
+// elements are merged as long as the list with the smaller next key has four elements left; the
+// remainder is merged by scalar code.
+template<bool withPayload>
+inline size_t MergeUnique(const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb, uint64_t *out) {
+	const size_t stride = withPayload ? 2 : 1;
+	size_t i(0), j(0), num(0);
+	alignas(32) uint64_t rest[8]; // the four largest elements of the last merge.
+	size_t numRest(0);
+	if (na >= 4 && nb >= 4) {
+		__m256i ka, pa, kb, pb;
+		__m256i lastK = _mm256_set1_epi64x(-1), lastP = _mm256_setzero_si256(); // no key is 2^64-1.
+		Load<withPayload>(a, ka, pa);
+		Load<withPayload>(b, kb, pb);
+		i = j = 4;
+		while (true) {
+			BitonicMerge<withPayload>(ka, kb, pa, pb);
+			num = Emit<withPayload>(ka, pa, lastK, lastP, out, num);
+			ka = kb;
+			pa = pb;
+
+			// Continue with the next block of the list with the smaller next key.
+			const bool fromA = i < na && (j >= nb || a[i * stride] <= b[j * stride]);
+			if (fromA ? i + 4 > na : j + 4 > nb) break;
+			if (fromA) { Load<withPayload>(a + i * stride, kb, pb); i += 4; }
+			else { Load<withPayload>(b + j * stride, kb, pb); j += 4; }
+		}
+		if (withPayload) {
+			ka = _mm256_permute4x64_epi64(ka, 0xD8);
+			pa = _mm256_permute4x64_epi64(pa, 0xD8);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rest), _mm256_unpacklo_epi64(ka, pa));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rest + 4), _mm256_unpackhi_epi64(ka, pa));
+		}
+		else {
+			_mm256_store_si256(reinterpret_cast<__m256i*>(rest), ka);
+		}
+		numRest = 4;
+	}
+
+	// Merge the remaining elements of the three lists.
+	size_t r(0);
+	while (r < numRest || i < na || j < nb) {
+		const uint64_t *next = nullptr;
+		if (r < numRest) next = rest + r * stride;
+		if (i < na && (next == nullptr || a[i * stride] < next[0])) next = a + i * stride;
+		if (j < nb && (next == nullptr || b[j * stride] < next[0])) next = b + j * stride;
+		if (next == rest + r * stride) ++r;
+		else if (next == a + i * stride) ++i;
+		else ++j;
+		num = EmitScalar<withPayload>(next, out, num);
+	}
+	return num;
+}
+
+}
+#endif
+
+
+// This merges the strictly increasing lists a and b into out, keeping one copy of keys in both.
+// Returns the number of keys written; out must have room for na + nb + 3 keys.
+inline size_t MergeUnique(const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb, uint64_t *out) {
+#if defined(__AVX2__)
+	return SortedMergeDetail::MergeUnique<false>(a, na, b, nb, out);
+#else
+	return MergeUniqueScalar(a, na, b, nb, out);
+#endif
+}
+
+// This merges the lists a and b of (key, payload) pairs, which are strictly increasing by key, into out.
+// For keys in both lists, the pair with the larger payload is kept.
+// Returns the number of pairs written; out must have room for na + nb + 3 pairs.
+inline size_t MergeUniqueMaxPayload(const pair<uint64_t, uint64_t> *a, const size_t na, const pair<uint64_t, uint64_t> *b, const size_t nb, pair<uint64_t, uint64_t> *out) {
+	static_assert(sizeof(pair<uint64_t, uint64_t>) == 2 * sizeof(uint64_t), "pairs must be two consecutive keys");
+#if defined(__AVX2__)
+	return SortedMergeDetail::MergeUnique<true>(reinterpret_cast<const uint64_t*>(a), na, reinterpret_cast<const uint64_t*>(b), nb, reinterpret_cast<uint64_t*>(out));
+#else
+	return MergeUniqueMaxPayloadScalar(a, na, b, nb, out);
+#endif
+}
+
+}
@@ -0,0 +1,139 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <cstdint>
+using namespace std;
+
+#include "Assert.h"
+#include "Types.h"
+#include "Macros.h"
+#include "BitOperations.h"
+#include "HubAdjacency.h"
+
+namespace DataStructures {
+namespace Graphs {
+
+// What a traversal does with a vertex that it takes from its queue.
+enum TraversalAction {
+	SCAN_ARCS, // insert the neighbors reached by its arcs.
+	SKIP_ARCS, // prune it.
+	STOP_TRAVERSAL // end the traversal (without scanning the vertex).
+};
+
+// The blocking policy of a traversal that may enter every vertex. A blocking policy tells which
+// vertices a traversal must not enter besides the visited ones, by operator[] and by words of 64
+// vertices (for hubs); a BitVector (e.g., of covered vertices) is one as well.
+struct NothingBlocked {
+	inline bool operator[](const Types::IndexType) const { return false; }
+	inline uint64_t Word(const Types::IndexType) const { return 0; }
+};
+
+// The coin policy of a traversal that follows every arc.
+struct AllArcs {
+	inline bool operator()(const uint32_t, const uint32_t) const { return true; }
+};
+
+// A breadth-first traversal along the arcs of one direction (forward arcs from tail to head, or
+// backward arcs from head to tail), whose queue is a search space such as a FastSet: it holds the
+// vertices in insertion order, and is both the queue and the visited set. The policies are template
+// parameters, so each use compiles to the hand-written loop:
+// - blocked: the vertices not to enter (see NothingBlocked),
+// - coin(tail, head): whether the arc from tail to head is in the sampled instance; it must not have
+//   side effects, since it is flipped before the (cache missing) tests of the visited and blocked
+//   flags of the other vertex, which it mostly saves,
+// - visit(u): called once for each vertex taken from the queue, returns a TraversalAction.
+// The arcs of hubs are scanned word by word on their bitmaps, in the same order.
+template<typename graphType, Types::Direction direction>
+class Traversal {
+public:
+
+	// A traversal of graph that scans hubs on the bitmaps (which must be of the same direction).
+	Traversal(graphType &g, const HubAdjacency<graphType> &h) : graph(g), hubs(h) {}
+
+	// Runs the traversal on the vertices of the search space S (the sources must be inserted).
+	// The first numScanned vertices of S are visited, but not scanned: this resumes a traversal that
+	// was interrupted after scanning them. Returns the number of vertices that were visited without
+	// stopping, i.e., the index of the stopping vertex, or the size of S if the traversal completed.
+	template<typename searchSpaceType, typename blockedType, typename coinType, typename visitType>
+	inline Types::IndexType Run(searchSpaceType &S, const blockedType &blocked, coinType &&coin, visitType &&visit, const Types::IndexType numScanned = 0) const {
+		Types::IndexType ind = 0;
+		while (ind < S.Size()) {
+			const uint32_t u = S.KeyByIndex(ind);
+			const TraversalAction action = visit(u);
+			if (action == STOP_TRAVERSAL) return ind;
+			++ind;
+			if (action == SCAN_ARCS && ind > numScanned)
+				Scan(u, S, blocked, coin);
+		}
+		return ind;
+	}
+
+	// Inserts the unvisited, unblocked neighbors of u whose arcs pass the coin into S.
+	template<typename searchSpaceType, typename blockedType, typename coinType>
+	inline void Scan(const uint32_t u, searchSpaceType &S, const blockedType &blocked, coinType &coin) const {
+		if (hubs.IsHub(u)) {
+			// Hubs exclude visited and blocked neighbors word by word.
+			if (direction == Types::FORWARD_DIRECTION) {
+				for (auto block = hubs.BeginBlock(u); block != hubs.EndBlock(u); ++block) {
+					for (uint64_t candidates = block->Mask & ~blocked.Word(block->Index) & ~S.ContainedWord(block->Index); candidates != 0; candidates &= candidates - 1) {
+						const uint32_t v = block->Index * 64 + Tools::LowestSetBit(candidates);
+						if (coin(u, v))
+							S.Insert(v);
+					}
+				}
+			}
+			else {
+				for (auto block = hubs.EndBlock(u); block-- != hubs.BeginBlock(u);) {
+					for (uint64_t candidates = block->Mask & ~blocked.Word(block->Index) & ~S.ContainedWord(block->Index); candidates != 0;) {
+						const uint32_t bit = Tools::HighestSetBit(candidates);
+						candidates ^= uint64_t(1) << bit;
+						const uint32_t v = block->Index * 64 + bit;
+						if (coin(v, u))
+							S.Insert(v);
+					}
+				}
+			}
+		}
+		else if (direction == Types::FORWARD_DIRECTION) {
+			FORALL_INCIDENT_ARCS(graph, u, a) {
+				if (!a->Forward()) break;
+				const uint32_t v = a->OtherVertexId();
+				if (coin(u, v) && !S.IsContained(v) && !blocked[v])
+					S.Insert(v);
+			}
+		}
+		else {
+			FORALL_INCIDENT_ARCS_BACKWARD(graph, u, a) {
+				if (!a->Backward()) break;
+				const uint32_t v = a->OtherVertexId();
+				if (coin(v, u) && !S.IsContained(v) && !blocked[v])
+					S.Insert(v);
+			}
+		}
+	}
+
+private:
+
+	// The graph.
+	graphType &graph;
+
+	// The bitmaps of the hubs.
+	const HubAdjacency<graphType> &hubs;
+};
+
+}
+}
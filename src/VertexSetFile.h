@@ -0,0 +1,65 @@
+/*
+Algorithm for Influence Estimation and Maximization
+
+Copyright (c) Microsoft Corporation
+
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the ""Software""), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+#include "FileStream.h"
+#include "Split.h"
+#include "Conversion.h"
+#include "BitVector.h"
+
+namespace IO {
+
+// Reads a set of vertex ids from a file (separated by commas or line breaks) into flags over the
+// numVertices vertices and the list of the ids (in file order, without duplicates). Returns false
+// (after an error message) if the file cannot be read, has an invalid id, or has no ids.
+inline bool ReadVertexSet(const string filename, const Types::SizeType numVertices, DataStructures::Container::BitVector &flags, vector<uint32_t> &ids) {
+	FileStream file;
+	file.OpenForReading(filename);
+	if (!file.IsOpen()) {
+		cerr << "ERROR: Could not open vertex file '" << filename << "'." << endl;
+		return false;
+	}
+	flags = DataStructures::Container::BitVector(numVertices);
+	ids.clear();
+	string line;
+	while (!file.Finished()) {
+		file.ExtractLine(line);
+		for (const string &token : Tools::Split(line, ',')) {
+			if (token.empty()) continue;
+			const uint32_t u = Tools::LexicalCast<uint32_t>(token);
+			if (u >= numVertices) {
+				cerr << "ERROR: Vertex " << u << " in '" << filename << "' is not a vertex of the graph." << endl;
+				return false;
+			}
+			if (flags[u]) continue;
+			flags.Set(u);
+			ids.push_back(u);
+		}
+	}
+	if (ids.empty()) {
+		cerr << "ERROR: The vertex file '" << filename << "' has no vertex ids." << endl;
+		return false;
+	}
+	return true;
+}
+
+}